@@ -0,0 +1,357 @@
+"""
+Skirmish ESP32 Firmware
+
+SKVEC compiler
+
+Rasterizes the SKVEC graphics of src/fonts/skvec.h at build time and
+writes them to src/fonts/skvec_runs.h as runs: rectangles made of the same
+horizontal span in consecutive rows. The firmware draws every run with a
+single address window (see SkirmishDisplay::drawRuns()) instead of
+interpreting the shapes with drawLine(), fillRect() and fillTriangle().
+Runs as a PlatformIO pre script before every build, can also be run
+directly:
+
+    python scripts/compile_skvec.py
+
+The shapes are rasterized with ports of the Adafruit_GFX algorithms
+drawVec() ends up in. The runs are checked pixel for pixel against them.
+
+Copyright (C) 2023 Ole Lange
+"""
+
+import os
+import re
+import sys
+
+LINE = 0
+RECT = 1
+TRIANGLE = 2
+FILL = 0x80
+END = 0xff
+
+
+def cdiv(a, b):
+    """Integer division truncating towards zero, like C"""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b >= 0) else -q
+
+
+class Raster:
+    """Set of pixels, drawn with the algorithms of Adafruit_GFX"""
+
+    def __init__(self):
+        self.pixels = set()
+
+    def pixel(self, x, y):
+        self.pixels.add((x, y))
+
+    def hline(self, x, y, w):
+        if w < 0:
+            x += w + 1
+            w = -w
+        for i in range(x, x + w):
+            self.pixel(i, y)
+
+    def vline(self, x, y, h):
+        if h < 0:
+            y += h + 1
+            h = -h
+        for i in range(y, y + h):
+            self.pixel(x, i)
+
+    def fill_rect(self, x, y, w, h):
+        if h < 0:
+            y += h + 1
+            h = -h
+        for i in range(y, y + h):
+            self.hline(x, i, w)
+
+    def draw_rect(self, x, y, w, h):
+        self.hline(x, y, w)
+        self.hline(x, y + h - 1, w)
+        self.vline(x, y, h)
+        self.vline(x + w - 1, y, h)
+
+    def line(self, x0, y0, x1, y1):
+        if x0 == x1:
+            if y0 > y1:
+                y0, y1 = y1, y0
+            self.vline(x0, y0, y1 - y0 + 1)
+            return
+        if y0 == y1:
+            if x0 > x1:
+                x0, x1 = x1, x0
+            self.hline(x0, y0, x1 - x0 + 1)
+            return
+
+        # Bresenham, Adafruit_GFX::writeLine()
+        steep = abs(y1 - y0) > abs(x1 - x0)
+        if steep:
+            x0, y0 = y0, x0
+            x1, y1 = y1, x1
+        if x0 > x1:
+            x0, x1 = x1, x0
+            y0, y1 = y1, y0
+        dx = x1 - x0
+        dy = abs(y1 - y0)
+        err = dx // 2
+        ystep = 1 if y0 < y1 else -1
+        while x0 <= x1:
+            if steep:
+                self.pixel(y0, x0)
+            else:
+                self.pixel(x0, y0)
+            err -= dy
+            if err < 0:
+                y0 += ystep
+                err += dx
+            x0 += 1
+
+    def draw_triangle(self, x0, y0, x1, y1, x2, y2):
+        self.line(x0, y0, x1, y1)
+        self.line(x1, y1, x2, y2)
+        self.line(x2, y2, x0, y0)
+
+    def fill_triangle(self, x0, y0, x1, y1, x2, y2):
+        # Adafruit_GFX::fillTriangle(), sorted by y (y2 >= y1 >= y0)
+        if y0 > y1:
+            y0, y1, x0, x1 = y1, y0, x1, x0
+        if y1 > y2:
+            y1, y2, x1, x2 = y2, y1, x2, x1
+        if y0 > y1:
+            y0, y1, x0, x1 = y1, y0, x1, x0
+
+        if y0 == y2:
+            a = b = x0
+            if x1 < a:
+                a = x1
+            elif x1 > b:
+                b = x1
+            if x2 < a:
+                a = x2
+            elif x2 > b:
+                b = x2
+            self.hline(a, y0, b - a + 1)
+            return
+
+        dx01, dy01 = x1 - x0, y1 - y0
+        dx02, dy02 = x2 - x0, y2 - y0
+        dx12, dy12 = x2 - x1, y2 - y1
+        sa = sb = 0
+
+        last = y1 if y1 == y2 else y1 - 1
+        y = y0
+        while y <= last:
+            a = x0 + cdiv(sa, dy01)
+            b = x0 + cdiv(sb, dy02)
+            sa += dx01
+            sb += dx02
+            if a > b:
+                a, b = b, a
+            self.hline(a, y, b - a + 1)
+            y += 1
+
+        sa = dx12 * (y - y1)
+        sb = dx02 * (y - y0)
+        while y <= y2:
+            a = x1 + cdiv(sa, dy12)
+            b = x0 + cdiv(sb, dy02)
+            sa += dx12
+            sb += dx02
+            if a > b:
+                a, b = b, a
+            self.hline(a, y, b - a + 1)
+            y += 1
+
+
+def parse(path):
+    """Returns a list of (name, bytes) of all graphics in a skvec header"""
+    with open(path) as f:
+        source = f.read()
+    source = re.sub(r"/\*.*?\*/", "", source, flags=re.S)
+    source = re.sub(r"//[^\n]*", "", source)
+
+    # The macros of skvec.h
+    scope = {
+        "X": lambda x: x,
+        "W": lambda x: x,
+        "Y": lambda y: ((y >> 8) & 0xff, y & 0xff),
+        "H": lambda y: ((y >> 8) & 0xff, y & 0xff),
+        "FILL": lambda shape: shape | FILL,
+        "LINE": LINE,
+        "RECT": RECT,
+        "TRIANGLE": TRIANGLE,
+    }
+
+    graphics = []
+    for match in re.finditer(
+            r"const\s+uint8_t\s+skvec_(\w+)\[\]\s*=\s*\{(.*?)\};", source,
+            re.S):
+        values = eval("[%s]" % match.group(2), {}, scope)
+        data = []
+        for value in values:
+            data += list(value) if isinstance(value, tuple) else [value]
+        graphics.append((match.group(1), data))
+    return graphics
+
+
+def interpret(data):
+    """Draws a graphic like SkirmishDisplay::drawVec() at 0, 0"""
+    raster = Raster()
+    shapes = 0
+    idx = 0
+    while True:
+        shape = data[idx]
+        idx += 1
+        if shape == END:
+            break
+        x0 = data[idx]
+        y0 = (data[idx + 1] << 8) | data[idx + 2]
+        x1 = data[idx + 3]
+        y1 = (data[idx + 4] << 8) | data[idx + 5]
+        idx += 6
+        x2 = y2 = 0
+        if shape & 0x7f == TRIANGLE:
+            x2 = data[idx]
+            y2 = (data[idx + 1] << 8) | data[idx + 2]
+            idx += 3
+
+        kind = shape & 0x7f
+        filled = shape & FILL
+        if kind == LINE:
+            raster.line(x0, y0, x1, y1)
+        elif kind == RECT and filled:
+            raster.fill_rect(x0, y0, x1, y1)
+        elif kind == RECT:
+            raster.draw_rect(x0, y0, x1, y1)
+        elif kind == TRIANGLE and filled:
+            raster.fill_triangle(x0, y0, x1, y1, x2, y2)
+        elif kind == TRIANGLE:
+            raster.draw_triangle(x0, y0, x1, y1, x2, y2)
+        else:
+            raise ValueError("unknown shape 0x%02x" % shape)
+        shapes += 1
+    return raster.pixels, shapes
+
+
+def compile_runs(pixels):
+    """Returns the runs (x, y, w, h) covering exactly the given pixels,
+    sorted by their first row"""
+    rows = {}
+    for x, y in pixels:
+        rows.setdefault(y, []).append(x)
+
+    runs = []
+    open_runs = {}  # (x, w) -> index in runs
+    for y in sorted(rows):
+        spans = []
+        xs = sorted(rows[y])
+        start = xs[0]
+        for prev, x in zip(xs, xs[1:] + [None]):
+            if x != prev + 1:
+                spans.append((start, prev - start + 1))
+                start = x
+
+        # Spans continue the runs of the row above if they are identical
+        continued = {}
+        for span in spans:
+            index = open_runs.get(span)
+            if index is not None and runs[index][1] + runs[index][3] == y:
+                x, run_y, w, h = runs[index]
+                runs[index] = (x, run_y, w, h + 1)
+            else:
+                runs.append((span[0], y, span[1], 1))
+                index = len(runs) - 1
+            continued[span] = index
+        open_runs = continued
+    return runs
+
+
+def verify(name, pixels, runs):
+    drawn = set()
+    for x, y, w, h in runs:
+        for row in range(y, y + h):
+            for col in range(x, x + w):
+                assert (col, row) not in drawn, \
+                    "skvec_%s: runs overlap at %d, %d" % (name, col, row)
+                drawn.add((col, row))
+    assert drawn == pixels, "skvec_%s: runs don't match the shapes" % name
+    assert all(0 <= x and x + w <= 256 and 0 <= y for x, y, w, _ in runs), \
+        "skvec_%s: runs out of range" % name
+
+
+def write_header(graphics, header_path):
+    lines = [
+        "/*",
+        "Skirmish ESP32 Firmware",
+        "",
+        "SKVEC runs - generated by scripts/compile_skvec.py from skvec.h, do",
+        "not edit",
+        "",
+        "Every graphic as runs (rectangles made of the same horizontal span in",
+        "consecutive rows) sorted by their first row, drawn with",
+        "SkirmishDisplay::drawRuns().",
+        "*/",
+        "",
+        "#pragma once",
+        "",
+        "#include <stdint.h>",
+        "",
+        "typedef struct SkvecRun {",
+        "    uint8_t x, w;",
+        "    uint16_t y, h;",
+        "} SkvecRun;",
+        "",
+        "typedef struct SkvecRuns {",
+        "    const SkvecRun *runs;",
+        "    uint16_t count;",
+        "    uint16_t top, bottom;  // First and last row",
+        "} SkvecRuns;",
+    ]
+    for name, shapes, runs in graphics:
+        top = min(y for _, y, _, _ in runs)
+        bottom = max(y + h - 1 for _, y, _, h in runs)
+        lines += [
+            "",
+            "// skvec_%s: %d shapes, %d runs" % (name, shapes, len(runs)),
+            "const SkvecRun skvecRunData_%s[] = {" % name,
+        ]
+        lines += ["    {%d, %d, %d, %d}," % (x, w, y, h) for x, y, w, h in runs]
+        lines += [
+            "};",
+            "const SkvecRuns skvecRuns_%s = {" % name,
+            "    skvecRunData_%s, %d, %d, %d};" % (name, len(runs), top, bottom),
+        ]
+    lines.append("")
+    content = "\n".join(lines)
+
+    if os.path.exists(header_path):
+        with open(header_path) as f:
+            if f.read() == content:
+                return
+    with open(header_path, "w") as f:
+        f.write(content)
+
+
+def compile_all(project_dir):
+    fonts_dir = os.path.join(project_dir, "src", "fonts")
+
+    graphics = []
+    for name, data in parse(os.path.join(fonts_dir, "skvec.h")):
+        pixels, shapes = interpret(data)
+        runs = compile_runs(pixels)
+        verify(name, pixels, runs)
+        graphics.append((name, shapes, runs))
+        print("compile_skvec: %-18s %2d shapes -> %3d runs (%d pixels)" %
+              (name, shapes, len(runs), len(pixels)))
+
+    write_header(graphics, os.path.join(fonts_dir, "skvec_runs.h"))
+
+
+try:
+    Import("env")  # noqa: F821 (provided by PlatformIO)
+    compile_all(env["PROJECT_DIR"])  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        compile_all(os.path.dirname(os.path.dirname(os.path.abspath(
+            sys.argv[0]))))
@@ -0,0 +1,32 @@
+"""
+Skirmish ESP32 Firmware
+
+Emulator build script
+
+PlatformIO pre script of the emulator environment (see platformio.ini).
+Adafruit GFX is built for the host without the drivers of real displays,
+they need the Arduino SPI and I2C libraries. The emulated panel replaces
+them (see src/emulator/panel.h).
+
+Copyright (C) 2023 Ole Lange
+"""
+
+# Sources of Adafruit GFX that are left out
+SKIPPED = [
+    "*/Adafruit_SPITFT.cpp",
+    "*/Adafruit_GrayOLED.cpp",
+    "*/fontconvert/*",
+]
+
+
+def skip(node):
+    return None
+
+
+try:
+    Import("env")  # noqa: F821 (provided by PlatformIO)
+    for pattern in SKIPPED:
+        env.AddBuildMiddleware(skip, pattern)  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        print("emulator.py is a PlatformIO script, run: pio run -e emulator")
@@ -0,0 +1,184 @@
+"""
+Skirmish ESP32 Firmware
+
+Audio asset encoder
+
+Converts PCM WAV files to IMA-ADPCM WAV files. Used by pack_assets.py
+for the files in assets/sounds/, but can also be run directly:
+
+    python scripts/encode_audio.py <source dir> <destination dir>
+
+Files are only re-encoded if the source is newer than the output. The
+compression ratio of every file is checked against the ratio IMA-ADPCM
+should reach for its bit depth.
+
+Copyright (C) 2023 Ole Lange
+"""
+
+import os
+import struct
+import sys
+import wave
+
+# Bytes per channel in one ADPCM block, must match ADPCM_MAX_BLOCK_ALIGN
+# in src/inc/adpcm.h (block align = BLOCK_BYTES_PER_CHANNEL * channels)
+BLOCK_BYTES_PER_CHANNEL = 256
+
+# Allowed overhead on top of the ideal ratio (block headers, padding)
+RATIO_TOLERANCE = 0.9
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190,
+    209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724,
+    796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272,
+    2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132,
+    7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500,
+    20350, 22385, 24623, 27086, 29794, 32767]
+
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def clamp(value, low, high):
+    return max(low, min(high, value))
+
+
+class ChannelEncoder:
+    """IMA-ADPCM encoder state of one channel"""
+
+    def __init__(self):
+        self.predictor = 0
+        self.index = 0
+
+    def encode(self, sample):
+        step = STEP_TABLE[self.index]
+        diff = sample - self.predictor
+        nibble = 0
+        if diff < 0:
+            nibble = 8
+            diff = -diff
+
+        # Same successive approximation as the decoder, so the
+        # predictor never drifts away from the decoded signal
+        vpdiff = step >> 3
+        if diff >= step:
+            nibble |= 4
+            diff -= step
+            vpdiff += step
+        step >>= 1
+        if diff >= step:
+            nibble |= 2
+            diff -= step
+            vpdiff += step
+        step >>= 1
+        if diff >= step:
+            nibble |= 1
+            vpdiff += step
+
+        if nibble & 8:
+            self.predictor -= vpdiff
+        else:
+            self.predictor += vpdiff
+        self.predictor = clamp(self.predictor, -32768, 32767)
+        self.index = clamp(self.index + INDEX_TABLE[nibble], 0, 88)
+
+        return nibble
+
+
+def read_pcm(path):
+    """Reads a PCM WAV file and returns (channels, rate, frames) with
+    frames being a list of tuples of signed 16 bit samples"""
+    with wave.open(path, "rb") as w:
+        channels = w.getnchannels()
+        width = w.getsampwidth()
+        rate = w.getframerate()
+        raw = w.readframes(w.getnframes())
+
+    if width == 1:
+        samples = [(b - 128) << 8 for b in raw]
+    elif width == 2:
+        samples = list(struct.unpack("<%dh" % (len(raw) // 2), raw))
+    else:
+        raise ValueError("%s: unsupported sample width %d" % (path, width))
+
+    frames = [tuple(samples[i:i + channels])
+              for i in range(0, len(samples), channels)]
+    return channels, rate, width * 8, frames
+
+
+def encode_block(encoders, frames, channels):
+    """Encodes one block. The first frame is stored in the block header,
+    the others as interleaved 4 byte (8 sample) chunks per channel."""
+    out = bytearray()
+    for c in range(channels):
+        encoders[c].predictor = frames[0][c]
+        out += struct.pack("<hBB", frames[0][c], encoders[c].index, 0)
+
+    for chunk in range(1, len(frames), 8):
+        for c in range(channels):
+            nibbles = [encoders[c].encode(f[c]) for f in frames[chunk:chunk + 8]]
+            for i in range(0, 8, 2):
+                out.append(nibbles[i] | (nibbles[i + 1] << 4))
+    return out
+
+
+def encode(src, dst):
+    channels, rate, bits, frames = read_pcm(src)
+
+    block_align = BLOCK_BYTES_PER_CHANNEL * channels
+    samples_per_block = (block_align - 4 * channels) * 2 // channels + 1
+    frame_count = len(frames)
+
+    data = bytearray()
+    encoders = [ChannelEncoder() for _ in range(channels)]
+    for start in range(0, frame_count, samples_per_block):
+        block = frames[start:start + samples_per_block]
+        # Pad the last block with its last frame, the decoder stops
+        # after the amount of frames stored in the fact chunk
+        block += [block[-1]] * (samples_per_block - len(block))
+        data += encode_block(encoders, block, channels)
+
+    byte_rate = rate * block_align // samples_per_block
+    fmt = struct.pack("<HHIIHHHH", 0x11, channels, rate, byte_rate,
+                      block_align, 4, 2, samples_per_block)
+    fact = struct.pack("<I", frame_count)
+
+    body = b"WAVE"
+    body += b"fmt " + struct.pack("<I", len(fmt)) + fmt
+    body += b"fact" + struct.pack("<I", len(fact)) + fact
+    body += b"data" + struct.pack("<I", len(data)) + bytes(data)
+
+    with open(dst, "wb") as f:
+        f.write(b"RIFF" + struct.pack("<I", len(body)) + body)
+
+    return bits
+
+
+def check_ratio(src, dst, bits):
+    ratio = os.path.getsize(src) / os.path.getsize(dst)
+    expected = bits / 4.0 * RATIO_TOLERANCE
+    print("encode_audio: %-12s %7d -> %6d bytes (%.2f:1)" %
+          (os.path.basename(src), os.path.getsize(src),
+           os.path.getsize(dst), ratio))
+    if ratio < expected:
+        raise RuntimeError("%s: compression ratio %.2f is below %.2f" %
+                           (dst, ratio, expected))
+
+
+def encode_all(src_dir, dst_dir):
+    os.makedirs(dst_dir, exist_ok=True)
+
+    for name in sorted(os.listdir(src_dir)):
+        if not name.endswith(".wav"):
+            continue
+        src = os.path.join(src_dir, name)
+        dst = os.path.join(dst_dir, name)
+        if (os.path.exists(dst) and
+                os.path.getmtime(dst) >= os.path.getmtime(src)):
+            continue
+        bits = encode(src, dst)
+        check_ratio(src, dst, bits)
+
+
+if __name__ == "__main__":
+    encode_all(sys.argv[1], sys.argv[2])
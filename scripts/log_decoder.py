@@ -0,0 +1,161 @@
+"""
+Skirmish ESP32 Firmware
+
+Log decoder
+
+Turns the binary log records of a LOG_BINARY build (see src/inc/log_ring.h)
+back into text. The records only contain the address of their format
+string, which is looked up in the ELF file of the firmware that wrote
+them:
+
+    stty -F /dev/ttyUSB0 115200 raw
+    python scripts/log_decoder.py .pio/build/esp32dev/firmware.elf \
+        < /dev/ttyUSB0
+
+A capture file can be passed as the second argument instead of stdin.
+Bytes outside of records (boot messages, panics) are passed through.
+
+Copyright (C) 2023 Ole Lange
+"""
+
+import re
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+HEADER_SIZE = 12
+RECORD_MAX = 128
+
+LEVELS = [("DEBUG", "\033[32m"), ("INFO", "\033[34m"),
+          ("WARNING", "\033[33m"), ("ERROR", "\033[31m"),
+          ("FATAL", "\033[35m")]
+ANSI_CYAN = "\033[36m"
+ANSI_RESET = "\033[0m"
+
+# Conversions as parsed by parseSpec() in src/inc/log_ring.cpp
+SPEC = re.compile(r"%([-+ #0]*[0-9.]*)([hlzjt]*)([diuoxXcpfFeEgGs%]?)")
+
+
+class Elf:
+    """Reads null terminated strings at addresses of an ELF32 file"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            raise RuntimeError("%s is not an ELF32 file" % path)
+
+        # Section headers: address, file offset and size of every section
+        # with contents in memory
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2e)
+        self.sections = []
+        for i in range(shnum):
+            (_, type_, flags, addr, offset,
+             size) = struct.unpack_from("<IIIIII", self.data,
+                                        shoff + i * shentsize)
+            if type_ == 1 and flags & 2 and addr != 0:  # PROGBITS, ALLOC
+                self.sections.append((addr, offset, size))
+
+    def string(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode("utf-8", "replace")
+        return None
+
+
+def format_record(record, elf):
+    length, level, time, address = struct.unpack_from("<HBxII", record)
+    fmt = elf.string(address)
+    if fmt is None:
+        return "<unknown format string 0x%08x>" % address
+
+    args = record[HEADER_SIZE:length]
+    offset = [0]
+
+    def take(size):
+        value = args[offset[0]:offset[0] + size]
+        offset[0] += size
+        return value.ljust(size, b"\0")
+
+    def convert(match):
+        flags, modifier, conversion = match.groups()
+        if conversion in ("%", ""):
+            return "%" if conversion == "%" else match.group(0)
+        if conversion == "s":
+            size = take(1)[0]
+            return ("%" + flags + "s") % take(size).decode("utf-8", "replace")
+        if conversion in "fFeEgG":
+            value, = struct.unpack("<f", take(4))
+            return ("%" + flags + conversion) % value
+        if modifier.count("l") >= 2:
+            value, = struct.unpack("<q" if conversion in "di" else "<Q",
+                                   take(8))
+        else:
+            value, = struct.unpack("<i" if conversion in "di" else "<I",
+                                   take(4))
+        if conversion == "p":
+            return "0x%08x" % value
+        if conversion == "c":
+            return chr(value & 0xff)
+        if conversion == "u":
+            conversion = "d"
+        return ("%" + flags + conversion) % value
+
+    text = SPEC.sub(convert, fmt)
+    name, color = LEVELS[min(level, len(LEVELS) - 1)]
+    return "[%s%s%s]%s\t%10d%s - %s" % (color, name, ANSI_RESET, ANSI_CYAN,
+                                       time, ANSI_RESET, text)
+
+
+def decode(stream, elf, out):
+    buffer = b""
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buffer += chunk
+
+        while True:
+            start = buffer.find(SYNC)
+            if start < 0:
+                # Keep a possible first sync byte for the next chunk
+                keep = 1 if buffer.endswith(SYNC[:1]) else 0
+                out.write(buffer[:len(buffer) - keep].decode("utf-8",
+                                                             "replace"))
+                buffer = buffer[len(buffer) - keep:]
+                break
+
+            out.write(buffer[:start].decode("utf-8", "replace"))
+            buffer = buffer[start:]
+            if len(buffer) < len(SYNC) + HEADER_SIZE:
+                break
+
+            length, = struct.unpack_from("<H", buffer, len(SYNC))
+            if length < HEADER_SIZE or length > RECORD_MAX or length % 4:
+                # Not a record, pass the sync bytes through
+                out.write(buffer[:1].decode("utf-8", "replace"))
+                buffer = buffer[1:]
+                continue
+            if len(buffer) < len(SYNC) + length:
+                break
+
+            record = buffer[len(SYNC):len(SYNC) + length]
+            buffer = buffer[len(SYNC) + length:]
+            out.write(format_record(record, elf) + "\n")
+        out.flush()
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("usage: log_decoder.py <firmware.elf> [capture file]")
+        sys.exit(1)
+
+    elf = Elf(sys.argv[1])
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], "rb") as f:
+            decode(f, elf, sys.stdout)
+    else:
+        decode(sys.stdin.buffer, elf, sys.stdout)
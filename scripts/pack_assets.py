@@ -0,0 +1,176 @@
+"""
+Skirmish ESP32 Firmware
+
+Asset packer
+
+Packs all assets into one archive which is flashed to the "assets"
+partition and memory mapped by the firmware (see src/inc/assets.cpp).
+Runs as a PlatformIO pre script before every build and adds the
+"uploadassets" target to flash the archive. Can also be run directly:
+
+    python scripts/pack_assets.py
+
+Sounds from assets/sounds/ are IMA-ADPCM encoded (see encode_audio.py)
+before they are packed.
+
+Archive layout (little endian):
+    header  "SKAR", u16 version, u16 count, u32 size, u32 reserved
+    index   count x (u32 offset, u32 length), offsets from archive start
+    data    the assets, each aligned to ALIGN bytes
+
+Asset IDs are indexes into the index table. They are written to
+src/inc/asset_ids.h, which is only touched if the IDs changed.
+
+Copyright (C) 2023 Ole Lange
+"""
+
+import csv
+import os
+import struct
+import sys
+
+MAGIC = b"SKAR"
+VERSION = 1
+ALIGN = 4
+HEADER_FORMAT = "<4sHHII"
+INDEX_FORMAT = "<II"
+
+PARTITION_NAME = "assets"
+
+
+def align(value):
+    return (value + ALIGN - 1) // ALIGN * ALIGN
+
+
+def collect(project_dir, work_dir):
+    """Returns a list of (id name, path) of all assets to pack. Every
+    group is a directory in assets/, its files are prepared by the group's
+    handler and get the group's prefix in their ID name."""
+    sys.path.insert(0, os.path.join(project_dir, "scripts"))
+    import encode_audio
+
+    groups = [
+        ("sounds", "SOUND", encode_audio.encode_all),
+    ]
+
+    assets = []
+    for directory, prefix, prepare in groups:
+        src_dir = os.path.join(project_dir, "assets", directory)
+        dst_dir = os.path.join(work_dir, directory)
+        prepare(src_dir, dst_dir)
+
+        for name in sorted(os.listdir(src_dir)):
+            path = os.path.join(dst_dir, name)
+            if not os.path.exists(path):
+                continue
+            stem = os.path.splitext(name)[0]
+            id_name = "ASSET_%s_%s" % (prefix, stem.upper().replace("-", "_"))
+            assets.append((id_name, path))
+    return assets
+
+
+def pack(assets, archive_path):
+    count = len(assets)
+    offset = align(struct.calcsize(HEADER_FORMAT) +
+                   count * struct.calcsize(INDEX_FORMAT))
+
+    index = b""
+    data = b""
+    for _, path in assets:
+        with open(path, "rb") as f:
+            content = f.read()
+        index += struct.pack(INDEX_FORMAT, offset + len(data), len(content))
+        data += content + b"\0" * (align(len(content)) - len(content))
+
+    size = offset + len(data)
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, count, size, 0)
+    archive = header + index
+    archive += b"\0" * (offset - len(archive)) + data
+
+    with open(archive_path, "wb") as f:
+        f.write(archive)
+    return archive
+
+
+def verify(archive, assets):
+    """Reads the archive back the same way the firmware does"""
+    magic, version, count, size, _ = struct.unpack_from(HEADER_FORMAT,
+                                                        archive, 0)
+    assert magic == MAGIC and version == VERSION, "bad header"
+    assert count == len(assets) and size == len(archive), "bad size"
+
+    for i, (id_name, path) in enumerate(assets):
+        offset, length = struct.unpack_from(
+            INDEX_FORMAT, archive,
+            struct.calcsize(HEADER_FORMAT) + i * struct.calcsize(INDEX_FORMAT))
+        assert offset % ALIGN == 0, "%s is not aligned" % id_name
+        assert offset + length <= size, "%s is out of bounds" % id_name
+        with open(path, "rb") as f:
+            assert archive[offset:offset + length] == f.read(), \
+                "%s doesn't match its source" % id_name
+
+
+def write_ids(assets, header_path):
+    lines = [
+        "/*",
+        "Skirmish ESP32 Firmware",
+        "",
+        "Asset IDs - generated by scripts/pack_assets.py, do not edit",
+        "*/",
+        "",
+        "#pragma once",
+        "",
+    ]
+    for i, (id_name, _) in enumerate(assets):
+        lines.append("#define %s %d" % (id_name, i))
+    lines += ["", "#define ASSET_COUNT %d" % len(assets), ""]
+    content = "\n".join(lines)
+
+    if os.path.exists(header_path):
+        with open(header_path) as f:
+            if f.read() == content:
+                return
+    with open(header_path, "w") as f:
+        f.write(content)
+
+
+def partition_offset(project_dir):
+    with open(os.path.join(project_dir, "partitions.csv")) as f:
+        for row in csv.reader(f):
+            if row and row[0].strip() == PARTITION_NAME:
+                return row[3].strip()
+    raise RuntimeError("partitions.csv has no %s partition" % PARTITION_NAME)
+
+
+def pack_all(project_dir, archive_path):
+    work_dir = os.path.join(project_dir, ".pio", "assets")
+    assets = collect(project_dir, work_dir)
+
+    os.makedirs(os.path.dirname(archive_path), exist_ok=True)
+    archive = pack(assets, archive_path)
+    verify(archive, assets)
+    write_ids(assets, os.path.join(project_dir, "src", "inc", "asset_ids.h"))
+
+    print("pack_assets: %d assets, %d bytes -> %s" %
+          (len(assets), len(archive), archive_path))
+
+
+try:
+    Import("env")  # noqa: F821 (provided by PlatformIO)
+    archive_path = os.path.join(env.subst("$BUILD_DIR"), "assets.bin")  # noqa: F821
+    pack_all(env["PROJECT_DIR"], archive_path)  # noqa: F821
+
+    env.AddCustomTarget(  # noqa: F821
+        name="uploadassets",
+        dependencies=None,
+        actions='"$PYTHONEXE" "$UPLOADER" --chip esp32 --baud $UPLOAD_SPEED '
+                'write_flash %s "%s"' % (partition_offset(env["PROJECT_DIR"]),  # noqa: F821
+                                         archive_path),
+        title="Upload Assets",
+        description="Flash the asset archive to the assets partition")
+except NameError:
+    if __name__ == "__main__":
+        project_dir = os.path.dirname(os.path.dirname(os.path.abspath(
+            sys.argv[0])))
+        pack_all(project_dir,
+                 os.path.join(project_dir, ".pio", "assets", "assets.bin"))
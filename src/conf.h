@@ -24,6 +24,15 @@ Copyright (C) 2023 Ole Lange
 #define LOG_SERIAL_SPEED 115200
 // (Levels are 0->5 Debug, Info, Warn, Error, Fatal, Off)
 #define LOG_LEVEL 0
+// Log calls are recorded into a ring buffer of LOG_BUFFER_SIZE bytes (power
+// of two), a background task writes them out every LOG_DRAIN_INTERVAL ms.
+// With LOG_BINARY the records are written as binary frames, decode them
+// with scripts/log_decoder.py
+#define LOG_BUFFER_SIZE 4096
+#define LOG_DRAIN_INTERVAL 10
+// #define LOG_BINARY
+// Logs the cost of a log call (enabled and compiled out) at boot
+// #define LOG_BENCHMARK
 
 // LED
 // Settings maxium brightness for vests to 0.5
@@ -56,22 +65,77 @@ Copyright (C) 2023 Ole Lange
 #define NO_VIBR_MOTOR
 #endif
 
+// Vibration motor PWM (LEDC, 8 bit)
+#define HAPTICS_LEDC_CHANNEL 0
+#define HAPTICS_PWM_FREQUENCY 20000
+
+// Trigger: the first edge starts hardware timer TRIGGER_TIMER, the level is
+// read TRIGGER_DEBOUNCE_TIME milliseconds later
+#define TRIGGER_TIMER 1
+#define TRIGGER_DEBOUNCE_TIME 5
+// Minimum time between the shots of a burst or auto fire (ms), applies if
+// the game sets a shorter shot interval
+#define TRIGGER_MIN_REPEAT_INTERVAL 50
+
 // Power Management
-// Battery voltage is measured with a voltage divider between vbat and gnd
-// the most accurate way of calculating the voltage of the battery is simply
-// by measuring adc values @3.0 and 4.2 volts and interpolating the other values
+// Battery voltage is measured with a voltage divider between vbat and gnd.
+// The battery service samples it every VBAT_SAMPLE_INTERVAL milliseconds and
+// averages the last VBAT_SAMPLE_COUNT samples.
 #define VBAT_SAMPLE_COUNT 100
+#define VBAT_SAMPLE_INTERVAL 100
+// The voltage is interpolated between adc values measured @3.0 and 4.2 volts
+// (2.5 dB attenuation)
 #define ADC_AT_4200mV 2690.0
 #define ADC_AT_3000mV 1910.0
-
-// Time after which the phaser is turned off when not connected via BLE (in
-// minutes)
+// Ratio of the voltage divider (vbat / adc pin voltage). When defined, chips
+// with eFuse calibration of the ADC use it instead of the interpolation.
+// Only enable it with the ratio of the board's resistors, confirmed by a
+// measurement on a device.
+// #define VBAT_DIVIDER_RATIO 2.0
+
+// Load model of the battery (see battery.cpp), currents are estimates
+#define BATTERY_CAPACITY 2000            // mAh
+#define BATTERY_INTERNAL_RESISTANCE 180  // mOhm (cell, protection, wiring)
+#define BATTERY_BASE_CURRENT 120         // mA (ESP32, radio, display)
+#define BATTERY_IR_CURRENT 250           // mA while transmitting a shot
+#define BATTERY_AUDIO_CURRENT 300        // mA while the speaker amp is on
+#define BATTERY_VIBRATION_CURRENT 80     // mA while the motor runs
+// Time in which the voltage corrects the load model (s)
+#define BATTERY_SOC_TIME_CONSTANT 120
+
+// CPU frequency and light sleep are chosen by phase (see power.cpp), the
+// wall time spent in every phase is logged every POWER_LOG_INTERVAL ms
+#define POWER_LOG_INTERVAL 60000
+#define POWER_COUNTDOWN_TIME 10  // Countdown phase before the start (s)
+
+// Time after which the phaser goes to standby (deep sleep) when not connected
+// via BLE (in minutes). The power button on PIN_PWR_OFF wakes it up again.
 #define NOT_CONNECTED_POWER_OFF_TIMEOUT 5
 
 // Time after which the phaser resets it's game state when not connected via BLE
 // (in ms)
 #define CONNECTION_LOSS_RESET_TIMEOUT 20000
 
+// Flight recorder (see recorder.cpp): events kept in RTC memory, at most 40
+// so the upload fits into one BLE message (512 bytes). The heap low-water
+// mark is recorded when it dropped by RECORDER_HEAP_STEP bytes. The events
+// are uploaded RECORDER_UPLOAD_DELAY ms after the app connected, so it had
+// time to subscribe.
+#define RECORDER_EVENTS 32
+#define RECORDER_HEAP_STEP 2048
+#define RECORDER_UPLOAD_DELAY 2000
+
+// Diagnostics characteristic (see diagnostics.cpp), enabled by the app. At
+// most DIAGNOSTICS_BANDWIDTH bytes per second are sent, and nothing within
+// DIAGNOSTICS_GAME_GAP ms after a game message. Metrics and histograms are
+// sent every DIAGNOSTICS_METRICS_INTERVAL ms, up to DIAGNOSTICS_LOG_SLOTS
+// log messages wait in between (truncated to DIAGNOSTICS_LOG_LENGTH).
+#define DIAGNOSTICS_BANDWIDTH 512
+#define DIAGNOSTICS_GAME_GAP 50
+#define DIAGNOSTICS_METRICS_INTERVAL 5000
+#define DIAGNOSTICS_LOG_SLOTS 8
+#define DIAGNOSTICS_LOG_LENGTH 96
+
 // Display
 #define DISPLAY_ROTATION 2  // -> Portrait with connector on the top side
 
@@ -87,6 +151,27 @@ Copyright (C) 2023 Ole Lange
 #endif
 
 #define GAMMA_CORRECTION  // Apply gamma correction to the display#
+#define DISPLAY_PALETTE_SIZE 8  // Cached gamma corrected runtime colors
+
+// Drawing is recorded into two display lists (UI records into one while
+// the other is replayed by the render task on core 0). Full screen redraws
+// are rasterized to RAM in strips of DISPLAY_STRIP_HEIGHT rows and pushed
+// by the render task (240 * DISPLAY_STRIP_HEIGHT * 2 bytes).
+#define DISPLAY_STRIP_HEIGHT 32
+#define DISPLAY_LIST_COMMANDS 256  // Commands per list
+#define DISPLAY_LIST_TEXT 512      // Bytes of text per list
+
+// Measured and rasterized texts (see text_cache.h)
+#define DISPLAY_TEXT_CACHE_ENTRIES 16
+#define DISPLAY_TEXT_CACHE_LENGTH 32    // Longer texts aren't cached
+#define DISPLAY_TEXT_CACHE_IMAGE 1024  // Max bytes of a 1-bpp text image
+
+// Renders every full redraw twice, directly and in strips, and logs the
+// recording time and the time of both paths
+// #define DISPLAY_BENCHMARK
+
+// DISPLAY_EMULATOR is set by the emulator environment (platformio.ini), the
+// panel is replaced by a framebuffer on the host (see src/emulator/)
 
 // Audio / Speaker Amp
 #define PIN_SPK_EN 23
@@ -98,12 +183,34 @@ Copyright (C) 2023 Ole Lange
 #define NO_AUDIO
 #endif
 
+// Sound bank: short, frequently played clips are loaded to RAM at boot and
+// played from memory. Clips that don't fit into the budget (in bytes) are
+// streamed from the asset archive in flash. The larger budget is used if PSRAM is available.
+#define SOUND_BANK_MAX_ENTRIES 8
+#define SOUND_BANK_BUDGET 73728
+#define SOUND_BANK_PSRAM_BUDGET 1048576
+
+// Mixer: amount of clips that can play at the same time and the size of
+// the blocks that are mixed at once. All clips must use MIXER_SAMPLE_RATE.
+#define MIXER_VOICES 4
+#define MIXER_BLOCK_FRAMES 64
+#define MIXER_SAMPLE_RATE 24000
+
 // UI
 // The UI is refreshed allways when new data is available but to keep
 // the battery indicator and other thing fresh the UI is also updated
 // every UI_REFRESH_INTERVAL milliseconds
 #define UI_REFRESH_INTERVAL 15000
 
+// Animations are drawn every ANIMATION_FRAME_INTERVAL milliseconds, a
+// frame should take at most ANIMATION_FRAME_BUDGET microseconds to record,
+// otherwise the following frames are dropped
+#define ANIMATION_FRAME_INTERVAL 33
+#define ANIMATION_FRAME_BUDGET 2000
+#define UI_TRANSITION_TIME 250  // Wipe between two scenes
+#define UI_HIT_FLASH_TIME 600
+#define UI_COUNTER_ROLL_TIME 500
+
 // Communication
 #define HP_TIMESYNC_SEND_INTERVAL 10000
 #define HW_STATUS_SEND_INTERVAL 15000
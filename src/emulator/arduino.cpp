@@ -0,0 +1,54 @@
+/*
+Skirmish ESP32 Firmware
+
+Emulator - Arduino core
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <Arduino.h>
+
+// Emulated time since boot
+static uint64_t emulatorMicros = 0;
+
+HardwareSerial Serial;
+
+/**
+ * Lets time pass
+ *
+ * @param ms milliseconds
+ */
+void emulatorAdvance(uint32_t ms) { emulatorMicros += (uint64_t)ms * 1000; }
+
+unsigned long millis() { return emulatorMicros / 1000; }
+
+unsigned long micros() { return emulatorMicros; }
+
+void delay(uint32_t ms) { emulatorAdvance(ms); }
+
+void vTaskDelay(uint32_t ticks) { emulatorAdvance(ticks); }
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t written = 0;
+    while (size--) written += write(*buffer++);
+    return written;
+}
+
+size_t Print::print(const char *text) {
+    return write((const uint8_t *)text, strlen(text));
+}
+
+size_t Print::println(const char *text) { return print(text) + print("\r\n"); }
+
+size_t Print::printf(const char *format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return print(buffer);
+}
+
+void HardwareSerial::begin(unsigned long baud) {}
+
+size_t HardwareSerial::write(uint8_t c) { return fputc(c, stderr) == c; }
@@ -0,0 +1,17 @@
+/*
+Skirmish ESP32 Firmware
+
+Display emulator - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+void emulatorInit();
+
+uint8_t emulatorStateCount();
+const char *emulatorStateName(uint8_t index);
+uint32_t emulatorRunState(uint8_t index, const char *output);
@@ -0,0 +1,208 @@
+/*
+Skirmish ESP32 Firmware
+
+Display emulator
+
+Runs the UI on the host against an emulated panel (see panel.h). Every
+state of the UI is shown for EMULATOR_STATE_TIME milliseconds of emulated
+time, then the screen is written to <output>/<state>.png and the SPI
+traffic the state caused is reported by display list command type.
+
+    pio run -e emulator
+    .pio/build/emulator/program [output directory]
+
+The states are also compared against golden images by
+test/test_golden (pio test -e emulator).
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <Arduino.h>
+#include <sys/stat.h>
+
+#include "../conf.h"
+#include "../inc/bluetooth.h"
+#include "../inc/const.h"
+#include "../inc/display.h"
+#include "../inc/game.h"
+#include "../inc/log.h"
+#include "../inc/time.h"
+#include "../inc/ui.h"
+#include "emulator.h"
+
+#define EMULATOR_STEP 10          // Emulated time of a main loop pass (ms)
+#define EMULATOR_STATE_TIME 2000  // Time every state is shown (ms)
+#define EMULATOR_TIMESTAMP 1700000000
+
+/**
+ * A state of the UI, reached from the previous one
+ */
+typedef struct {
+    const char *name;
+    bool connected;
+    uint8_t scene;       // SCENE_NO_SCENE: the UI changes it by itself
+    const char *data;    // Game data as sent by the app or NULL
+    int32_t startIn;     // Game start relative to now (s), 0: unchanged
+    bool hit;            // The player was hit
+    const char *msgBox;  // Heading of a message box or NULL
+} EmulatorState;
+
+static const EmulatorState states[] = {
+    {"splash", false, SCENE_NO_SCENE, NULL, 0, false, NULL},
+    {"ble_connect", false, SCENE_BLE_CONNECT, NULL, 0, false, NULL},
+    {"no_game", true, SCENE_NO_SCENE, NULL, 0, false, NULL},
+    {"joined_game", true, SCENE_JOINED_GAME,
+     "{\"g_id\":\"EMULATOR\",\"g_pc\":6,\"g_tc\":2,\"t_n\":\"Red Team\","
+     "\"t_id\":1,\"t_pc\":3,\"t_r\":1,\"p_n\":\"Player One\",\"p_id\":1,"
+     "\"p_cr\":230,\"p_cg\":40,\"p_cb\":40,\"p_h\":100,\"p_r\":2,"
+     "\"p_al\":true,\"p_a\":30,\"p_pe\":true}",
+     0, false, NULL},
+    {"countdown", true, SCENE_COUNTDOWN, NULL, 3, false, NULL},
+    {"game", true, SCENE_GAME, NULL, -1, false, NULL},
+    {"game_hit", true, SCENE_NO_SCENE, "{\"p_h\":75,\"p_p\":10}", 0, true,
+     NULL},
+    {"game_low_health", true, SCENE_NO_SCENE, "{\"p_h\":10,\"p_a\":2}", 0,
+     false, NULL},
+    {"game_msgbox", true, SCENE_NO_SCENE, NULL, 0, false, "Hit"},
+    {"reconnect", false, SCENE_NO_SCENE, NULL, 0, false, NULL},
+};
+
+#define EMULATOR_STATES (sizeof(states) / sizeof(states[0]))
+
+static const char *primitiveNames[DL_TYPES + 1] = {
+    "fill_rect", "rect", "line",  "fill_triangle", "triangle",
+    "bitmap",    "text", "runs",  "image",         "strips"};
+
+SkirmishDisplay display;
+SkirmishBluetooth bluetooth;
+Game *game;
+SkirmishUI *ui;
+
+/**
+ * Applies game data the way SkirmCom does
+ *
+ * @param data JSON object
+ */
+static void applyData(const char *data) {
+    DynamicJsonDocument document(1024);
+    deserializeJson(document, data);
+    JsonObject root = document.as<JsonObject>();
+    game->updatePGTData(&root);
+
+    // updatePGTData() already reset the flags the game scene reacts to
+    game->player.dataWasUpdated();
+    game->team.dataWasUpdated();
+}
+
+/**
+ * Initializes the drivers and the UI, call once before the first state
+ */
+void emulatorInit() {
+    logInit();
+    display.init();
+    bluetooth.init();
+    setCurrentTS(EMULATOR_TIMESTAMP);
+
+    game = new Game();
+    ui = new SkirmishUI(&display, &bluetooth, game);
+}
+
+/**
+ * @return amount of states
+ */
+uint8_t emulatorStateCount() { return EMULATOR_STATES; }
+
+/**
+ * @param index index of the state
+ * @return name of the state, also the name of its screenshot
+ */
+const char *emulatorStateName(uint8_t index) { return states[index].name; }
+
+/**
+ * Shows a state and reports what it cost. The states have to be run in
+ * order, each one is reached from the previous one.
+ *
+ * @param index index of the state
+ * @param output directory of the screenshots
+ * @return SPI bytes of the state
+ */
+uint32_t emulatorRunState(uint8_t index, const char *output) {
+    static char msgBoxHeading[16];
+    static char msgBoxText[] = "by Player Two";
+    const EmulatorState *state = &states[index];
+
+    display.tft.resetCost();
+    uint32_t spiBytes = display.tft.spiBytes;
+
+    bluetooth.setConnectionState(state->connected);
+    if (state->data != NULL) applyData(state->data);
+    if (state->startIn != 0) {
+        game->startTime = getCurrentTS() + state->startIn;
+    }
+    if (state->hit) {
+        game->player.wasHit = true;
+        strcpy(game->player.wasHitBy, "Player Two");
+    }
+    if (state->scene != SCENE_NO_SCENE) ui->setScene(state->scene);
+    if (state->msgBox != NULL) {
+        strncpy(msgBoxHeading, state->msgBox, sizeof(msgBoxHeading) - 1);
+        ui->msgBox(msgBoxHeading, msgBoxText, EMULATOR_STATE_TIME);
+    }
+
+    for (uint32_t t = 0; t < EMULATOR_STATE_TIME; t += EMULATOR_STEP) {
+        ui->update();
+        ui->render();
+        emulatorAdvance(EMULATOR_STEP);
+    }
+    display.waitIdle();
+    display.flush();
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.png", output, state->name);
+    if (!display.tft.savePNG(path)) {
+        fprintf(stderr, "Couldn't write %s\n", path);
+    }
+
+    spiBytes = display.tft.spiBytes - spiBytes;
+    printf("\n%s (%lu SPI bytes)\n", state->name, (unsigned long)spiBytes);
+    printf("  %-14s %8s %9s %10s\n", "command", "windows", "pixels",
+           "SPI bytes");
+    for (uint8_t i = 0; i <= DL_TYPES; i++) {
+        EmulatorCost *cost = &display.tft.cost[i];
+        if (cost->windows == 0 && cost->pixels == 0) continue;
+        printf("  %-14s %8lu %9lu %10lu\n", primitiveNames[i],
+               (unsigned long)cost->windows, (unsigned long)cost->pixels,
+               (unsigned long)(cost->windows * 11 + cost->pixels * 2));
+    }
+    return spiBytes;
+}
+
+// The test runner brings its own main()
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv) {
+    const char *output = argc > 1 ? argv[1] : "emulator";
+    mkdir(output, 0755);
+
+    emulatorInit();
+
+    uint32_t spiBytes[EMULATOR_STATES];
+    for (uint8_t i = 0; i < EMULATOR_STATES; i++) {
+        spiBytes[i] = emulatorRunState(i, output);
+    }
+
+    // Summary, most expensive states first
+    printf("\n%-18s %10s\n", "state", "SPI bytes");
+    bool reported[EMULATOR_STATES] = {false};
+    for (uint8_t n = 0; n < EMULATOR_STATES; n++) {
+        uint8_t next = 0xff;
+        for (uint8_t i = 0; i < EMULATOR_STATES; i++) {
+            if (reported[i]) continue;
+            if (next == 0xff || spiBytes[i] > spiBytes[next]) next = i;
+        }
+        reported[next] = true;
+        printf("%-18s %10lu\n", states[next].name,
+               (unsigned long)spiBytes[next]);
+    }
+    return 0;
+}
+#endif
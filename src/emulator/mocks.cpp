@@ -0,0 +1,43 @@
+/*
+Skirmish ESP32 Firmware
+
+Emulator - Drivers
+
+Stand-ins for the drivers the UI talks to. Hardware outputs are ignored,
+the battery is always at 80 % and the bluetooth connection is controlled
+by the emulator.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "../inc/battery.h"
+#include "../inc/bluetooth.h"
+#include "../inc/haptics.h"
+#include "../inc/hitpoint.h"
+#include "../inc/recorder.h"
+
+float batteryPercent() { return 0.8; }
+
+void hapticsPlay(uint8_t pattern) {}
+
+void hitpointSelectAnimation(uint8_t animation) {}
+
+void hitpointSetAnimationSpeed(uint8_t speed) {}
+
+void hitpointSetColor(uint8_t r, uint8_t g, uint8_t b) {}
+
+void recorderRecord(uint8_t type, uint8_t a, uint16_t b) {}
+
+SkirmishBluetooth::SkirmishBluetooth() {}
+
+void SkirmishBluetooth::init() { bluetoothName = (char *)"SKIRMISH-E3A1"; }
+
+bool SkirmishBluetooth::getConnectionState() { return isConnected; }
+
+void SkirmishBluetooth::setConnectionState(bool newState) {
+    if (!isConnected && newState) lastConnectedTime = millis();
+    if (isConnected && !newState) lastDisconnectedTime = millis();
+    isConnected = newState;
+}
+
+char *SkirmishBluetooth::getName() { return bluetoothName; }
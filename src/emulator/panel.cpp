@@ -0,0 +1,272 @@
+/*
+Skirmish ESP32 Firmware
+
+Emulated display panel
+
+Keeps what the ILI9341 would show in RAM, so the UI can be rendered and
+inspected on the host. Only the calls the panel driver (Adafruit_SPITFT)
+overrides are emulated, everything else is drawn by Adafruit_GFX through
+them just like on the device.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "panel.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Panel constructor
+ */
+EmulatorPanel::EmulatorPanel()
+    : Adafruit_GFX(EMULATOR_WIDTH, EMULATOR_HEIGHT) {
+    memset(framebuffer, 0, sizeof(framebuffer));
+    resetCost();
+}
+
+/**
+ * Clears the cost counters
+ */
+void EmulatorPanel::resetCost() { memset(cost, 0, sizeof(cost)); }
+
+/**
+ * @return the counters of the command that is executed
+ */
+EmulatorCost* EmulatorPanel::currentCost() {
+    uint8_t type = DisplayList::executing;
+    return &cost[type < DL_TYPES ? type : DL_TYPES];
+}
+
+void EmulatorPanel::begin(uint32_t freq) {}
+
+void EmulatorPanel::startWrite() {}
+
+void EmulatorPanel::endWrite() {}
+
+void EmulatorPanel::setAddrWindow(uint16_t x, uint16_t y, uint16_t w,
+                                  uint16_t h) {
+    windowX = x;
+    windowY = y;
+    windowW = w;
+    windowH = h;
+    windowPos = 0;
+    currentCost()->windows++;
+}
+
+/**
+ * Streams pixels into the address window, like the panel the position
+ * wraps around at the end of the window
+ */
+void EmulatorPanel::writePixels(uint16_t* colors, uint32_t len, bool block,
+                                bool bigEndian) {
+    currentCost()->pixels += len;
+    if (windowW <= 0 || windowH <= 0) return;
+
+    uint32_t size = (uint32_t)windowW * windowH;
+    for (uint32_t i = 0; i < len; i++) {
+        int16_t x = windowX + windowPos % windowW;
+        int16_t y = windowY + windowPos / windowW;
+        if (x < _width && y < _height) framebuffer[y * _width + x] = colors[i];
+        windowPos = (windowPos + 1) % size;
+    }
+}
+
+/**
+ * Fills a rectangle clipped to the screen with one address window, the
+ * way Adafruit_SPITFT does
+ */
+void EmulatorPanel::fill(int16_t x, int16_t y, int16_t w, int16_t h,
+                         uint16_t color) {
+    if (w < 0) {
+        x += w + 1;
+        w = -w;
+    }
+    if (h < 0) {
+        y += h + 1;
+        h = -h;
+    }
+
+    int16_t x1 = min((int16_t)(x + w), _width);
+    int16_t y1 = min((int16_t)(y + h), _height);
+    x = max(x, (int16_t)0);
+    y = max(y, (int16_t)0);
+    if (x1 <= x || y1 <= y) return;
+
+    // Through the virtual function, so SkirmishTFT counts the window
+    setAddrWindow(x, y, x1 - x, y1 - y);
+    currentCost()->pixels += (uint32_t)(x1 - x) * (y1 - y);
+    for (int16_t row = y; row < y1; row++) {
+        uint16_t* pixel = &framebuffer[row * _width + x];
+        for (int16_t i = x; i < x1; i++) *pixel++ = color;
+    }
+}
+
+void EmulatorPanel::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    fill(x, y, 1, 1, color);
+}
+
+void EmulatorPanel::writePixel(int16_t x, int16_t y, uint16_t color) {
+    fill(x, y, 1, 1, color);
+}
+
+void EmulatorPanel::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                             uint16_t color) {
+    fill(x, y, w, h, color);
+}
+
+void EmulatorPanel::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                                  uint16_t color) {
+    fill(x, y, w, h, color);
+}
+
+void EmulatorPanel::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                  uint16_t color) {
+    fill(x, y, w, 1, color);
+}
+
+void EmulatorPanel::writeFastHLine(int16_t x, int16_t y, int16_t w,
+                                   uint16_t color) {
+    fill(x, y, w, 1, color);
+}
+
+void EmulatorPanel::drawFastVLine(int16_t x, int16_t y, int16_t h,
+                                  uint16_t color) {
+    fill(x, y, 1, h, color);
+}
+
+void EmulatorPanel::writeFastVLine(int16_t x, int16_t y, int16_t h,
+                                   uint16_t color) {
+    fill(x, y, 1, h, color);
+}
+
+/**
+ * @param x, y position
+ * @return the RGB565 color at the position, 0 outside of the screen
+ */
+uint16_t EmulatorPanel::getPixel(int16_t x, int16_t y) {
+    if (x < 0 || x >= _width || y < 0 || y >= _height) return 0;
+    return framebuffer[y * _width + x];
+}
+
+static uint32_t pngCrc(uint32_t crc, const uint8_t* data, uint32_t length) {
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (uint8_t k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320UL ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (uint32_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void pngWrite32(uint8_t* out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static void pngChunk(FILE* file, const char* type, const uint8_t* data,
+                     uint32_t length) {
+    uint8_t header[8];
+    pngWrite32(header, length);
+    memcpy(&header[4], type, 4);
+    fwrite(header, 1, 8, file);
+    fwrite(data, 1, length, file);
+
+    uint8_t crc[4];
+    pngWrite32(crc, pngCrc(pngCrc(0, &header[4], 4), data, length));
+    fwrite(crc, 1, 4, file);
+}
+
+/**
+ * Writes the framebuffer to a PNG file (RGB888, uncompressed deflate
+ * blocks). Colors are written as the panel receives them, i.e. gamma
+ * corrected.
+ *
+ * @param path path of the file
+ * @return false if the file couldn't be written
+ */
+bool EmulatorPanel::savePNG(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return false;
+
+    static const uint8_t signature[] = {0x89, 'P',  'N',  'G',
+                                        '\r', '\n', 0x1a, '\n'};
+    fwrite(signature, 1, sizeof(signature), file);
+
+    uint8_t header[13];
+    pngWrite32(header, _width);
+    pngWrite32(&header[4], _height);
+    header[8] = 8;  // Bit depth
+    header[9] = 2;  // RGB
+    header[10] = header[11] = header[12] = 0;
+    pngChunk(file, "IHDR", header, sizeof(header));
+
+    // Rows start with filter type 0, split into stored deflate blocks of
+    // at most 65535 bytes
+    uint32_t rowSize = 1 + _width * 3;
+    uint32_t rawSize = rowSize * _height;
+    uint8_t* raw = (uint8_t*)malloc(rawSize);
+    uint32_t blocks = (rawSize + 65534) / 65535;
+    uint8_t* data = (uint8_t*)malloc(2 + rawSize + blocks * 5 + 4);
+    if (raw == NULL || data == NULL) {
+        free(raw);
+        free(data);
+        fclose(file);
+        return false;
+    }
+
+    for (int16_t y = 0; y < _height; y++) {
+        uint8_t* row = &raw[y * rowSize];
+        *row++ = 0;
+        for (int16_t x = 0; x < _width; x++) {
+            uint16_t color = framebuffer[y * _width + x];
+            uint8_t r = (color >> 11) & 0x1f;
+            uint8_t g = (color >> 5) & 0x3f;
+            uint8_t b = color & 0x1f;
+            *row++ = (r << 3) | (r >> 2);
+            *row++ = (g << 2) | (g >> 4);
+            *row++ = (b << 3) | (b >> 2);
+        }
+    }
+
+    uint32_t size = 0;
+    data[size++] = 0x78;  // zlib header, no compression
+    data[size++] = 0x01;
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+    for (uint32_t offset = 0; offset < rawSize; offset += 65535) {
+        uint16_t length = min(rawSize - offset, (uint32_t)65535);
+        data[size++] = offset + length == rawSize ? 1 : 0;
+        data[size++] = length;
+        data[size++] = length >> 8;
+        data[size++] = ~length;
+        data[size++] = (uint16_t)~length >> 8;
+        memcpy(&data[size], &raw[offset], length);
+        size += length;
+
+        for (uint32_t i = offset; i < offset + length; i++) {
+            adlerA = (adlerA + raw[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+    }
+    pngWrite32(&data[size], (adlerB << 16) | adlerA);
+    size += 4;
+
+    pngChunk(file, "IDAT", data, size);
+    pngChunk(file, "IEND", NULL, 0);
+
+    free(raw);
+    free(data);
+    return fclose(file) == 0;
+}
@@ -0,0 +1,78 @@
+/*
+Skirmish ESP32 Firmware
+
+Emulated display panel - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "../inc/display_list.h"
+#include "Adafruit_GFX.h"
+
+#define EMULATOR_WIDTH 240
+#define EMULATOR_HEIGHT 320
+
+/**
+ * Cost of the pixels pushed to the panel, an address window is one SPI
+ * transaction
+ */
+typedef struct {
+    uint32_t windows;
+    uint32_t pixels;
+} EmulatorCost;
+
+/**
+ * Stand-in for the ILI9341 on the host (DISPLAY_EMULATOR builds). Pixels
+ * are written to an RGB565 framebuffer the way the panel receives them:
+ * every write opens an address window and streams pixels into it.
+ * Windows and pixels are accounted to the display list command that is
+ * executed (see DisplayList::executing), writes outside of commands are
+ * strip pushes.
+ */
+class EmulatorPanel : public Adafruit_GFX {
+   private:
+    uint16_t framebuffer[EMULATOR_WIDTH * EMULATOR_HEIGHT];
+
+    // Current address window and the position of the next pixel in it
+    int16_t windowX = 0;
+    int16_t windowY = 0;
+    int16_t windowW = 0;
+    int16_t windowH = 0;
+    uint32_t windowPos = 0;
+
+    void fill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    EmulatorCost* currentCost();
+
+   public:
+    EmulatorPanel();
+
+    // Cost by DL_* command type, cost[DL_TYPES] are strip pushes
+    EmulatorCost cost[DL_TYPES + 1];
+    void resetCost();
+
+    void begin(uint32_t freq = 0);
+    void startWrite();
+    void endWrite();
+
+    virtual void setAddrWindow(uint16_t x, uint16_t y, uint16_t w,
+                               uint16_t h);
+    void writePixels(uint16_t* colors, uint32_t len, bool block = true,
+                     bool bigEndian = false);
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+    void writePixel(int16_t x, int16_t y, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                       uint16_t color);
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+
+    uint16_t getPixel(int16_t x, int16_t y);
+    bool savePNG(const char* path);
+};
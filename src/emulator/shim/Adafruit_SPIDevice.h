@@ -0,0 +1,12 @@
+/*
+Skirmish ESP32 Firmware
+
+Emulator - Adafruit BusIO
+
+Included by Adafruit_GFX.h for the SPI and I2C displays, which aren't
+built for the emulator.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
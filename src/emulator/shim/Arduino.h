@@ -0,0 +1,66 @@
+/*
+Skirmish ESP32 Firmware
+
+Emulator - Arduino core
+
+The parts of the Arduino core (and of the FreeRTOS API the ESP32 core
+pulls in with it) that the UI and Adafruit_GFX use, implemented on the
+host by src/emulator/arduino.cpp. Time only advances when the emulator
+says so (see emulatorAdvance()).
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "Print.h"
+
+using std::max;
+using std::min;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_pointer(addr) (*(void *const *)(addr))
+
+#define constrain(amt, low, high) \
+    ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+
+// FreeRTOS, there are no other tasks on the host
+typedef void *TaskHandle_t;
+void vTaskDelay(uint32_t ticks);
+
+// Heap capabilities only matter on the ESP32
+#define MALLOC_CAP_DMA 0
+#define heap_caps_malloc(size, caps) malloc(size)
+
+/**
+ * Serial port, writes to stderr
+ */
+class HardwareSerial : public Print {
+   public:
+    void begin(unsigned long baud);
+    size_t write(uint8_t c);
+};
+
+extern HardwareSerial Serial;
+
+void emulatorAdvance(uint32_t ms);
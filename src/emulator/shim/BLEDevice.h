@@ -0,0 +1,17 @@
+/*
+Skirmish ESP32 Firmware
+
+Emulator - ESP32 BLE library
+
+Only the types the bluetooth driver header refers to, the driver is
+replaced by src/emulator/mocks.cpp.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+class BLECharacteristic;
+class BLEServer;
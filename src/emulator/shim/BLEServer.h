@@ -0,0 +1,11 @@
+/*
+Skirmish ESP32 Firmware
+
+Emulator - ESP32 BLE library (see BLEDevice.h)
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include "BLEDevice.h"
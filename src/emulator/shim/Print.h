@@ -0,0 +1,25 @@
+/*
+Skirmish ESP32 Firmware
+
+Emulator - Print class of the Arduino core
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Print {
+   public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+
+    size_t print(const char *text);
+    size_t println(const char *text = "");
+    size_t printf(const char *format, ...)
+        __attribute__((format(printf, 2, 3)));
+};
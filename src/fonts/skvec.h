@@ -118,6 +118,18 @@ const uint8_t skvec_gameNameBlock[] = {
     /**/
 };
 
+const uint8_t skvec_playerBar[] = {
+    /* Center Block */
+    FILL(RECT), X(35), Y(27), W(170), H(13),
+    /* Left Triangle */
+    FILL(TRIANGLE), X(26), Y(33), X(35), Y(27), X(35), Y(39),
+    /* Right Triangle */
+    FILL(TRIANGLE), X(214), Y(33), X(205), Y(27), X(205), Y(39),
+    /**/
+    0xff
+    /**/
+};
+
 const uint8_t skvec_bluetooth[] = {
     LINE, X(3), Y(0), X(3), Y(12), LINE, X(0), Y(3), X(6),
     Y(8), LINE, X(6), Y(3), X(0),  Y(8), LINE, X(3), Y(0),
@@ -0,0 +1,346 @@
+/*
+Skirmish ESP32 Firmware
+
+SKVEC runs - generated by scripts/compile_skvec.py from skvec.h, do
+not edit
+
+Every graphic as runs (rectangles made of the same horizontal span in
+consecutive rows) sorted by their first row, drawn with
+SkirmishDisplay::drawRuns().
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct SkvecRun {
+    uint8_t x, w;
+    uint16_t y, h;
+} SkvecRun;
+
+typedef struct SkvecRuns {
+    const SkvecRun *runs;
+    uint16_t count;
+    uint16_t top, bottom;  // First and last row
+} SkvecRuns;
+
+// skvec_genericBorder: 3 shapes, 3 runs
+const SkvecRun skvecRunData_genericBorder[] = {
+    {0, 240, 0, 3},
+    {0, 3, 3, 242},
+    {237, 3, 3, 242},
+};
+const SkvecRuns skvecRuns_genericBorder = {
+    skvecRunData_genericBorder, 3, 0, 244};
+
+// skvec_borderTypeDefault: 12 shapes, 120 runs
+const SkvecRun skvecRunData_borderTypeDefault[] = {
+    {0, 55, 0, 1},
+    {225, 16, 0, 1},
+    {0, 54, 1, 1},
+    {226, 15, 1, 1},
+    {0, 53, 2, 1},
+    {227, 14, 2, 1},
+    {0, 52, 3, 1},
+    {228, 13, 3, 1},
+    {0, 51, 4, 1},
+    {229, 12, 4, 1},
+    {0, 50, 5, 1},
+    {230, 11, 5, 1},
+    {0, 49, 6, 1},
+    {231, 10, 6, 1},
+    {0, 48, 7, 1},
+    {232, 9, 7, 1},
+    {0, 47, 8, 1},
+    {233, 8, 8, 1},
+    {0, 46, 9, 1},
+    {234, 7, 9, 1},
+    {0, 45, 10, 1},
+    {235, 6, 10, 1},
+    {0, 44, 11, 1},
+    {236, 5, 11, 1},
+    {0, 43, 12, 1},
+    {237, 4, 12, 1},
+    {0, 42, 13, 1},
+    {238, 3, 13, 1},
+    {0, 41, 14, 1},
+    {239, 2, 14, 1},
+    {0, 40, 15, 1},
+    {240, 1, 15, 1},
+    {0, 39, 16, 1},
+    {0, 38, 17, 1},
+    {0, 37, 18, 1},
+    {0, 36, 19, 1},
+    {0, 16, 20, 1},
+    {0, 15, 21, 1},
+    {0, 14, 22, 1},
+    {0, 13, 23, 1},
+    {0, 12, 24, 1},
+    {0, 11, 25, 1},
+    {0, 10, 26, 248},
+    {240, 1, 74, 1},
+    {239, 2, 75, 1},
+    {238, 3, 76, 1},
+    {237, 4, 77, 1},
+    {236, 5, 78, 1},
+    {235, 6, 79, 1},
+    {234, 7, 80, 1},
+    {233, 8, 81, 1},
+    {232, 9, 82, 1},
+    {231, 10, 83, 1},
+    {230, 11, 84, 3},
+    {230, 10, 87, 163},
+    {229, 11, 250, 1},
+    {228, 12, 251, 1},
+    {227, 13, 252, 1},
+    {226, 14, 253, 1},
+    {225, 15, 254, 1},
+    {224, 16, 255, 1},
+    {223, 17, 256, 1},
+    {222, 18, 257, 1},
+    {221, 19, 258, 1},
+    {220, 20, 259, 1},
+    {219, 21, 260, 1},
+    {218, 22, 261, 1},
+    {217, 23, 262, 1},
+    {216, 24, 263, 1},
+    {215, 25, 264, 1},
+    {214, 26, 265, 1},
+    {213, 27, 266, 1},
+    {212, 28, 267, 1},
+    {211, 29, 268, 1},
+    {210, 30, 269, 1},
+    {209, 31, 270, 1},
+    {208, 32, 271, 1},
+    {207, 33, 272, 1},
+    {206, 34, 273, 1},
+    {0, 11, 274, 1},
+    {205, 35, 274, 1},
+    {0, 12, 275, 1},
+    {204, 36, 275, 1},
+    {0, 13, 276, 1},
+    {203, 37, 276, 1},
+    {0, 14, 277, 1},
+    {202, 38, 277, 1},
+    {0, 15, 278, 1},
+    {201, 39, 278, 1},
+    {0, 16, 279, 1},
+    {140, 100, 279, 1},
+    {0, 17, 280, 1},
+    {139, 101, 280, 1},
+    {0, 18, 281, 1},
+    {138, 102, 281, 1},
+    {0, 19, 282, 1},
+    {137, 103, 282, 1},
+    {0, 20, 283, 1},
+    {136, 104, 283, 1},
+    {0, 21, 284, 1},
+    {135, 105, 284, 1},
+    {0, 22, 285, 1},
+    {134, 106, 285, 1},
+    {0, 23, 286, 1},
+    {133, 107, 286, 1},
+    {0, 24, 287, 1},
+    {132, 108, 287, 1},
+    {0, 25, 288, 1},
+    {131, 109, 288, 1},
+    {0, 26, 289, 1},
+    {130, 110, 289, 1},
+    {0, 27, 290, 1},
+    {129, 111, 290, 1},
+    {0, 28, 291, 1},
+    {128, 112, 291, 1},
+    {0, 29, 292, 1},
+    {127, 113, 292, 1},
+    {0, 30, 293, 1},
+    {126, 114, 293, 1},
+    {0, 240, 294, 10},
+};
+const SkvecRuns skvecRuns_borderTypeDefault = {
+    skvecRunData_borderTypeDefault, 120, 0, 303};
+
+// skvec_borderTypeGame: 6 shapes, 66 runs
+const SkvecRun skvecRunData_borderTypeGame[] = {
+    {2, 1, 59, 1},
+    {2, 2, 60, 1},
+    {2, 3, 61, 1},
+    {2, 4, 62, 1},
+    {2, 5, 63, 1},
+    {2, 6, 64, 1},
+    {2, 7, 65, 1},
+    {2, 8, 66, 1},
+    {2, 9, 67, 1},
+    {2, 10, 68, 1},
+    {2, 11, 69, 1},
+    {2, 12, 70, 1},
+    {2, 13, 71, 1},
+    {2, 14, 72, 1},
+    {2, 15, 73, 1},
+    {2, 16, 74, 1},
+    {3, 15, 75, 79},
+    {237, 1, 79, 1},
+    {236, 2, 80, 1},
+    {235, 3, 81, 1},
+    {234, 4, 82, 1},
+    {233, 5, 83, 1},
+    {232, 6, 84, 1},
+    {231, 7, 85, 1},
+    {230, 8, 86, 1},
+    {229, 9, 87, 1},
+    {228, 10, 88, 1},
+    {227, 11, 89, 1},
+    {226, 12, 90, 1},
+    {225, 13, 91, 1},
+    {224, 14, 92, 1},
+    {223, 15, 93, 1},
+    {222, 16, 94, 1},
+    {222, 15, 95, 79},
+    {2, 16, 154, 1},
+    {2, 15, 155, 1},
+    {2, 14, 156, 1},
+    {2, 13, 157, 1},
+    {2, 12, 158, 1},
+    {2, 11, 159, 1},
+    {2, 10, 160, 1},
+    {2, 9, 161, 1},
+    {2, 8, 162, 1},
+    {2, 7, 163, 1},
+    {2, 6, 164, 1},
+    {2, 5, 165, 1},
+    {2, 4, 166, 1},
+    {2, 3, 167, 1},
+    {2, 2, 168, 1},
+    {2, 1, 169, 1},
+    {222, 16, 174, 1},
+    {223, 15, 175, 1},
+    {224, 14, 176, 1},
+    {225, 13, 177, 1},
+    {226, 12, 178, 1},
+    {227, 11, 179, 1},
+    {228, 10, 180, 1},
+    {229, 9, 181, 1},
+    {230, 8, 182, 1},
+    {231, 7, 183, 1},
+    {232, 6, 184, 1},
+    {233, 5, 185, 1},
+    {234, 4, 186, 1},
+    {235, 3, 187, 1},
+    {236, 2, 188, 1},
+    {237, 1, 189, 1},
+};
+const SkvecRuns skvecRuns_borderTypeGame = {
+    skvecRunData_borderTypeGame, 66, 59, 189};
+
+// skvec_gameNameBlock: 4 shapes, 31 runs
+const SkvecRun skvecRunData_gameNameBlock[] = {
+    {0, 145, 0, 1},
+    {0, 146, 1, 1},
+    {0, 147, 2, 1},
+    {0, 148, 3, 1},
+    {0, 149, 4, 1},
+    {0, 150, 5, 1},
+    {0, 151, 6, 1},
+    {0, 152, 7, 1},
+    {0, 153, 8, 1},
+    {0, 154, 9, 1},
+    {0, 155, 10, 1},
+    {0, 156, 11, 1},
+    {0, 157, 12, 1},
+    {0, 158, 13, 1},
+    {0, 159, 14, 1},
+    {0, 160, 15, 10},
+    {1, 159, 25, 1},
+    {2, 158, 26, 1},
+    {3, 157, 27, 1},
+    {4, 156, 28, 1},
+    {5, 155, 29, 1},
+    {6, 154, 30, 1},
+    {7, 153, 31, 1},
+    {8, 152, 32, 1},
+    {9, 151, 33, 1},
+    {10, 150, 34, 1},
+    {11, 149, 35, 1},
+    {12, 148, 36, 1},
+    {13, 147, 37, 1},
+    {14, 146, 38, 1},
+    {15, 145, 39, 1},
+};
+const SkvecRuns skvecRuns_gameNameBlock = {
+    skvecRunData_gameNameBlock, 31, 0, 39};
+
+// skvec_playerBar: 3 shapes, 13 runs
+const SkvecRun skvecRunData_playerBar[] = {
+    {35, 171, 27, 1},
+    {34, 173, 28, 1},
+    {32, 177, 29, 1},
+    {31, 179, 30, 1},
+    {29, 183, 31, 1},
+    {28, 185, 32, 1},
+    {26, 189, 33, 1},
+    {27, 187, 34, 1},
+    {29, 183, 35, 1},
+    {30, 181, 36, 1},
+    {32, 177, 37, 1},
+    {33, 175, 38, 1},
+    {35, 171, 39, 1},
+};
+const SkvecRuns skvecRuns_playerBar = {
+    skvecRunData_playerBar, 13, 27, 39};
+
+// skvec_bluetooth: 5 shapes, 17 runs
+const SkvecRun skvecRunData_bluetooth[] = {
+    {3, 1, 0, 1},
+    {3, 2, 1, 1},
+    {3, 1, 2, 3},
+    {5, 1, 2, 1},
+    {0, 1, 3, 1},
+    {6, 1, 3, 1},
+    {1, 1, 4, 1},
+    {5, 1, 4, 1},
+    {2, 3, 5, 2},
+    {1, 1, 7, 1},
+    {3, 1, 7, 4},
+    {5, 1, 7, 1},
+    {0, 1, 8, 1},
+    {6, 1, 8, 2},
+    {5, 1, 10, 1},
+    {3, 2, 11, 1},
+    {3, 1, 12, 1},
+};
+const SkvecRuns skvecRuns_bluetooth = {
+    skvecRunData_bluetooth, 17, 0, 12};
+
+// skvec_btCross: 2 shapes, 17 runs
+const SkvecRun skvecRunData_btCross[] = {
+    {0, 1, 0, 1},
+    {8, 1, 0, 1},
+    {1, 1, 1, 2},
+    {7, 1, 1, 2},
+    {2, 1, 3, 2},
+    {6, 1, 3, 2},
+    {3, 1, 5, 2},
+    {5, 1, 5, 2},
+    {4, 1, 7, 1},
+    {3, 1, 8, 2},
+    {5, 1, 8, 2},
+    {2, 1, 10, 2},
+    {6, 1, 10, 2},
+    {1, 1, 12, 2},
+    {7, 1, 12, 2},
+    {0, 1, 14, 1},
+    {8, 1, 14, 1},
+};
+const SkvecRuns skvecRuns_btCross = {
+    skvecRunData_btCross, 17, 0, 14};
+
+// skvec_battery: 2 shapes, 6 runs
+const SkvecRun skvecRunData_battery[] = {
+    {0, 20, 0, 1},
+    {0, 1, 1, 8},
+    {19, 1, 1, 1},
+    {19, 3, 2, 6},
+    {19, 1, 8, 1},
+    {0, 20, 9, 1},
+};
+const SkvecRuns skvecRuns_battery = {
+    skvecRunData_battery, 6, 0, 9};
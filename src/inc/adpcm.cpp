@@ -0,0 +1,125 @@
+/*
+Skirmish ESP32 Firmware
+
+IMA-ADPCM decoder
+
+Decodes blocks of IMA-ADPCM WAV files (format tag 0x11) as written by
+scripts/encode_audio.py. It doesn't depend on the Arduino framework so
+it can be built and checked on the host.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "adpcm.h"
+
+const int16_t adpcmStepTable[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+const int8_t adpcmIndexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                    -1, -1, -1, -1, 2, 4, 6, 8};
+
+/**
+ * Checks if blocks of a file can be decoded: they must hold whole groups
+ * of 8 samples per channel and fit into ADPCM_MAX_BLOCK_FRAMES frames
+ * (e.g. 512 byte mono blocks hold 1017 frames and are rejected)
+ *
+ * @param blockAlign size of a block in bytes
+ * @param channels amount of channels (1 or 2)
+ * @return true if adpcmDecodeBlock() can decode the blocks
+ */
+bool adpcmBlockAlignValid(uint16_t blockAlign, uint8_t channels) {
+    if (channels < 1 || channels > 2) return false;
+    if (blockAlign <= 4 * channels || blockAlign > ADPCM_MAX_BLOCK_ALIGN)
+        return false;
+    if ((blockAlign - 4 * channels) % (4 * channels) != 0) return false;
+    return adpcmBlockFrames(blockAlign, channels) <= ADPCM_MAX_BLOCK_FRAMES;
+}
+
+/**
+ * Returns the amount of frames contained in one block
+ *
+ * @param blockAlign size of a block in bytes
+ * @param channels amount of channels
+ */
+uint16_t adpcmBlockFrames(uint16_t blockAlign, uint8_t channels) {
+    return (blockAlign - 4 * channels) * 2 / channels + 1;
+}
+
+/**
+ * Decodes a single nibble and updates the channel state
+ */
+static inline int16_t adpcmDecodeNibble(uint8_t nibble, int32_t* predictor,
+                                        int8_t* index) {
+    int32_t step = adpcmStepTable[*index];
+    int32_t diff = step >> 3;
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+
+    if (nibble & 8)
+        *predictor -= diff;
+    else
+        *predictor += diff;
+
+    if (*predictor > 32767)
+        *predictor = 32767;
+    else if (*predictor < -32768)
+        *predictor = -32768;
+
+    *index += adpcmIndexTable[nibble];
+    if (*index < 0)
+        *index = 0;
+    else if (*index > 88)
+        *index = 88;
+
+    return (int16_t)*predictor;
+}
+
+/**
+ * Decodes one block into interleaved 16 bit PCM frames.
+ *
+ * @param block the ADPCM block
+ * @param blockAlign size of the block in bytes
+ * @param channels amount of channels (1 or 2)
+ * @param [out] out PCM output, must hold adpcmBlockFrames() frames
+ * @return amount of decoded frames
+ */
+uint16_t adpcmDecodeBlock(const uint8_t* block, uint16_t blockAlign,
+                          uint8_t channels, int16_t* out) {
+    int32_t predictor[2];
+    int8_t index[2];
+
+    // Block header: first sample and step index of every channel
+    for (uint8_t c = 0; c < channels; c++) {
+        predictor[c] = (int16_t)(block[c * 4] | (block[c * 4 + 1] << 8));
+        index[c] = block[c * 4 + 2];
+        if (index[c] > 88) index[c] = 88;
+        out[c] = (int16_t)predictor[c];
+    }
+
+    // Data: 4 bytes (8 samples) per channel, interleaved
+    uint16_t frames = adpcmBlockFrames(blockAlign, channels);
+    const uint8_t* data = block + 4 * channels;
+    for (uint16_t frame = 1; frame < frames; frame += 8) {
+        for (uint8_t c = 0; c < channels; c++) {
+            for (uint8_t i = 0; i < 4; i++) {
+                uint8_t byte = *data++;
+                int16_t* sample = &out[(frame + i * 2) * channels + c];
+                sample[0] = adpcmDecodeNibble(byte & 0x0f, &predictor[c],
+                                              &index[c]);
+                sample[channels] =
+                    adpcmDecodeNibble(byte >> 4, &predictor[c], &index[c]);
+            }
+        }
+    }
+
+    return frames;
+}
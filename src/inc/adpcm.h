@@ -0,0 +1,21 @@
+/*
+Skirmish ESP32 Firmware
+
+IMA-ADPCM decoder - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// Largest supported block (256 bytes per channel, stereo) and the
+// amount of frames it contains. Must match scripts/encode_audio.py.
+#define ADPCM_MAX_BLOCK_ALIGN 512
+#define ADPCM_MAX_BLOCK_FRAMES 505
+
+bool adpcmBlockAlignValid(uint16_t blockAlign, uint8_t channels);
+uint16_t adpcmBlockFrames(uint16_t blockAlign, uint8_t channels);
+uint16_t adpcmDecodeBlock(const uint8_t* block, uint16_t blockAlign,
+                          uint8_t channels, int16_t* out);
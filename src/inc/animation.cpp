@@ -0,0 +1,130 @@
+/*
+Skirmish ESP32 Firmware
+
+UI animations
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "animation.h"
+
+#include <Arduino.h>
+
+/**
+ * Starts moving the value
+ *
+ * @param from start value
+ * @param to end value
+ * @param duration duration in milliseconds
+ * @param now current time (millis())
+ * @param easing EASE_* curve
+ */
+void Tween::begin(int32_t from, int32_t to, uint32_t duration, uint32_t now,
+                  uint8_t easing) {
+    this->from = from;
+    this->to = to;
+    this->start = now;
+    this->duration = duration;
+    this->easing = easing;
+}
+
+/**
+ * Jumps to a value without animation
+ *
+ * @param value the new value
+ */
+void Tween::set(int32_t value) {
+    from = value;
+    to = value;
+    duration = 0;
+}
+
+/**
+ * Evaluates the tween
+ *
+ * @param now current time (millis())
+ * @return the value at the given time
+ */
+int32_t Tween::value(uint32_t now) {
+    uint32_t elapsed = now - start;
+    if (elapsed >= duration) return to;
+
+    // Progress as 8 bit fixed point number
+    int32_t p = (elapsed << 8) / duration;
+    switch (easing) {
+        case EASE_OUT:
+            p = 256 - (((256 - p) * (256 - p)) >> 8);
+            break;
+        case EASE_IN_OUT:
+            if (p < 128) {
+                p = (2 * p * p) >> 8;
+            } else {
+                p = 256 - ((2 * (256 - p) * (256 - p)) >> 8);
+            }
+            break;
+    }
+
+    return from + (int32_t)(((int64_t)(to - from) * p) >> 8);
+}
+
+/**
+ * @return the value the tween ends with
+ */
+int32_t Tween::target() { return to; }
+
+/**
+ * @param now current time (millis())
+ * @return true if the value is still changing
+ */
+bool Tween::isRunning(uint32_t now) { return now - start < duration; }
+
+/**
+ * Blends two RGB565 colors
+ *
+ * @param from color at alpha 0
+ * @param to color at alpha 255
+ * @param alpha amount of the second color
+ * @return the blended color
+ */
+uint16_t blendColor(uint16_t from, uint16_t to, uint8_t alpha) {
+    uint16_t r = (((from >> 11) & 0x1f) * (255 - alpha) +
+                  ((to >> 11) & 0x1f) * alpha) / 255;
+    uint16_t g = (((from >> 5) & 0x3f) * (255 - alpha) +
+                  ((to >> 5) & 0x3f) * alpha) / 255;
+    uint16_t b = ((from & 0x1f) * (255 - alpha) + (to & 0x1f) * alpha) / 255;
+    return (r << 11) | (g << 5) | b;
+}
+
+/**
+ * Checks if an animation frame is due
+ *
+ * @param now current time (millis())
+ * @param displayBusy true if the display is still replaying the last frame
+ * @return true if a frame should be drawn, endFrame() has to be called
+ * after it was recorded
+ */
+bool SkirmishAnimator::beginFrame(uint32_t now, bool displayBusy) {
+    if ((int32_t)(now - nextFrame) < 0) return false;
+    nextFrame = now + ANIMATION_FRAME_INTERVAL;
+
+    if (displayBusy) {
+        dropped++;
+        return false;
+    }
+
+    frames++;
+    frameStart = micros();
+    return true;
+}
+
+/**
+ * Ends a frame, frames exceeding the budget push the next frames back
+ */
+void SkirmishAnimator::endFrame() {
+    uint32_t elapsed = micros() - frameStart;
+    if (elapsed <= ANIMATION_FRAME_BUDGET) return;
+
+    uint32_t skipped = elapsed / ANIMATION_FRAME_BUDGET;
+    nextFrame += skipped * ANIMATION_FRAME_INTERVAL;
+    dropped += skipped;
+}
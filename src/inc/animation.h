@@ -0,0 +1,62 @@
+/*
+Skirmish ESP32 Firmware
+
+UI animations - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../conf.h"
+
+#define EASE_LINEAR 0
+#define EASE_OUT 1     // Fast start, slow end
+#define EASE_IN_OUT 2  // Slow start and end
+
+/**
+ * A value moving from one number to another over time. Tweens are
+ * evaluated for the time of the frame they are drawn in, so a dropped
+ * frame never slows an animation down.
+ */
+class Tween {
+   private:
+    int32_t from = 0;
+    int32_t to = 0;
+    uint32_t start = 0;
+    uint32_t duration = 0;
+    uint8_t easing = EASE_LINEAR;
+
+   public:
+    void begin(int32_t from, int32_t to, uint32_t duration, uint32_t now,
+               uint8_t easing = EASE_OUT);
+    void set(int32_t value);
+
+    int32_t value(uint32_t now);
+    int32_t target();
+    bool isRunning(uint32_t now);
+};
+
+uint16_t blendColor(uint16_t from, uint16_t to, uint8_t alpha);
+
+/**
+ * Paces the animation frames of the UI. Frames are dropped while the
+ * display is still busy with the previous one, and frames that took longer
+ * than ANIMATION_FRAME_BUDGET to record make the animator skip the
+ * following ones, so animations never hold up the main loop.
+ */
+class SkirmishAnimator {
+   private:
+    uint32_t nextFrame = 0;
+    uint32_t frameStart = 0;
+
+   public:
+    // Statistics
+    uint32_t frames = 0;
+    uint32_t dropped = 0;
+
+    bool beginFrame(uint32_t now, bool displayBusy);
+    void endFrame();
+};
@@ -0,0 +1,77 @@
+/*
+Skirmish ESP32 Firmware
+
+Asset archive reader
+
+Validates and reads archives written by scripts/pack_assets.py (see
+assets.cpp). Nothing in the archive is trusted: the header, the index
+table and every asset must lie within the bytes that are available. It
+doesn't depend on the Arduino framework so it can be built and checked
+on the host.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "asset_archive.h"
+
+#include <string.h>
+
+/**
+ * Validates an archive and opens it
+ *
+ * @param [out] archive the opened archive
+ * @param data start of the archive
+ * @param available bytes that can be read from data
+ * @param [out] badAsset the first asset that is out of bounds
+ * @return ASSET_ARCHIVE_OK or the reason why it can't be opened
+ */
+uint8_t assetArchiveOpen(AssetArchive* archive, const void* data,
+                         uint32_t available, uint16_t* badAsset) {
+    const AssetArchiveHeader* header = (const AssetArchiveHeader*)data;
+    if (available < sizeof(*header) ||
+        memcmp(header->magic, ASSET_ARCHIVE_MAGIC, 4) != 0 ||
+        header->version != ASSET_ARCHIVE_VERSION ||
+        header->size < sizeof(*header) || header->size > available) {
+        return ASSET_ARCHIVE_BAD_HEADER;
+    }
+
+    // count is 16 bit, this can't overflow
+    uint32_t indexEnd =
+        sizeof(*header) + header->count * sizeof(AssetIndexEntry);
+    if (indexEnd > header->size) return ASSET_ARCHIVE_BAD_INDEX;
+
+    const AssetIndexEntry* index =
+        (const AssetIndexEntry*)((const uint8_t*)data + sizeof(*header));
+    for (uint16_t i = 0; i < header->count; i++) {
+        // Written so that offset + length can't wrap around
+        if (index[i].offset > header->size ||
+            index[i].length > header->size - index[i].offset) {
+            *badAsset = i;
+            return ASSET_ARCHIVE_OUT_OF_BOUNDS;
+        }
+    }
+
+    archive->data = (const uint8_t*)data;
+    archive->index = index;
+    archive->count = header->count;
+    archive->size = header->size;
+    return ASSET_ARCHIVE_OK;
+}
+
+/**
+ * Returns a pointer to an asset of an opened archive
+ *
+ * @param archive the archive
+ * @param id index of the asset
+ * @param [out] data pointer to the asset data
+ * @param [out] length length of the asset data in bytes
+ * @return false if the archive has no such asset
+ */
+bool assetArchiveGet(const AssetArchive* archive, uint16_t id,
+                     const uint8_t** data, uint32_t* length) {
+    if (id >= archive->count) return false;
+
+    *data = archive->data + archive->index[id].offset;
+    *length = archive->index[id].length;
+    return true;
+}
@@ -0,0 +1,48 @@
+/*
+Skirmish ESP32 Firmware
+
+Asset archive reader - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define ASSET_ARCHIVE_MAGIC "SKAR"
+#define ASSET_ARCHIVE_VERSION 1
+
+// Results of assetArchiveOpen()
+#define ASSET_ARCHIVE_OK 0
+#define ASSET_ARCHIVE_BAD_HEADER 1     // Magic, version or size
+#define ASSET_ARCHIVE_BAD_INDEX 2      // Index table exceeds the size
+#define ASSET_ARCHIVE_OUT_OF_BOUNDS 3  // An asset exceeds the size
+
+struct AssetArchiveHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+struct AssetIndexEntry {
+    uint32_t offset;
+    uint32_t length;
+};
+
+/**
+ * An opened archive, the data stays where it was opened from
+ */
+struct AssetArchive {
+    const uint8_t* data;
+    const AssetIndexEntry* index;
+    uint16_t count;
+    uint32_t size;
+};
+
+uint8_t assetArchiveOpen(AssetArchive* archive, const void* data,
+                         uint32_t available, uint16_t* badAsset);
+bool assetArchiveGet(const AssetArchive* archive, uint16_t id,
+                     const uint8_t** data, uint32_t* length);
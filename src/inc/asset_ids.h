@@ -0,0 +1,16 @@
+/*
+Skirmish ESP32 Firmware
+
+Asset IDs - generated by scripts/pack_assets.py, do not edit
+*/
+
+#pragma once
+
+#define ASSET_SOUND_BLASTER 0
+#define ASSET_SOUND_BOOTUP 1
+#define ASSET_SOUND_FIGHT 2
+#define ASSET_SOUND_ONE 3
+#define ASSET_SOUND_THREE 4
+#define ASSET_SOUND_TWO 5
+
+#define ASSET_COUNT 6
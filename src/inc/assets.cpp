@@ -0,0 +1,86 @@
+/*
+Skirmish ESP32 Firmware
+
+Asset archive
+
+The assets (currently the sounds) are packed into one archive by
+scripts/pack_assets.py and flashed to the "assets" partition. The
+partition is memory mapped, so assets can be accessed by their ID
+without any file system lookup or copying.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <inc/asset_archive.h>
+#include <inc/assets.h>
+#include <inc/log.h>
+
+#define ASSETS_PARTITION_SUBTYPE 0x40
+
+AssetArchive assetArchive = {NULL, NULL, 0, 0};
+
+spi_flash_mmap_handle_t assetMmapHandle;
+
+/**
+ * Maps the asset partition and validates the archive
+ *
+ * @return true if the archive can be used
+ */
+bool assetsInit() {
+    logInfo("Init: Assets");
+
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA,
+        (esp_partition_subtype_t)ASSETS_PARTITION_SUBTYPE, "assets");
+    if (partition == NULL) {
+        logError("-> No assets partition found");
+        return false;
+    }
+
+    const void *mapped;
+    if (esp_partition_mmap(partition, 0, partition->size,
+                           SPI_FLASH_MMAP_DATA, &mapped,
+                           &assetMmapHandle) != ESP_OK) {
+        logError("-> Mapping the assets partition failed");
+        return false;
+    }
+
+    uint16_t badAsset = 0;
+    switch (assetArchiveOpen(&assetArchive, mapped, partition->size,
+                             &badAsset)) {
+        case ASSET_ARCHIVE_OK:
+            break;
+        case ASSET_ARCHIVE_OUT_OF_BOUNDS:
+            logError("-> Asset %d is out of bounds", badAsset);
+            spi_flash_munmap(assetMmapHandle);
+            return false;
+        default:
+            logError("-> Invalid asset archive, run the uploadassets target");
+            spi_flash_munmap(assetMmapHandle);
+            return false;
+    }
+
+    if (assetArchive.count != ASSET_COUNT) {
+        logWarn("-> Asset archive contains %d assets, expected %d",
+                assetArchive.count, ASSET_COUNT);
+    }
+
+    logDebug("-> Mapped %d assets (%lu bytes)", assetArchive.count,
+             (unsigned long)assetArchive.size);
+    return true;
+}
+
+/**
+ * Returns a pointer to an asset. The data stays valid and is read
+ * directly from flash.
+ *
+ * @param id asset ID (ASSET_* in asset_ids.h)
+ * @param [out] data pointer to the asset data
+ * @param [out] length length of the asset data in bytes
+ * @return false if the asset is not available
+ */
+bool assetGet(uint16_t id, const uint8_t **data, uint32_t *length) {
+    return assetArchiveGet(&assetArchive, id, data, length);
+}
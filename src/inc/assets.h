@@ -0,0 +1,16 @@
+/*
+Skirmish ESP32 Firmware
+
+Asset archive - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "asset_ids.h"
+
+bool assetsInit();
+bool assetGet(uint16_t id, const uint8_t** data, uint32_t* length);
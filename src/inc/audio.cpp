@@ -3,26 +3,107 @@ Skirmish ESP32 Firmware
 
 Audio driver
 
+Clips are IMA-ADPCM WAV files from the asset archive (see
+scripts/pack_assets.py) which are decoded while playing. They are played
+on one of MIXER_VOICES voices. Each voice runs its own WAV generator (or
+the blaster synthesizer) into a block buffer, the audio task sums up the
+blocks of all active voices and writes the result to the I2S output.
+When all voices are busy, a new clip replaces the oldest clip with the
+lowest priority that isn't higher than its own.
+
 Copyright (C) 2023 Ole Lange
 */
 
-#include <SPIFFS.h>
 #include <conf.h>
+#include <inc/assets.h>
 #include <inc/audio.h>
+#include <inc/audio_source_adpcm.h>
+#include <inc/battery.h>
+#include <inc/blaster_synth.h>
+#include <inc/diagnostics.h>
 #include <inc/log.h>
+#include <inc/mixer.h>
+#include <inc/power.h>
+#include <inc/sound_bank.h>
 
-#include "AudioFileSourceSPIFFS.h"
+#include "AudioFileSourcePROGMEM.h"
 #include "AudioGeneratorWAV.h"
 #include "AudioOutputI2S.h"
 
-AudioGeneratorWAV *wav;
-AudioFileSourceSPIFFS *file;
+// Where the samples of a voice come from
+#define VOICE_SOURCE_RAM 0
+#define VOICE_SOURCE_FLASH 1
+#define VOICE_SOURCE_SYNTH 2
+const char *voiceSourceNames[] = {"RAM", "flash", "synth"};
+
+/**
+ * Audio output that collects the samples of one voice into a block
+ * buffer which is then summed up by the mixer.
+ */
+class VoiceOutput : public AudioOutput {
+   public:
+    int16_t block[MIXER_BLOCK_FRAMES * 2];
+    uint16_t frames = 0;
+
+    bool begin() override { return true; }
+    bool stop() override { return true; }
+
+    bool ConsumeSample(int16_t sample[2]) override {
+        if (frames >= MIXER_BLOCK_FRAMES) return false;
+
+        int16_t ms[2] = {sample[0], sample[1]};
+        MakeSampleStereo16(ms);
+        block[frames * 2] = ms[LEFTCHANNEL];
+        block[frames * 2 + 1] = ms[RIGHTCHANNEL];
+        frames++;
+        return true;
+    }
+};
+
+struct AudioVoice {
+    AudioGeneratorWAV wav;
+    AudioFileSourcePROGMEM memorySource;
+    AudioFileSourceADPCM adpcmSource;
+    BlasterSynth synth;
+    VoiceOutput output;
+
+    bool active = false;
+    uint8_t source;
+    uint8_t priority;
+    uint16_t gain;
+    uint32_t startedAt;
+
+    // Trigger-to-first-sample measurement
+    uint32_t triggeredAt;
+    bool waitingForFirstSample;
+};
+
+struct AudioPlayRequest {
+    uint16_t assetId;
+    bool synth;
+    BlasterSynthParams synthParams;
+    uint8_t priority;
+    uint16_t gain;
+    uint32_t triggeredAt;
+};
+
+AudioVoice *voices;
 AudioOutputI2S *out;
+QueueHandle_t playQueue;
+
+// Mixed block that is currently handed to the I2S output
+int16_t mixedBlock[MIXER_BLOCK_FRAMES * 2];
+uint16_t mixedBlockPosition = MIXER_BLOCK_FRAMES;
 
 bool isPlaying = false;
 
+// Worst trigger-to-first-sample latency seen so far per voice source
+// (in microseconds)
+uint32_t maxLatency[3] = {0, 0, 0};
+
 /**
- * Initializes the audio driver
+ * Initializes the audio driver. The asset archive must be initialized
+ * as the sound bank is loaded from it.
  *
  * @param gain audio gain [0-1]
  */
@@ -33,41 +114,255 @@ void audioInit(float gain) {
     digitalWrite(PIN_SPK_EN, 1);
     logInfo("-> Enabled Speaker Amplifier");
 
-    wav = new AudioGeneratorWAV();
+    voices = new AudioVoice[MIXER_VOICES];
+    playQueue = xQueueCreate(MIXER_VOICES, sizeof(AudioPlayRequest));
+
     out = new AudioOutputI2S();
     out->SetPinout(PIN_SPK_BCLK, PIN_SPK_LRCLK, PIN_SPK_DIN);
     out->SetGain(gain);
+    out->SetRate(MIXER_SAMPLE_RATE);
+    out->SetBitsPerSample(16);
+    out->SetChannels(2);
+    out->begin();
+    logDebug("-> Mixer: %d voices, %d frames per block", MIXER_VOICES,
+             MIXER_BLOCK_FRAMES);
+
+    soundBankInit();
 
     logDebug("-> Audio Init done");
 }
 
 /**
- * Begins playing the specified audio file
+ * Begins playing the specified clip on a free voice. Clips resident in
+ * the sound bank are played from RAM, all others are streamed from the
+ * asset archive in flash. The clip is started by the audio task.
+ *
+ * @param assetId asset ID of the clip (ASSET_SOUND_*)
+ * @param priority clip priority, see AUDIO_PRIORITY_*
+ * @param gain voice gain [0-1]
+ */
+void audioBegin(uint16_t assetId, uint8_t priority, float gain) {
+    AudioPlayRequest request;
+    request.assetId = assetId;
+    request.synth = false;
+    request.priority = priority;
+    request.gain = mixerGain(gain);
+    request.triggeredAt = micros();
+    if (xQueueSend(playQueue, &request, 0) != pdTRUE) {
+        logWarn("Audio: play queue full, dropping asset %d", assetId);
+    }
+}
+
+/**
+ * Begins playing a synthesized blaster sound on a free voice. The
+ * sound is rendered by the audio task without any flash access.
+ *
+ * @param params sound parameters
+ * @param priority clip priority, see AUDIO_PRIORITY_*
+ * @param gain voice gain [0-1]
+ */
+void audioBeginSynth(const BlasterSynthParams *params, uint8_t priority,
+                     float gain) {
+    AudioPlayRequest request;
+    request.synth = true;
+    request.synthParams = *params;
+    request.priority = priority;
+    request.gain = mixerGain(gain);
+    request.triggeredAt = micros();
+    if (xQueueSend(playQueue, &request, 0) != pdTRUE) {
+        logWarn("Audio: play queue full, dropping synthesized sound");
+    }
+}
+
+/**
+ * Selects the voice for a new clip: a free voice if there is one,
+ * otherwise the oldest voice with the lowest priority which is not
+ * higher than the priority of the new clip.
  *
- * @param filename spiffs path of the audio file
+ * @param priority priority of the new clip
+ * @return the voice or NULL if the clip should be dropped
  */
-void audioBegin(const char *filename) {
-    if (isPlaying) {
-        wav->stop();
-        isPlaying = false;
+AudioVoice *audioSelectVoice(uint8_t priority) {
+    AudioVoice *candidate = NULL;
+    for (uint8_t i = 0; i < MIXER_VOICES; i++) {
+        AudioVoice *voice = &voices[i];
+        if (!voice->active) return voice;
+        if (voice->priority > priority) continue;
+
+        if (candidate == NULL || voice->priority < candidate->priority ||
+            (voice->priority == candidate->priority &&
+             voice->startedAt < candidate->startedAt)) {
+            candidate = voice;
+        }
     }
-    file = new AudioFileSourceSPIFFS(filename);
-    wav->begin(file, out);
-    isPlaying = true;
+    return candidate;
 }
 
 /**
- * Keeps the current audio file playing.
+ * Starts a requested clip. Called from the audio task.
+ */
+void audioStartVoice(AudioPlayRequest *request) {
+    AudioVoice *voice = audioSelectVoice(request->priority);
+    if (voice == NULL) {
+        logDebug("Audio: no voice for new clip");
+        return;
+    }
+
+    if (voice->active && voice->source != VOICE_SOURCE_SYNTH) {
+        voice->wav.stop();
+    }
+    voice->output.frames = 0;
+
+    const uint8_t *data;
+    uint32_t length;
+    if (request->synth) {
+        voice->source = VOICE_SOURCE_SYNTH;
+        blasterSynthStart(&voice->synth, &request->synthParams,
+                          MIXER_SAMPLE_RATE);
+        voice->active = true;
+    } else {
+        voice->source = soundBankLookup(request->assetId, &data, &length)
+                            ? VOICE_SOURCE_RAM
+                            : VOICE_SOURCE_FLASH;
+        if (voice->source == VOICE_SOURCE_RAM ||
+            assetGet(request->assetId, &data, &length)) {
+            voice->memorySource.open(data, length);
+            voice->active = voice->adpcmSource.open(&voice->memorySource);
+        } else {
+            logWarn("Audio: asset %d not found", request->assetId);
+            voice->active = false;
+        }
+        if (voice->active) {
+            voice->active =
+                voice->wav.begin(&voice->adpcmSource, &voice->output);
+            if (!voice->active) voice->adpcmSource.close();
+        }
+    }
+
+    voice->priority = request->priority;
+    voice->gain = request->gain;
+    voice->startedAt = millis();
+    voice->triggeredAt = request->triggeredAt;
+    voice->waitingForFirstSample = true;
+}
+
+/**
+ * Logs the trigger-to-first-sample latency of a voice
+ */
+void audioLogLatency(AudioVoice *voice) {
+    uint32_t latency = micros() - voice->triggeredAt;
+    if (latency > maxLatency[voice->source])
+        maxLatency[voice->source] = latency;
+    diagnosticsLatency(DIAG_LATENCY_AUDIO, latency);
+
+    logDebug("Audio trigger-to-first-sample (%s): %lu us (max %lu us)",
+             voiceSourceNames[voice->source], (unsigned long)latency,
+             (unsigned long)maxLatency[voice->source]);
+}
+
+/**
+ * Renders one block of every active voice and mixes them into the
+ * mixedBlock buffer.
+ *
+ * @return false if no voice is active
+ */
+bool audioMixBlock() {
+    const int16_t *blocks[MIXER_VOICES];
+    uint16_t gains[MIXER_VOICES];
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < MIXER_VOICES; i++) {
+        AudioVoice *voice = &voices[i];
+        if (!voice->active) continue;
+
+        if (voice->source == VOICE_SOURCE_SYNTH) {
+            // The synthesizer renders directly into the voice block
+            voice->output.frames = blasterSynthRender(
+                &voice->synth, voice->output.block, MIXER_BLOCK_FRAMES);
+            if (voice->output.frames < MIXER_BLOCK_FRAMES)
+                voice->active = false;
+        } else if (!voice->wav.loop()) {
+            // The generator stops as soon as the voice block is full
+            // or the clip has ended
+            voice->wav.stop();
+            voice->active = false;
+        }
+
+        if (voice->output.frames == 0) continue;
+
+        // Pad the last block of a clip with silence
+        for (uint16_t f = voice->output.frames; f < MIXER_BLOCK_FRAMES; f++) {
+            voice->output.block[f * 2] = 0;
+            voice->output.block[f * 2 + 1] = 0;
+        }
+        voice->output.frames = 0;
+
+        if (voice->waitingForFirstSample) {
+            voice->waitingForFirstSample = false;
+            audioLogLatency(voice);
+        }
+
+        blocks[count] = voice->output.block;
+        gains[count] = voice->gain;
+        count++;
+    }
+
+    if (count == 0) return false;
+
+    mixerMixBlock(mixedBlock, blocks, gains, count, MIXER_BLOCK_FRAMES * 2);
+    mixedBlockPosition = 0;
+    return true;
+}
+
+/**
+ * Hands the mixed block to the I2S output
+ *
+ * @return false if the I2S DMA buffers are full
+ */
+bool audioPushBlock() {
+    while (mixedBlockPosition < MIXER_BLOCK_FRAMES) {
+        if (!out->ConsumeSample(&mixedBlock[mixedBlockPosition * 2]))
+            return false;
+        mixedBlockPosition++;
+    }
+    return true;
+}
+
+/**
+ * Audio task: starts requested clips, mixes the active voices and
+ * keeps the I2S output fed.
  */
 void audioLoopTask(void *param) {
+    AudioPlayRequest request;
     while (1) {
-        if (!isPlaying) continue;
+        if (!audioPushBlock()) {
+            // Wait for the I2S DMA to make space
+            vTaskDelay(1);
+            continue;
+        }
 
-        if (!wav->isRunning()) {
-            isPlaying = false;
+        while (xQueueReceive(playQueue, &request, 0) == pdTRUE) {
+            audioStartVoice(&request);
+        }
+
+        if (audioMixBlock()) {
+            if (!isPlaying) {
+                out->begin();
+                isPlaying = true;
+                batterySetLoad(BATTERY_LOAD_AUDIO, true);
+                powerAcquire(POWER_LOCK_AUDIO);
+            }
             continue;
         }
 
-        if (!wav->loop()) wav->stop();
+        // Nothing to play: silence the output and sleep until the
+        // next clip is requested
+        if (isPlaying) {
+            out->stop();
+            isPlaying = false;
+            batterySetLoad(BATTERY_LOAD_AUDIO, false);
+            powerRelease(POWER_LOCK_AUDIO);
+        }
+        xQueuePeek(playQueue, &request, portMAX_DELAY);
     }
-}
\ No newline at end of file
+}
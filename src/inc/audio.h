@@ -8,6 +8,20 @@ Copyright (C) 2023 Ole Lange
 
 #pragma once
 
+#include <stdint.h>
+
+#include "asset_ids.h"
+#include "blaster_synth.h"
+
+// Clip priorities. A clip can only replace clips with the same or a
+// lower priority when all mixer voices are busy.
+#define AUDIO_PRIORITY_EFFECT 0
+#define AUDIO_PRIORITY_CUE 1
+
 void audioInit(float gain);
-void audioBegin(const char* filename);
-void audioLoopTask(void* param);
\ No newline at end of file
+void audioBegin(uint16_t assetId,
+                uint8_t priority = AUDIO_PRIORITY_EFFECT, float gain = 1.0);
+void audioBeginSynth(const BlasterSynthParams* params,
+                     uint8_t priority = AUDIO_PRIORITY_EFFECT,
+                     float gain = 1.0);
+void audioLoopTask(void* param);
@@ -0,0 +1,194 @@
+/*
+Skirmish ESP32 Firmware
+
+IMA-ADPCM audio source
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <Arduino.h>
+#include <inc/audio_source_adpcm.h>
+#include <inc/log.h>
+
+#define WAV_FORMAT_IMA_ADPCM 0x11
+
+/**
+ * Writes a little endian 16/32 bit value into a buffer
+ */
+static void putU16(uint8_t *buf, uint16_t val) {
+    buf[0] = val & 0xff;
+    buf[1] = val >> 8;
+}
+
+static void putU32(uint8_t *buf, uint32_t val) {
+    putU16(buf, val & 0xffff);
+    putU16(buf + 2, val >> 16);
+}
+
+/**
+ * Opens an IMA-ADPCM WAV file. The source must already be opened and
+ * positioned at the start of the file.
+ *
+ * @param source the source containing the ADPCM file
+ * @return true if the file is a supported ADPCM file
+ */
+bool AudioFileSourceADPCM::open(AudioFileSource *source) {
+    this->source = source;
+    pos = 0;
+    pcmBytes = 0;
+    pcmOffset = 0;
+
+    if (!readHeader()) {
+        logError("ADPCM: unsupported file");
+        close();
+        return false;
+    }
+
+    // Synthesize the header of the PCM stream
+    uint32_t dataSize = framesLeft * channels * 2;
+    size = sizeof(header) + dataSize;
+    memcpy(header, "RIFF", 4);
+    putU32(header + 4, size - 8);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    putU32(header + 16, 16);
+    putU16(header + 20, 1);  // PCM
+    putU16(header + 22, channels);
+    putU32(header + 24, sampleRate);
+    putU32(header + 28, sampleRate * channels * 2);
+    putU16(header + 32, channels * 2);
+    putU16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    putU32(header + 40, dataSize);
+
+    return true;
+}
+
+/**
+ * Parses the RIFF header of the ADPCM file and leaves the source
+ * positioned at the start of the data chunk.
+ */
+bool AudioFileSourceADPCM::readHeader() {
+    uint8_t buf[20];
+    if (source->read(buf, 12) != 12) return false;
+    if (memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool hasFormat = false;
+    framesLeft = 0xffffffff;
+    while (source->read(buf, 8) == 8) {
+        uint32_t chunkSize = buf[4] | (buf[5] << 8) | (buf[6] << 16) |
+                             ((uint32_t)buf[7] << 24);
+
+        if (memcmp(buf, "data", 4) == 0) {
+            if (!hasFormat) return false;
+            // Without a fact chunk decode everything in the data chunk
+            uint32_t dataFrames = (chunkSize / blockAlign) *
+                                  adpcmBlockFrames(blockAlign, channels);
+            if (dataFrames < framesLeft) framesLeft = dataFrames;
+            return true;
+        }
+
+        if (memcmp(buf, "fmt ", 4) == 0 && chunkSize >= 16) {
+            if (source->read(buf, 16) != 16) return false;
+            chunkSize -= 16;
+
+            uint16_t format = buf[0] | (buf[1] << 8);
+            channels = buf[2] | (buf[3] << 8);
+            sampleRate = buf[4] | (buf[5] << 8) | (buf[6] << 16) |
+                         ((uint32_t)buf[7] << 24);
+            blockAlign = buf[12] | (buf[13] << 8);
+
+            if (format != WAV_FORMAT_IMA_ADPCM || buf[3] != 0) return false;
+            if (!adpcmBlockAlignValid(blockAlign, channels)) return false;
+            hasFormat = true;
+        } else if (memcmp(buf, "fact", 4) == 0 && chunkSize >= 4) {
+            if (source->read(buf, 4) != 4) return false;
+            chunkSize -= 4;
+            framesLeft = buf[0] | (buf[1] << 8) | (buf[2] << 16) |
+                         ((uint32_t)buf[3] << 24);
+        }
+
+        // Skip the rest of the chunk (chunks are word aligned)
+        chunkSize += chunkSize & 1;
+        while (chunkSize > 0) {
+            uint32_t n = chunkSize > sizeof(buf) ? sizeof(buf) : chunkSize;
+            if (source->read(buf, n) != n) return false;
+            chunkSize -= n;
+        }
+    }
+    return false;
+}
+
+/**
+ * Reads and decodes the next block into the pcm buffer
+ *
+ * @return false if the end of the file was reached
+ */
+bool AudioFileSourceADPCM::decodeNextBlock() {
+    if (framesLeft == 0) return false;
+    if (source->read(block, blockAlign) != blockAlign) return false;
+
+    uint32_t frames = adpcmDecodeBlock(block, blockAlign, channels, pcm);
+    if (frames > framesLeft) frames = framesLeft;
+    framesLeft -= frames;
+
+    pcmBytes = frames * channels * 2;
+    pcmOffset = 0;
+    return true;
+}
+
+uint32_t AudioFileSourceADPCM::read(void *data, uint32_t len) {
+    uint8_t *out = (uint8_t *)data;
+    uint32_t done = 0;
+
+    while (done < len) {
+        uint32_t n;
+        if (pos < sizeof(header)) {
+            n = sizeof(header) - pos;
+            if (n > len - done) n = len - done;
+            memcpy(out + done, header + pos, n);
+        } else {
+            if (pcmOffset >= pcmBytes && !decodeNextBlock()) break;
+            n = pcmBytes - pcmOffset;
+            if (n > len - done) n = len - done;
+            memcpy(out + done, (uint8_t *)pcm + pcmOffset, n);
+            pcmOffset += n;
+        }
+        done += n;
+        pos += n;
+    }
+
+    return done;
+}
+
+/**
+ * Only forward seeking is supported, skipped data is decoded
+ * and discarded.
+ */
+bool AudioFileSourceADPCM::seek(int32_t pos, int dir) {
+    int32_t target = pos;
+    if (dir == SEEK_CUR) target = this->pos + pos;
+    if (dir == SEEK_END) target = size + pos;
+    if (target < (int32_t)this->pos) return false;
+
+    uint8_t discard[32];
+    while (this->pos < (uint32_t)target) {
+        uint32_t n = target - this->pos;
+        if (n > sizeof(discard)) n = sizeof(discard);
+        if (read(discard, n) != n) return false;
+    }
+    return true;
+}
+
+bool AudioFileSourceADPCM::close() {
+    if (source == NULL) return false;
+    source->close();
+    source = NULL;
+    return true;
+}
+
+bool AudioFileSourceADPCM::isOpen() { return source != NULL; }
+
+uint32_t AudioFileSourceADPCM::getSize() { return size; }
+
+uint32_t AudioFileSourceADPCM::getPos() { return pos; }
@@ -0,0 +1,51 @@
+/*
+Skirmish ESP32 Firmware
+
+IMA-ADPCM audio source - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "AudioFileSource.h"
+#include "adpcm.h"
+
+/**
+ * Audio source that reads an IMA-ADPCM WAV file from another source and
+ * provides it as a 16 bit PCM WAV stream, so it can be played by the
+ * AudioGeneratorWAV. Decoding is done block by block while reading.
+ */
+class AudioFileSourceADPCM : public AudioFileSource {
+   private:
+    AudioFileSource *source = NULL;
+
+    uint8_t channels;
+    uint32_t sampleRate;
+    uint16_t blockAlign;
+    uint32_t framesLeft;
+
+    // Synthesized PCM WAV header
+    uint8_t header[44];
+    uint32_t size;
+    uint32_t pos;
+
+    uint8_t block[ADPCM_MAX_BLOCK_ALIGN];
+    int16_t pcm[ADPCM_MAX_BLOCK_FRAMES * 2];
+    uint32_t pcmBytes;
+    uint32_t pcmOffset;
+
+    bool readHeader();
+    bool decodeNextBlock();
+
+   public:
+    bool open(AudioFileSource *source);
+    uint32_t read(void *data, uint32_t len) override;
+    bool seek(int32_t pos, int dir) override;
+    bool close() override;
+    bool isOpen() override;
+    uint32_t getSize() override;
+    uint32_t getPos() override;
+};
@@ -0,0 +1,242 @@
+/*
+Skirmish ESP32 Firmware
+
+Battery service
+
+Samples the battery voltage in the background (esp_timer task) and keeps
+a running sum of the last VBAT_SAMPLE_COUNT samples, so a sample costs
+one ADC conversion and reading the voltage or the charge is O(1). The
+voltage is interpolated between the measured ADC_AT_* points, with
+VBAT_DIVIDER_RATIO defined the eFuse calibration of the ADC is used on
+chips that have one.
+
+IR shots, audio and the vibration motor make the voltage sag. The tasks
+causing them mark them as active loads (batterySetLoad()), samples are
+compensated for the drop over the internal resistance of the battery.
+The charge is a load model integrating the estimated current, corrected
+slowly towards the charge of the compensated voltage, so it doesn't jump
+around during a game.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "battery.h"
+
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include <esp_timer.h>
+
+#include "../conf.h"
+#include "log.h"
+
+// Reference voltage of chips without eFuse calibration
+#define VBAT_DEFAULT_VREF 1100
+
+// Battery voltage at 1% to 100% charge
+static const uint16_t lipoCurve[100] = {
+    3270, 3338, 3407, 3476, 3544, 3610, 3626, 3643, 3659, 3675, 3690, 3694,
+    3698, 3702, 3706, 3710, 3714, 3718, 3722, 3726, 3730, 3734, 3738, 3742,
+    3746, 3751, 3755, 3759, 3763, 3767, 3771, 3775, 3779, 3783, 3787, 3790,
+    3792, 3794, 3796, 3798, 3801, 3805, 3809, 3813, 3817, 3821, 3825, 3829,
+    3833, 3837, 3841, 3843, 3845, 3847, 3849, 3852, 3856, 3860, 3864, 3868,
+    3874, 3882, 3891, 3899, 3907, 3915, 3923, 3931, 3939, 3947, 3954, 3960,
+    3966, 3972, 3978, 3986, 3994, 4002, 4010, 4018, 4029, 4041, 4053, 4066,
+    4078, 4085, 4091, 4097, 4103, 4109, 4117, 4125, 4133, 4141, 4149, 4159,
+    4169, 4179, 4189, 4200};
+
+// Current drawn by the BATTERY_LOAD_* loads
+static const uint16_t loadCurrents[] = {
+    BATTERY_IR_CURRENT, BATTERY_AUDIO_CURRENT, BATTERY_VIBRATION_CURRENT};
+
+// Bit field of the active loads, set by the tasks that cause them
+static portMUX_TYPE loadLock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint8_t activeLoads = 0;
+
+// Ring buffer of load compensated samples (millivolts) and their sum
+static uint16_t vbatValues[VBAT_SAMPLE_COUNT];
+static uint8_t vbatIndex = 0;
+static uint32_t vbatSum = 0;
+
+// Charge (0-1) estimated by integrating the load, slowly pulled towards
+// the charge the compensated voltage indicates
+static float charge = 0;
+
+static adc1_channel_t vbatChannel;
+#ifdef VBAT_DIVIDER_RATIO
+static esp_adc_cal_characteristics_t adcCharacteristics;
+static bool adcCalibrated = false;
+#endif
+static esp_timer_handle_t sampleTimer = NULL;
+
+// Filtered values, written by the sample timer
+static volatile uint16_t vbatMillivolts = 0;
+static volatile float vbatCharge = 0;
+
+/**
+ * Converts an ADC value to the battery voltage
+ *
+ * @param raw the ADC value
+ * @return the battery voltage in millivolts
+ */
+static uint16_t toMillivolts(int raw) {
+#ifdef VBAT_DIVIDER_RATIO
+    if (adcCalibrated) {
+        return esp_adc_cal_raw_to_voltage(raw, &adcCharacteristics) *
+               VBAT_DIVIDER_RATIO;
+    }
+#endif
+
+    // Interpolating between two measured points, far below 3.0 volts the
+    // line would go negative
+    float millivolts = 3000 + (((float)raw - ADC_AT_3000mV) /
+                               (ADC_AT_4200mV - ADC_AT_3000mV)) *
+                                  1200;
+    if (millivolts < 0) return 0;
+    if (millivolts > UINT16_MAX) return UINT16_MAX;
+    return millivolts;
+}
+
+/**
+ * Estimates the current drawn from the battery
+ *
+ * @param loads bit field of the active BATTERY_LOAD_* loads
+ * @return the current in mA
+ */
+static uint16_t loadCurrent(uint8_t loads) {
+    uint16_t current = BATTERY_BASE_CURRENT;
+    for (uint8_t i = 0; i < sizeof(loadCurrents) / sizeof(uint16_t); i++) {
+        if (loads & (1 << i)) current += loadCurrents[i];
+    }
+    return current;
+}
+
+/**
+ * Looks up the charge of an unloaded battery with a binary search in the
+ * discharge curve, interpolating between its points
+ *
+ * @param millivolts open circuit voltage
+ * @return the charge (0-1)
+ */
+static float chargeAt(uint16_t millivolts) {
+    if (millivolts < lipoCurve[0]) return 0;
+    if (millivolts >= lipoCurve[99]) return 1;
+
+    // lipoCurve[low] <= millivolts < lipoCurve[high]
+    uint8_t low = 0;
+    uint8_t high = 99;
+    while (high - low > 1) {
+        uint8_t mid = (low + high) / 2;
+        if (lipoCurve[mid] <= millivolts) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    float fraction = (float)(millivolts - lipoCurve[low]) /
+                     (lipoCurve[high] - lipoCurve[low]);
+    return (low + 1 + fraction) / 100;
+}
+
+/**
+ * Takes a sample, called by the esp_timer task every VBAT_SAMPLE_INTERVAL
+ * milliseconds
+ */
+static void sample(void *arg) {
+    uint8_t loads = activeLoads;
+    int raw = adc1_get_raw(vbatChannel);
+
+    // Samples taken while a load was switched are neither loaded nor
+    // unloaded, they are dropped
+    if (raw < 0 || loads != activeLoads) return;
+
+    // Adding the drop over the internal resistance to the loaded voltage
+    uint16_t current = loadCurrent(loads);
+    uint16_t millivolts =
+        toMillivolts(raw) +
+        (uint32_t)current * BATTERY_INTERNAL_RESISTANCE / 1000;
+
+    vbatSum += millivolts - vbatValues[vbatIndex];
+    vbatValues[vbatIndex] = millivolts;
+    vbatIndex = (vbatIndex + 1) % VBAT_SAMPLE_COUNT;
+    uint16_t average = (vbatSum + VBAT_SAMPLE_COUNT / 2) / VBAT_SAMPLE_COUNT;
+
+    // Load model, corrected by the voltage over BATTERY_SOC_TIME_CONSTANT
+    charge -= current * (VBAT_SAMPLE_INTERVAL / 3600000.0f) / BATTERY_CAPACITY;
+    charge += (chargeAt(average) - charge) *
+              (VBAT_SAMPLE_INTERVAL / (BATTERY_SOC_TIME_CONSTANT * 1000.0f));
+    charge = constrain(charge, 0.0f, 1.0f);
+
+    vbatMillivolts = average;
+    vbatCharge = charge;
+}
+
+/**
+ * Marks a load as active or inactive, samples taken while it is active
+ * are compensated for the current it draws
+ *
+ * @param load BATTERY_LOAD_*
+ * @param active true if the load is switched on
+ */
+void batterySetLoad(uint8_t load, bool active) {
+    portENTER_CRITICAL(&loadLock);
+    if (active) {
+        activeLoads |= 1 << load;
+    } else {
+        activeLoads &= ~(1 << load);
+    }
+    portEXIT_CRITICAL(&loadLock);
+}
+
+/**
+ * Configures the ADC and starts sampling the battery voltage on
+ * PIN_VBAT_MEASURE
+ */
+void batteryInit() {
+    logInfo("Init: Battery service");
+
+    vbatChannel = (adc1_channel_t)digitalPinToAnalogChannel(PIN_VBAT_MEASURE);
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten(vbatChannel, ADC_ATTEN_DB_2_5);
+
+#ifdef VBAT_DIVIDER_RATIO
+    esp_adc_cal_value_t calibration = esp_adc_cal_characterize(
+        ADC_UNIT_1, ADC_ATTEN_DB_2_5, ADC_WIDTH_BIT_12, VBAT_DEFAULT_VREF,
+        &adcCharacteristics);
+    adcCalibrated = calibration != ESP_ADC_CAL_VAL_DEFAULT_VREF;
+    if (!adcCalibrated) {
+        logWarn("Battery: No ADC calibration in eFuse, using ADC_AT_*");
+    }
+#endif
+
+    // The buffer starts filled with the first sample, the charge with the
+    // one it indicates
+    uint16_t millivolts =
+        toMillivolts(max(adc1_get_raw(vbatChannel), 0)) +
+        (uint32_t)loadCurrent(activeLoads) * BATTERY_INTERNAL_RESISTANCE /
+            1000;
+    for (uint8_t i = 0; i < VBAT_SAMPLE_COUNT; i++) {
+        vbatValues[i] = millivolts;
+    }
+    vbatSum = (uint32_t)millivolts * VBAT_SAMPLE_COUNT;
+    charge = chargeAt(millivolts);
+    vbatMillivolts = millivolts;
+    vbatCharge = charge;
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = sample;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "battery";
+    esp_timer_create(&timerArgs, &sampleTimer);
+    esp_timer_start_periodic(sampleTimer, VBAT_SAMPLE_INTERVAL * 1000);
+}
+
+/**
+ * @return the filtered, load compensated battery voltage in millivolts
+ */
+uint16_t batteryMillivolts() { return vbatMillivolts; }
+
+/**
+ * @return the estimated charge of the battery (0-1)
+ */
+float batteryPercent() { return vbatCharge; }
@@ -0,0 +1,22 @@
+/*
+Skirmish ESP32 Firmware
+
+Battery service - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+// Loads that make the battery voltage sag
+#define BATTERY_LOAD_IR 0
+#define BATTERY_LOAD_AUDIO 1
+#define BATTERY_LOAD_VIBRATION 2
+
+void batteryInit();
+void batterySetLoad(uint8_t load, bool active);
+
+uint16_t batteryMillivolts();
+float batteryPercent();
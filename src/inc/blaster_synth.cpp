@@ -0,0 +1,97 @@
+/*
+Skirmish ESP32 Firmware
+
+Blaster sound synthesizer
+
+Renders the blaster sound in fixed point instead of playing a clip, so
+firing doesn't require any flash access. It doesn't depend on the
+Arduino framework so it can be built and checked on the host.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "blaster_synth.h"
+
+/**
+ * Starts a new blaster sound.
+ *
+ * @param [out] synth synthesizer state
+ * @param params sound parameters
+ * @param sampleRate output sample rate in Hz
+ */
+void blasterSynthStart(BlasterSynth* synth, const BlasterSynthParams* params,
+                       uint32_t sampleRate) {
+    synth->samplesLeft = (uint32_t)params->duration * sampleRate / 1000;
+    if (synth->samplesLeft == 0) synth->samplesLeft = 1;
+
+    // Phase increments for a 32 bit phase accumulator, the frequency is
+    // swept linearly over the duration of the sound. Frequencies are
+    // limited to below nyquist so the increments fit into 31 bit.
+    uint32_t maxFreq = sampleRate / 2 - 1;
+    uint32_t startFreq =
+        params->startFreq < maxFreq ? params->startFreq : maxFreq;
+    uint32_t endFreq = params->endFreq < maxFreq ? params->endFreq : maxFreq;
+    int32_t startInc = ((uint64_t)startFreq << 32) / sampleRate;
+    int32_t endInc = ((uint64_t)endFreq << 32) / sampleRate;
+    synth->phase = 0;
+    synth->phaseInc = startInc;
+    synth->phaseIncStep = (endInc - startInc) / (int32_t)synth->samplesLeft;
+
+    // Q15 amplitude, faded out linearly
+    synth->amplitude = 32767 << 8;
+    synth->amplitudeStep = synth->amplitude / (int32_t)synth->samplesLeft;
+
+    synth->waveform = params->waveform;
+    synth->noise = params->noise;
+    synth->lfsr = 0xace1;
+}
+
+/**
+ * Renders the next frames of the blaster sound as interleaved stereo
+ * 16 bit samples.
+ *
+ * @param synth synthesizer state
+ * @param [out] out output buffer (frames * 2 samples)
+ * @param frames maximum amount of frames to render
+ * @return amount of rendered frames, less than frames if the sound ended
+ */
+uint16_t blasterSynthRender(BlasterSynth* synth, int16_t* out,
+                            uint16_t frames) {
+    uint16_t rendered = 0;
+    while (rendered < frames && synth->samplesLeft > 0) {
+        int32_t tone;
+        switch (synth->waveform) {
+            case BLASTER_WAVE_SAW:
+                tone = (int16_t)(synth->phase >> 16);
+                break;
+            case BLASTER_WAVE_TRIANGLE:
+                tone = (int32_t)(synth->phase >> 15) - 65536;
+                if (tone < 0) tone = -tone;
+                tone -= 32768;
+                if (tone > 32767) tone = 32767;
+                break;
+            default:
+                tone = (synth->phase & 0x80000000) ? 32767 : -32767;
+                break;
+        }
+
+        // 16 bit galois LFSR as noise source
+        synth->lfsr = (synth->lfsr >> 1) ^ (-(synth->lfsr & 1) & 0xb400);
+        int32_t noise = (int16_t)synth->lfsr;
+
+        int32_t sample =
+            (tone * (256 - synth->noise) + noise * synth->noise) >> 8;
+        sample = (sample * (synth->amplitude >> 8)) >> 15;
+
+        out[rendered * 2] = (int16_t)sample;
+        out[rendered * 2 + 1] = (int16_t)sample;
+        rendered++;
+
+        synth->phase += synth->phaseInc;
+        synth->phaseInc += synth->phaseIncStep;
+        synth->amplitude -= synth->amplitudeStep;
+        if (synth->amplitude < 0) synth->amplitude = 0;
+        synth->samplesLeft--;
+    }
+    return rendered;
+}
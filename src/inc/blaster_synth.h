@@ -0,0 +1,47 @@
+/*
+Skirmish ESP32 Firmware
+
+Blaster sound synthesizer - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define BLASTER_WAVE_SQUARE 0
+#define BLASTER_WAVE_SAW 1
+#define BLASTER_WAVE_TRIANGLE 2
+
+/**
+ * Parameters of a synthesized blaster sound: a tone sweeping from
+ * startFreq to endFreq, mixed with noise and faded out over duration.
+ */
+struct BlasterSynthParams {
+    uint16_t startFreq = 1800;  // Hz
+    uint16_t endFreq = 200;     // Hz
+    uint16_t duration = 180;    // ms
+    uint8_t noise = 40;         // noise amount [0-255]
+    uint8_t waveform = BLASTER_WAVE_SQUARE;
+};
+
+/**
+ * State of a playing blaster sound
+ */
+struct BlasterSynth {
+    uint8_t waveform;
+    uint16_t noise;
+    uint32_t phase;
+    int32_t phaseInc;
+    int32_t phaseIncStep;
+    int32_t amplitude;
+    int32_t amplitudeStep;
+    uint16_t lfsr;
+    uint32_t samplesLeft;
+};
+
+void blasterSynthStart(BlasterSynth* synth, const BlasterSynthParams* params,
+                       uint32_t sampleRate);
+uint16_t blasterSynthRender(BlasterSynth* synth, int16_t* out,
+                            uint16_t frames);
@@ -10,6 +10,7 @@ Copyright (C) 2023 Ole Lange
 #include <conf.h>
 #include <inc/bluetooth.h>
 #include <inc/const.h>
+#include <inc/diagnostics.h>
 #include <inc/log.h>
 
 // Prefixes for the BLE name
@@ -27,6 +28,8 @@ const char *namePrefix = "skrmhtpt";
     "beb5483e-36e1-4688-b7f5-ea07361b26a8"  // json write chrst
 #define READ_CHARACTERISTIC_UUID \
     "beb5483f-36e1-4688-b7f5-ea07361b26a8"  // json read chrst
+#define DIAGNOSTICS_CHARACTERISTIC_UUID \
+    "beb54840-36e1-4688-b7f5-ea07361b26a8"  // diagnostics chrst
 
 /**
  * Callback Handler class for the Server
@@ -149,6 +152,14 @@ void SkirmishBluetooth::init() {
         BLEDescriptor("00002902-0000-1000-8000-00805f9b34fb");
     readCharacteristic->addDescriptor(&notifyDescriptor);
 
+    // Diagnostics are sent on their own characteristic, so they don't mix
+    // with the game messages (see diagnostics.cpp)
+    diagnosticsCharacteristic = service->createCharacteristic(
+        DIAGNOSTICS_CHARACTERISTIC_UUID,
+        BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+    diagnosticsCharacteristic->addDescriptor(
+        new BLEDescriptor("00002902-0000-1000-8000-00805f9b34fb"));
+
     // Start advertising the available service
     BLEAdvertising *advertising = server->getAdvertising();
     advertising->start();
@@ -184,6 +195,9 @@ bool SkirmishBluetooth::getConnectionState() { return isConnected; }
  * @param newState new connection state
  */
 void SkirmishBluetooth::setConnectionState(bool newState) {
+    if (!isConnected && newState) {  // Connected
+        lastConnectedTime = millis();
+    }
     if (isConnected && !newState) {  // Disconnected
         lastDisconnectedTime = millis();
     }
@@ -202,9 +216,24 @@ char *SkirmishBluetooth::getName() { return bluetoothName; }
  * @param data the json data which should be send to client
  */
 void SkirmishBluetooth::writeJsonData(DynamicJsonDocument *data) {
+    uint32_t start = micros();
     serializeJson(*data, dataBuffer);
     readCharacteristic->setValue(dataBuffer);
     readCharacteristic->notify();
+    lastWriteTime = millis();
+    diagnosticsLatency(DIAG_LATENCY_BLE_WRITE, micros() - start);
+}
+
+/**
+ * Writes a diagnostics message to the diagnostics characteristic and
+ * notifies the device on the other end
+ *
+ * @param data the message
+ * @param length length of the message
+ */
+void SkirmishBluetooth::writeDiagnostics(const char *data, size_t length) {
+    diagnosticsCharacteristic->setValue((uint8_t *)data, length);
+    diagnosticsCharacteristic->notify();
 }
 
 /**
@@ -18,6 +18,7 @@ class SkirmishBluetooth {
     BLECharacteristic *writeCharacteristic;
     BLECharacteristic *readCharacteristic;
     BLECharacteristic *imageCharacteristic;
+    BLECharacteristic *diagnosticsCharacteristic;
 
     BLEServer *server;
 
@@ -37,10 +38,13 @@ class SkirmishBluetooth {
     bool getConnectionState();
     void setConnectionState(bool newState);
 
+    uint32_t lastConnectedTime = 0;
     uint32_t lastDisconnectedTime = 0;
+    uint32_t lastWriteTime = 0;
 
     char *getName();
     void writeJsonData(DynamicJsonDocument *data);
+    void writeDiagnostics(const char *data, size_t length);
 
     void *com;
     void (*onReceiveCallback)(void *context, DynamicJsonDocument *);
@@ -59,6 +59,8 @@ Copyright (C) 2023 Ole Lange
 #define ACTION_HP_INIT 17
 #define ACITON_HP_GOT_HIT 18
 #define ACTION_HP_HIT_VALID 19
+#define ACTION_FLIGHT_RECORD 20
+#define ACTION_DIAGNOSTICS 21
 
 // UI Scenes
 #define SCENE_NO_SCENE 0
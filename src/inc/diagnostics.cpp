@@ -0,0 +1,292 @@
+/*
+Skirmish ESP32 Firmware
+
+Diagnostics
+
+Streams log messages, metrics snapshots and latency histograms to the app
+over a separate BLE characteristic, while the app enabled it
+(ACTION_DIAGNOSTICS). Every message is a JSON object:
+
+    {"t": "m", "ts": 12345, "bat": 0.8, "mv": 3900, "heap": ...}  metrics
+    {"t": "h", "h": "loop", "b": [12, 340, ...]}                  histogram
+    {"t": "l", "l": 1, "ts": 12345, "m": "..."}                   log
+
+Game messages always go first: diagnostics are only sent from the end of
+a main loop pass, never within DIAGNOSTICS_GAME_GAP ms after a game
+message and at most DIAGNOSTICS_BANDWIDTH bytes per second, so they
+don't queue up in front of the next shot or hit. Metrics and histograms
+are sent every DIAGNOSTICS_METRICS_INTERVAL ms, log messages in between.
+Log messages that don't fit into the queue are dropped and counted.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "diagnostics.h"
+
+#include <ArduinoJson.h>
+#include <esp_system.h>
+
+#include "../conf.h"
+#include "battery.h"
+#include "log.h"
+
+// Largest message, the bandwidth cap saves up at most one
+#define DIAGNOSTICS_MESSAGE_SIZE 256
+
+static const char *latencyNames[DIAG_LATENCIES] = {"loop", "ble_write",
+                                                   "audio"};
+
+/**
+ * A log message waiting to be sent
+ */
+typedef struct {
+    uint8_t level;
+    uint32_t time;
+    char text[DIAGNOSTICS_LOG_LENGTH];
+} DiagnosticsLog;
+
+static SkirmishBluetooth *bluetooth = NULL;
+static DynamicJsonDocument *document = NULL;
+
+// Set by the app, the main loop starts and stops sending
+static volatile bool enabled = false;
+static bool sending = false;
+
+// Queue of log messages, written by the log task
+static portMUX_TYPE logLock = portMUX_INITIALIZER_UNLOCKED;
+static DiagnosticsLog logs[DIAGNOSTICS_LOG_SLOTS];
+static uint8_t logHead = 0;
+static uint8_t logCount = 0;
+static uint32_t logsDropped = 0;
+
+// Latency histograms (microseconds) since sending started
+static portMUX_TYPE histogramLock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t histograms[DIAG_LATENCIES][DIAG_BUCKETS];
+
+// Bytes that may be sent now (1/1000 bytes, so short loop passes add up),
+// refilled with DIAGNOSTICS_BANDWIDTH bytes per second
+static uint32_t budget = 0;
+static uint32_t lastRefill = 0;
+
+static uint32_t lastMetrics = 0;
+static uint8_t nextHistogram = DIAG_LATENCIES;  // DIAG_LATENCIES: none due
+
+// Next message, waiting for budget
+static char message[DIAGNOSTICS_MESSAGE_SIZE];
+static size_t messageLength = 0;
+
+/**
+ * Log sink, queues a log message (called by the log task)
+ *
+ * @param level LOGLEVEL_*
+ * @param time time of the message (millis())
+ * @param text the formatted message
+ */
+static void logSink(uint8_t level, uint32_t time, const char *text) {
+    portENTER_CRITICAL(&logLock);
+    if (logCount == DIAGNOSTICS_LOG_SLOTS) {
+        logsDropped++;
+    } else {
+        DiagnosticsLog *entry =
+            &logs[(logHead + logCount) % DIAGNOSTICS_LOG_SLOTS];
+        entry->level = level;
+        entry->time = time;
+        strncpy(entry->text, text, sizeof(entry->text) - 1);
+        entry->text[sizeof(entry->text) - 1] = 0;
+        logCount++;
+    }
+    portEXIT_CRITICAL(&logLock);
+}
+
+/**
+ * Serializes the document into the message buffer and clears it
+ *
+ * @return length of the message
+ */
+static size_t serialize() {
+    size_t length = serializeJson(*document, message, sizeof(message));
+    document->clear();
+    return length;
+}
+
+/**
+ * Creates a metrics snapshot
+ *
+ * @param now current time (millis())
+ * @return length of the message
+ */
+static size_t createMetrics(uint32_t now) {
+    portENTER_CRITICAL(&logLock);
+    uint32_t dropped = logsDropped;
+    logsDropped = 0;
+    portEXIT_CRITICAL(&logLock);
+
+    JsonObject root = document->to<JsonObject>();
+    root["t"] = "m";
+    root["ts"] = now;
+    root["bat"] = batteryPercent();
+    root["mv"] = batteryMillivolts();
+    root["heap"] = esp_get_free_heap_size();
+    root["heap_min"] = esp_get_minimum_free_heap_size();
+    root["cpu"] = getCpuFrequencyMhz();
+    root["l_drop"] = dropped;
+    return serialize();
+}
+
+/**
+ * Creates the message of a latency histogram
+ *
+ * @param histogram DIAG_LATENCY_*
+ * @return length of the message
+ */
+static size_t createHistogram(uint8_t histogram) {
+    uint32_t counts[DIAG_BUCKETS];
+    portENTER_CRITICAL(&histogramLock);
+    memcpy(counts, histograms[histogram], sizeof(counts));
+    portEXIT_CRITICAL(&histogramLock);
+
+    JsonObject root = document->to<JsonObject>();
+    root["t"] = "h";
+    root["h"] = latencyNames[histogram];
+    JsonArray buckets = root.createNestedArray("b");
+    for (uint8_t i = 0; i < DIAG_BUCKETS; i++) buckets.add(counts[i]);
+    return serialize();
+}
+
+/**
+ * Creates the message of the oldest queued log message
+ *
+ * @return length of the message, 0 if there is none
+ */
+static size_t createLog() {
+    DiagnosticsLog entry;
+    portENTER_CRITICAL(&logLock);
+    bool queued = logCount > 0;
+    if (queued) {
+        entry = logs[logHead];
+        logHead = (logHead + 1) % DIAGNOSTICS_LOG_SLOTS;
+        logCount--;
+    }
+    portEXIT_CRITICAL(&logLock);
+    if (!queued) return 0;
+
+    JsonObject root = document->to<JsonObject>();
+    root["t"] = "l";
+    root["l"] = entry.level;
+    root["ts"] = entry.time;
+    root["m"] = entry.text;
+    return serialize();
+}
+
+/**
+ * Creates the next message: metrics and histograms when they are due,
+ * log messages in between
+ *
+ * @param now current time (millis())
+ * @return length of the message, 0 if there is nothing to send
+ */
+static size_t createMessage(uint32_t now) {
+    if (now - lastMetrics >= DIAGNOSTICS_METRICS_INTERVAL) {
+        lastMetrics = now;
+        nextHistogram = 0;
+        return createMetrics(now);
+    }
+    if (nextHistogram < DIAG_LATENCIES) {
+        return createHistogram(nextHistogram++);
+    }
+    return createLog();
+}
+
+/**
+ * Starts sending, the histograms start from zero
+ *
+ * @param now current time (millis())
+ */
+static void start(uint32_t now) {
+    portENTER_CRITICAL(&histogramLock);
+    memset(histograms, 0, sizeof(histograms));
+    portEXIT_CRITICAL(&histogramLock);
+
+    budget = 0;
+    lastRefill = now;
+    lastMetrics = now - DIAGNOSTICS_METRICS_INTERVAL;
+    messageLength = 0;
+    sending = true;
+}
+
+/**
+ * Enables or disables the diagnostics, called when the app requests it
+ *
+ * @param enable true to start sending
+ * @param level lowest level of the log messages that are sent (LOGLEVEL_*)
+ */
+void diagnosticsEnable(bool enable, uint8_t level) {
+    logSetSink(enable ? logSink : NULL, level);
+    enabled = enable;
+    logInfo("Diagnostics %s", enable ? "enabled" : "disabled");
+}
+
+/**
+ * @return true if the app enabled the diagnostics
+ */
+bool diagnosticsEnabled() { return enabled; }
+
+/**
+ * Adds a latency to its histogram, does nothing while disabled
+ *
+ * @param histogram DIAG_LATENCY_*
+ * @param latency the latency (us)
+ */
+void diagnosticsLatency(uint8_t histogram, uint32_t latency) {
+    if (!enabled) return;
+
+    uint8_t bucket = 0;
+    while (bucket < DIAG_BUCKETS - 1 && latency >= (32UL << bucket)) bucket++;
+
+    portENTER_CRITICAL(&histogramLock);
+    histograms[histogram][bucket]++;
+    portEXIT_CRITICAL(&histogramLock);
+}
+
+/**
+ * Sends the next message if the bandwidth cap allows it and no game
+ * message was sent just before, call at the end of every loop pass
+ *
+ * @param now current time (millis())
+ */
+void diagnosticsUpdate(uint32_t now) {
+    if (!enabled || !bluetooth->getConnectionState()) {
+        sending = false;
+        return;
+    }
+    if (!sending) start(now);
+
+    // At most one message of budget is saved up
+    uint32_t elapsed = min(now - lastRefill, (uint32_t)1000);
+    budget = min(budget + elapsed * DIAGNOSTICS_BANDWIDTH,
+                 (uint32_t)DIAGNOSTICS_MESSAGE_SIZE * 1000);
+    lastRefill = now;
+
+    // Game messages go first
+    if (now - bluetooth->lastWriteTime < DIAGNOSTICS_GAME_GAP) return;
+
+    if (messageLength == 0) messageLength = createMessage(now);
+    if (messageLength == 0 || messageLength * 1000 > budget) return;
+
+    bluetooth->writeDiagnostics(message, messageLength);
+    budget -= messageLength * 1000;
+    messageLength = 0;
+}
+
+/**
+ * Initializes the diagnostics, they stay disabled until the app enables
+ * them
+ *
+ * @param ble the bluetooth driver
+ */
+void diagnosticsInit(SkirmishBluetooth *ble) {
+    logInfo("Init: Diagnostics");
+
+    bluetooth = ble;
+    document = new DynamicJsonDocument(DIAGNOSTICS_MESSAGE_SIZE + 128);
+}
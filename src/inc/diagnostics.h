@@ -0,0 +1,30 @@
+/*
+Skirmish ESP32 Firmware
+
+Diagnostics - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <inc/bluetooth.h>
+
+// Latency histograms
+#define DIAG_LATENCY_LOOP 0       // Main loop pass
+#define DIAG_LATENCY_BLE_WRITE 1  // Writing a game message to the app
+#define DIAG_LATENCY_AUDIO 2      // Audio trigger to first sample
+#define DIAG_LATENCIES 3
+
+// Bucket i counts latencies below 32 << i microseconds, the last one all
+// above
+#define DIAG_BUCKETS 12
+
+void diagnosticsInit(SkirmishBluetooth *ble);
+
+void diagnosticsEnable(bool enable, uint8_t level);
+bool diagnosticsEnabled();
+
+void diagnosticsLatency(uint8_t histogram, uint32_t latency);
+void diagnosticsUpdate(uint32_t now);
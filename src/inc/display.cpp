@@ -8,93 +8,52 @@ Copyright (C) 2023 Ole Lange
 
 #include "display.h"
 
-#include <string.h>  // included for mocking, maybe required to remove
+#ifndef DISPLAY_EMULATOR
+#include <driver/gpio.h>
+#endif
 
 #include "../conf.h"
 #include "../fonts/skvec.h"
+#include "../fonts/skvec_runs.h"
 #include "../fonts/theNeueBlack18pt.h"
 #include "../theme.h"
+#include "gamma.h"
 #include "log.h"
+#include "power.h"
 
 /**
  * Display class constructor
  */
 SkirmishDisplay::SkirmishDisplay() {}
 
-#ifdef GAMMA_CORRECTION
-const uint8_t PROGMEM gamma_correction_curve_g[256] = {
-    0,   0,   1,   1,   2,   3,   4,   4,   5,   6,   7,   8,   8,   9,   10,
-    11,  12,  12,  13,  14,  15,  16,  17,  18,  18,  19,  20,  21,  22,  23,
-    24,  25,  26,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  35,  36,
-    37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  50,
-    51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  65,
-    66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,  80,
-    81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,
-    96,  97,  98,  99,  100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110,
-    111, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125,
-    126, 127, 128, 129, 130, 131, 132, 133, 134, 136, 137, 138, 139, 140, 141,
-    142, 143, 144, 145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156,
-    157, 159, 160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170, 171, 172,
-    173, 174, 175, 177, 178, 179, 180, 181, 182, 183, 184, 185, 186, 187, 188,
-    189, 190, 191, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204,
-    205, 207, 208, 209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 220, 221,
-    222, 223, 224, 225, 226, 227, 228, 229, 230, 231, 233, 234, 235, 236, 237,
-    238, 239, 240, 241, 242, 244, 245, 246, 247, 248, 249, 250, 251, 252, 253,
-    255};
-const uint8_t PROGMEM gamma_correction_curve_b[256] = {
-    0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   3,   4,   4,   5,   5,
-    6,   6,   7,   8,   8,   9,   9,   10,  11,  11,  12,  13,  13,  14,  15,
-    15,  16,  17,  17,  18,  19,  20,  20,  21,  22,  22,  23,  24,  25,  25,
-    26,  27,  28,  29,  29,  30,  31,  32,  33,  33,  34,  35,  36,  37,  38,
-    38,  39,  40,  41,  42,  43,  43,  44,  45,  46,  47,  48,  49,  50,  51,
-    51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  63,  64,
-    65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
-    80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,
-    95,  96,  97,  98,  99,  100, 101, 103, 104, 105, 106, 107, 108, 109, 110,
-    111, 112, 113, 114, 115, 116, 118, 119, 120, 121, 122, 123, 124, 125, 126,
-    127, 129, 130, 131, 132, 133, 134, 135, 136, 137, 139, 140, 141, 142, 143,
-    144, 145, 147, 148, 149, 150, 151, 152, 153, 155, 156, 157, 158, 159, 160,
-    162, 163, 164, 165, 166, 168, 169, 170, 171, 172, 173, 175, 176, 177, 178,
-    179, 181, 182, 183, 184, 185, 187, 188, 189, 190, 192, 193, 194, 195, 196,
-    198, 199, 200, 201, 203, 204, 205, 206, 207, 209, 210, 211, 212, 214, 215,
-    216, 217, 219, 220, 221, 222, 224, 225, 226, 228, 229, 230, 231, 233, 234,
-    235, 236, 238, 239, 240, 242, 243, 244, 245, 247, 248, 249, 251, 252, 253,
-    255};
-#endif
-
 /**
- * Gamma correction for RGB565 values.
+ * Converts a RGB888 color to a gamma corrected RGB565 value. Used for
+ * colors that are only known at runtime (e.g. player colors), the result
+ * is cached so a color is only corrected once.
  *
- * @param color RGB565 color input value
- * @return RGB565 output value gamme corrected
+ * @param r red
+ * @param g green
+ * @param b blue
+ * @return gamma corrected RGB565 color
  */
-uint16_t SkirmishDisplay::gammaCorrection(uint16_t color) {
-#ifdef GAMMA_CORRECTION
-    // Extracting RGB values from the color parameter
-    uint8_t r = ((((color >> 11) & 0x1F) * 527) + 23) >> 6;
-    uint8_t g = ((((color >> 5) & 0x3F) * 259) + 33) >> 6;
-    uint8_t b = (((color & 0x1F) * 527) + 23) >> 6;
-
-    g = gamma_correction_curve_g[g];
-    b = gamma_correction_curve_b[b];
+uint16_t SkirmishDisplay::color(uint8_t r, uint8_t g, uint8_t b) {
+    uint32_t rgb = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    for (uint8_t i = 0; i < paletteSize; i++) {
+        if (palette[i].rgb == rgb) return palette[i].color;
+    }
 
-    // Creating new RGB565 color from the corrected RGB values
     uint16_t r5 = ((r >> 3) & 0x1f) << 11;
     uint16_t g6 = ((g >> 2) & 0x3f) << 5;
     uint16_t b5 = (b >> 3) & 0x1f;
+    uint16_t corrected = gammaCorrect(r5 | g6 | b5);
 
-    return (uint16_t)(r5 | g6 | b5);
-#else
-    return color;
-#endif
-}
+    // Replacing the oldest entry
+    palette[paletteNext].rgb = rgb;
+    palette[paletteNext].color = corrected;
+    paletteNext = (paletteNext + 1) % DISPLAY_PALETTE_SIZE;
+    if (paletteSize < DISPLAY_PALETTE_SIZE) paletteSize++;
 
-uint16_t SkirmishDisplay::color(uint8_t r, uint8_t g, uint8_t b) {
-    uint16_t r5 = ((r >> 3) & 0x1f) << 11;
-    uint16_t g6 = ((g >> 2) & 0x3f) << 5;
-    uint16_t b5 = (b >> 3) & 0x1f;
-
-    return (uint16_t)(r5 | g6 | b5);
+    return corrected;
 }
 
 /**
@@ -103,14 +62,227 @@ uint16_t SkirmishDisplay::color(uint8_t r, uint8_t g, uint8_t b) {
 void SkirmishDisplay::init() {
     logInfo("Init: Display");
 
+#ifndef DISPLAY_EMULATOR
     // SPI init
     spi.begin(PIN_TFT_SCK, -1, PIN_TFT_DATA);  // Starting SPI
     spi.setFrequency(SPI_MAX_FREQ);            // Setting to max speed (80MHz)
+#endif
 
     // TFT init
     tft.begin();
     tft.setRotation(DISPLAY_ROTATION);
     clear();
+
+    // Display lists and render task
+    back = new DisplayList(DISPLAY_LIST_COMMANDS, DISPLAY_LIST_TEXT);
+    front = new DisplayList(DISPLAY_LIST_COMMANDS, DISPLAY_LIST_TEXT);
+    if (!back->isAllocated() || !front->isAllocated()) {
+        logWarn("Display: Not enough memory for display lists");
+        back = NULL;
+        return;
+    }
+    strips.init();
+
+#ifndef DISPLAY_EMULATOR
+    // Same priority as the audio task, long frames can't starve the I2S
+    // buffers that way
+    xTaskCreatePinnedToCore(renderTask, "displayRenderTask", 4096, this, 0,
+                            &renderTaskHandle, 0);
+#endif
+}
+
+/**
+ * Turns the panel and its backlight off for standby, the backlight is held
+ * off in deep sleep. init() turns the panel on again.
+ */
+void SkirmishDisplay::sleep() {
+    flush();
+    waitIdle();
+
+#ifndef DISPLAY_EMULATOR
+    tft.sendCommand(ILI9341_DISPOFF);
+    tft.sendCommand(ILI9341_SLPIN);
+
+    pinMode(PIN_TFT_BLCTRL, OUTPUT);
+    digitalWrite(PIN_TFT_BLCTRL, LOW);
+    gpio_hold_en((gpio_num_t)PIN_TFT_BLCTRL);
+#endif
+}
+
+/**
+ * Starts a frame
+ *
+ * @param full true if the frame covers the whole screen (starts with
+ * clear()), commands that are still waiting are dropped then
+ * @param useStrips render a full frame in strips instead of directly
+ */
+void SkirmishDisplay::beginFrame(bool full, bool useStrips) {
+    if (back == NULL || !full) return;
+    back->clear();
+    back->fullFrame = true;
+    back->useStrips = useStrips;
+}
+
+/**
+ * Hands the recorded frame over to the render task. If the task is still
+ * busy, the commands stay in the list and the next frame is appended.
+ */
+void SkirmishDisplay::endFrame() {
+    if (back == NULL) {
+        textCache.advance();
+        return;
+    }
+    submit();
+}
+
+/**
+ * Hands over commands that were left waiting by endFrame()
+ */
+void SkirmishDisplay::flush() {
+    if (back == NULL || back->isEmpty()) return;
+    submit();
+}
+
+/**
+ * Waits until the render task replayed the last submitted list
+ */
+void SkirmishDisplay::waitIdle() {
+    while (renderBusy) vTaskDelay(1);
+}
+
+/**
+ * @return true if the render task is still replaying a list
+ */
+bool SkirmishDisplay::isBusy() { return renderBusy; }
+
+/**
+ * Swaps the lists and wakes up the render task
+ *
+ * @return false if the render task is still busy
+ */
+bool SkirmishDisplay::submit() {
+    if (renderBusy) return false;
+    if (back->isEmpty()) return true;
+
+    DisplayList* list = front;
+    front = back;
+    back = list;
+    back->clear();
+    textCache.advance();
+
+#ifdef DISPLAY_EMULATOR
+    // There is no render task on the host, lists are replayed right away
+    renderList(front);
+#else
+    // Held until the list is replayed, SPI stops in light sleep
+    renderBusy = true;
+    powerAcquire(POWER_LOCK_DISPLAY);
+    xTaskNotifyGive(renderTaskHandle);
+#endif
+    return true;
+}
+
+/**
+ * Replays a list to the panel
+ *
+ * @param list the list
+ */
+void SkirmishDisplay::renderList(DisplayList* list) {
+    uint32_t start = micros();
+    uint32_t spiBytes = tft.spiBytes;
+
+    if (list->fullFrame && list->useStrips && strips.isReady()) {
+        strips.render(list);
+    } else {
+        list->replay(&tft, 0, tft.height() - 1);
+    }
+
+    frameTime = micros() - start;
+    frameSpiBytes = tft.spiBytes - spiBytes;
+#ifdef DISPLAY_BENCHMARK
+    logDebug("Display: %u commands, %lu SPI bytes in %lu us", list->count(),
+             (unsigned long)frameSpiBytes, (unsigned long)frameTime);
+#endif
+}
+
+#ifndef DISPLAY_EMULATOR
+/**
+ * Render task, replays the lists submitted by the UI
+ *
+ * @param param the SkirmishDisplay
+ */
+void SkirmishDisplay::renderTask(void* param) {
+    SkirmishDisplay* display = (SkirmishDisplay*)param;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        display->renderList(display->front);
+        display->renderBusy = false;
+        powerRelease(POWER_LOCK_DISPLAY);
+    }
+}
+#endif
+
+/**
+ * Records a command, draws it directly if there are no display lists
+ *
+ * @param command the command
+ * @param text the text of a DL_TEXT command
+ */
+void SkirmishDisplay::output(const DisplayCommand* command,
+                             const char* text) {
+    if (back == NULL) {
+        DisplayList::execute(&tft, command, text);
+        return;
+    }
+    if (back->add(command, text)) return;
+
+    // The list is full: the recorded part is handed over as soon as the
+    // render task is free, the rest follows in the next list
+    waitIdle();
+    submit();
+    if (!back->add(command, text)) {
+        logError("Display: Command doesn't fit into an empty list");
+    }
+}
+
+/**
+ * Records or draws a shape, calculates the rows it touches
+ *
+ * @param type DL_* command type
+ * @param color gamma corrected color
+ * @param x0, y0, x1, y1, x2, y2 coordinates (see DisplayCommand)
+ */
+void SkirmishDisplay::outputShape(uint8_t type, uint16_t color, int16_t x0,
+                                  int16_t y0, int16_t x1, int16_t y1,
+                                  int16_t x2, int16_t y2) {
+    DisplayCommand command;
+    command.type = type;
+    command.color = color;
+    command.x0 = x0;
+    command.y0 = y0;
+    command.x1 = x1;
+    command.y1 = y1;
+    command.x2 = x2;
+    command.y2 = y2;
+
+    switch (type) {
+        case DL_LINE:
+            command.top = min(y0, y1);
+            command.bottom = max(y0, y1);
+            break;
+        case DL_FILL_TRIANGLE:
+        case DL_TRIANGLE:
+            command.top = min(y0, min(y1, y2));
+            command.bottom = max(y0, max(y1, y2));
+            break;
+        default:  // Rects and bitmaps
+            command.top = y0;
+            command.bottom = y0 + y1 - 1;
+            break;
+    }
+
+    output(&command);
 }
 
 /**
@@ -119,80 +291,217 @@ void SkirmishDisplay::init() {
 void SkirmishDisplay::clear() { clear(SDT_BG_COLOR); }
 
 /**
- * Clears the screen with a specific color, applies gamma correction
+ * Clears the screen with a specific color
  *
  * @param bgColor the background color
  */
 void SkirmishDisplay::clear(uint16_t bgColor) {
-    tft.fillScreen(gammaCorrection(bgColor));
+    fillRect(0, 0, tft.width(), tft.height(), bgColor);
 }
 
 /**
- * Sets the text color, applies gamma correction
+ * Fills a rectangle
  *
- * @param color new text color
+ * @param x left edge
+ * @param y upper edge
+ * @param w width
+ * @param h height
+ * @param color fill color
  */
-void SkirmishDisplay::setTextColor(uint16_t color) {
-    tft.setTextColor(gammaCorrection(color));
+void SkirmishDisplay::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                               uint16_t color) {
+    outputShape(DL_FILL_RECT, color, x, y, w, h);
 }
 
 /**
- * Sets the font
+ * Draws the outline of a rectangle
  *
- * @param f pointer to the new font
+ * @param x left edge
+ * @param y upper edge
+ * @param w width
+ * @param h height
+ * @param color outline color
  */
-void SkirmishDisplay::setFont(const GFXfont* f) { tft.setFont(f); }
+void SkirmishDisplay::drawRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                               uint16_t color) {
+    outputShape(DL_RECT, color, x, y, w, h);
+}
 
 /**
- * Prints a texts centered on the screen using AdafruitGFX built-in font at
- * the specified y position
+ * Draws a line
  *
- * @param text text that will be rendered
- * @param y vertical position of the text (upper edge)
- * @param fontSize size of the font [1-7]
- * @param charWidth if a different font is used the character width is required
- * @param charHeight if a different font is used the character height is
- * required
- * @param clearLine should the background of this text be cleared
- * @param bgColor background color to use when clearing the background
+ * @param x0 x-axis start
+ * @param y0 y-axis start
+ * @param x1 x-axis end
+ * @param y1 y-axis end
+ * @param color line color
  */
-void SkirmishDisplay::centerText(const char* text, uint16_t y, uint8_t fontSize,
-                                 bool clearLine, uint16_t bgColor) {
-    // Calculate the length of the text in characters
-    uint8_t textLength = strlen(text);
+void SkirmishDisplay::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                               uint16_t color) {
+    outputShape(DL_LINE, color, x0, y0, x1, y1);
+}
+
+/**
+ * Fills a triangle
+ *
+ * @param x0, y0, x1, y1, x2, y2 corners of the triangle
+ * @param color fill color
+ */
+void SkirmishDisplay::fillTriangle(int16_t x0, int16_t y0, int16_t x1,
+                                   int16_t y1, int16_t x2, int16_t y2,
+                                   uint16_t color) {
+    outputShape(DL_FILL_TRIANGLE, color, x0, y0, x1, y1, x2, y2);
+}
 
-    // Set the font size
-    tft.setTextSize(fontSize);
+/**
+ * Draws the set bits of a 1-bit bitmap, the other pixels are not touched
+ *
+ * @param x left edge
+ * @param y upper edge
+ * @param bitmap the bitmap, rows padded to full bytes
+ * @param w width
+ * @param h height
+ * @param color color of the set bits
+ */
+void SkirmishDisplay::drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap,
+                                 int16_t w, int16_t h, uint16_t color) {
+    DisplayCommand command;
+    command.type = DL_BITMAP;
+    command.color = color;
+    command.x0 = x;
+    command.y0 = y;
+    command.x1 = w;
+    command.y1 = h;
+    command.top = y;
+    command.bottom = y + h - 1;
+    command.data = bitmap;
+    output(&command);
+}
 
-    // Calculate text dimensions
-    uint16_t textWidth;
-    uint16_t textHeight;
-    int16_t x0, y0;
-    tft.getTextBounds(text, 0, y, &x0, &y0, &textWidth, &textHeight);
+/**
+ * Draws an opaque 1-bit image with every bit scaled to a square of
+ * scale * scale pixels. The image is referenced until it is drawn, it
+ * must not be freed or changed in between.
+ *
+ * @param x left edge
+ * @param y upper edge
+ * @param image the image, rows padded to full bytes
+ * @param w width in bits
+ * @param h height in bits
+ * @param scale size of the square of a bit
+ * @param color color of the set bits
+ * @param bgColor color of the unset bits
+ */
+void SkirmishDisplay::drawImage(int16_t x, int16_t y, const uint8_t* image,
+                                int16_t w, int16_t h, uint8_t scale,
+                                uint16_t color, uint16_t bgColor) {
+    DisplayCommand command;
+    command.type = DL_IMAGE;
+    command.color = color;
+    command.bgColor = bgColor;
+    command.x0 = x;
+    command.y0 = y;
+    command.x1 = w;
+    command.y1 = h;
+    command.x2 = scale;
+    command.top = y;
+    command.bottom = y + h * scale - 1;
+    command.data = image;
+    output(&command);
+}
 
-    // Return if the text is too wide to fit on the display
-    if (textWidth > 240) return;
+/**
+ * Calculates the rectangle a text would cover, the bounds are cached
+ *
+ * @param text the text
+ * @param x cursor x position
+ * @param y cursor y position (baseline for GFX fonts, upper edge otherwise)
+ * @param font font or NULL for the built-in font
+ * @param fontSize size multiplier of the font
+ * @param x1 returns the left edge
+ * @param y1 returns the upper edge
+ * @param w returns the width
+ * @param h returns the height
+ */
+void SkirmishDisplay::textBounds(const char* text, int16_t x, int16_t y,
+                                 const GFXfont* font, uint8_t fontSize,
+                                 int16_t* x1, int16_t* y1, uint16_t* w,
+                                 uint16_t* h) {
+    textCache.measure(text, x, y, font, fontSize, x1, y1, w, h);
+}
 
-    // If clearLine is true, clear the line on the display
-    // where the text will be drawn
-    if (clearLine) {
-        tft.fillRect(0, y0, 240, textHeight, gammaCorrection(bgColor));
+/**
+ * Prints a text at the given cursor position
+ *
+ * @param text the text
+ * @param x cursor x position
+ * @param y cursor y position (baseline for GFX fonts, upper edge otherwise)
+ * @param font font or NULL for the built-in font
+ * @param fontSize size multiplier of the font
+ * @param color text color
+ */
+void SkirmishDisplay::drawText(const char* text, int16_t x, int16_t y,
+                               const GFXfont* font, uint8_t fontSize,
+                               uint16_t color) {
+    DisplayCommand command;
+    command.color = color;
+
+    // Blitting the cached image if the text isn't wrapped
+    const TextCacheEntry* entry = textCache.get(text, font, fontSize);
+    int16_t left = x + entry->x1;
+    if (entry->image != NULL && left >= 0 && left + entry->w <= 240) {
+        command.type = DL_BITMAP;
+        command.x0 = left;
+        command.y0 = y + entry->y1;
+        command.x1 = entry->w;
+        command.y1 = entry->h;
+        command.top = command.y0;
+        command.bottom = command.y0 + entry->h - 1;
+        command.data = entry->image;
+        output(&command);
+        return;
     }
 
-    // Calculate the x coordinate to center the text on the display
-    uint8_t x = 120 - (textWidth / 2);
-    tft.setCursor(x, y);
-    // Print the text on the display
-    tft.println(text);
+    int16_t x1, y1;
+    uint16_t w, h;
+    textBounds(text, x, y, font, fontSize, &x1, &y1, &w, &h);
+
+    command.type = DL_TEXT;
+    command.fontSize = fontSize;
+    command.x0 = x;
+    command.y0 = y;
+    command.top = y1;
+    command.bottom = y1 + h - 1;
+    command.data = font;
+    output(&command, text);
 }
 
-void SkirmishDisplay::centerText(const char* text, uint16_t y,
-                                 uint8_t fontSize) {
-    centerText(text, y, fontSize, false, SDT_BG_COLOR);
+/**
+ * Prints a texts horizontally centered on the screen
+ *
+ * @param text text that will be rendered
+ * @param y cursor y position (baseline for GFX fonts, upper edge otherwise)
+ * @param font font or NULL for the built-in font
+ * @param fontSize size multiplier of the font
+ * @param color text color
+ */
+void SkirmishDisplay::centerText(const char* text, int16_t y,
+                                 const GFXfont* font, uint8_t fontSize,
+                                 uint16_t color) {
+    int16_t x1, y1;
+    uint16_t w, h;
+    textBounds(text, 0, y, font, fontSize, &x1, &y1, &w, &h);
+
+    // Return if the text is too wide to fit on the display
+    if (w > 240) return;
+
+    drawText(text, 120 - (w / 2), y, font, fontSize, color);
 }
 
 /**
- * Renders a skvec graphic from the given pointer.
+ * Renders a skvec graphic from the given pointer by interpreting its
+ * shapes. Graphics that don't have to be mirrored are drawn faster with
+ * their compiled runs (see drawRuns()).
  *
  * @param vec pointer to the graphic
  * @param x x-axis offset
@@ -202,12 +511,10 @@ void SkirmishDisplay::centerText(const char* text, uint16_t y,
  */
 void SkirmishDisplay::drawVec(const uint8_t* vec, uint8_t x, uint16_t y,
                               uint16_t color, bool mirror) {
-    uint16_t correctedColor = gammaCorrection(color);
-
     uint16_t idx = 0;
     uint8_t shape = 0;
-    uint16_t y0, y1, y2;
-    uint8_t x0, x1, x2;
+    uint16_t y0, y1, y2 = 0;
+    uint8_t x0, x1, x2 = 0;
 
     while (1) {
         shape = vec[idx];
@@ -252,22 +559,108 @@ void SkirmishDisplay::drawVec(const uint8_t* vec, uint8_t x, uint16_t y,
         // Draw shape
         switch ((shape & 0x7f)) {
             case LINE:
-                this->tft.drawLine(x0, y0, x1, y1, color);
+                outputShape(DL_LINE, color, x0, y0, x1, y1);
                 break;
             case RECT:
                 if ((shape & 0x80) == 0)
-                    this->tft.drawRect(x0, y0, x1, y1, correctedColor);
+                    outputShape(DL_RECT, color, x0, y0, x1, y1);
                 else if ((shape & 0x80) == 0x80)
-                    this->tft.fillRect(x0, y0, x1, y1, correctedColor);
+                    outputShape(DL_FILL_RECT, color, x0, y0, x1, y1);
                 break;
             case TRIANGLE:
                 if ((shape & 0x80) == 0)
-                    this->tft.drawTriangle(x0, y0, x1, y1, x2, y2,
-                                           correctedColor);
+                    outputShape(DL_TRIANGLE, color, x0, y0, x1, y1, x2,
+                                y2);
                 else if ((shape & 0x80) == 0x80)
-                    this->tft.fillTriangle(x0, y0, x1, y1, x2, y2,
-                                           correctedColor);
+                    outputShape(DL_FILL_TRIANGLE, color, x0, y0, x1,
+                                y1, x2, y2);
                 break;
         }
     }
 }
+
+/**
+ * Adds the payload of a pixel area to the SPI byte counter, clipped to
+ * the screen like the Adafruit_SPITFT drawing functions do
+ */
+void SkirmishTFT::countPixels(int16_t x, int16_t y, int16_t w, int16_t h) {
+    int16_t x1 = min((int16_t)(x + w), (int16_t)width());
+    int16_t y1 = min((int16_t)(y + h), (int16_t)height());
+    x = max(x, (int16_t)0);
+    y = max(y, (int16_t)0);
+    if (x1 > x && y1 > y) spiBytes += (x1 - x) * (y1 - y) * 2;
+}
+
+void SkirmishTFT::setAddrWindow(uint16_t x, uint16_t y, uint16_t w,
+                                uint16_t h) {
+    spiBytes += 11;
+    SkirmishPanel::setAddrWindow(x, y, w, h);
+}
+
+void SkirmishTFT::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    countPixels(x, y, 1, 1);
+    SkirmishPanel::drawPixel(x, y, color);
+}
+
+void SkirmishTFT::writePixel(int16_t x, int16_t y, uint16_t color) {
+    countPixels(x, y, 1, 1);
+    SkirmishPanel::writePixel(x, y, color);
+}
+
+void SkirmishTFT::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                           uint16_t color) {
+    countPixels(x, y, w, h);
+    SkirmishPanel::fillRect(x, y, w, h, color);
+}
+
+void SkirmishTFT::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                                uint16_t color) {
+    countPixels(x, y, w, h);
+    SkirmishPanel::writeFillRect(x, y, w, h, color);
+}
+
+void SkirmishTFT::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                uint16_t color) {
+    countPixels(x, y, w, 1);
+    SkirmishPanel::drawFastHLine(x, y, w, color);
+}
+
+void SkirmishTFT::writeFastHLine(int16_t x, int16_t y, int16_t w,
+                                 uint16_t color) {
+    countPixels(x, y, w, 1);
+    SkirmishPanel::writeFastHLine(x, y, w, color);
+}
+
+void SkirmishTFT::drawFastVLine(int16_t x, int16_t y, int16_t h,
+                                uint16_t color) {
+    countPixels(x, y, 1, h);
+    SkirmishPanel::drawFastVLine(x, y, h, color);
+}
+
+void SkirmishTFT::writeFastVLine(int16_t x, int16_t y, int16_t h,
+                                 uint16_t color) {
+    countPixels(x, y, 1, h);
+    SkirmishPanel::writeFastVLine(x, y, h, color);
+}
+
+/**
+ * Renders a skvec graphic compiled to runs at build time (see
+ * scripts/compile_skvec.py), every run is drawn with one address window
+ *
+ * @param runs the compiled graphic (skvecRuns_*)
+ * @param x x-axis offset
+ * @param y y-axis offset
+ * @param color color of the graphic
+ */
+void SkirmishDisplay::drawRuns(const SkvecRuns* runs, int16_t x, int16_t y,
+                               uint16_t color) {
+    DisplayCommand command;
+    command.type = DL_RUNS;
+    command.color = color;
+    command.x0 = x;
+    command.y0 = y;
+    command.top = y + runs->top;
+    command.bottom = y + runs->bottom;
+    command.data = runs;
+    output(&command);
+}
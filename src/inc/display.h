@@ -10,40 +10,139 @@ Copyright (C) 2023 Ole Lange
 
 #include "../conf.h"
 #include "Adafruit_GFX.h"
+#include "display_list.h"
+#include "strip_renderer.h"
+#include "text_cache.h"
+
+// The emulator (platformio.ini env:emulator) replaces the panel with a
+// framebuffer on the host
+#ifdef DISPLAY_EMULATOR
+#include "../emulator/panel.h"
+typedef EmulatorPanel SkirmishPanel;
+#else
 #include "Adafruit_ILI9341.h"
+typedef Adafruit_ILI9341 SkirmishPanel;
+#endif
+
+/**
+ * ILI9341 driver which counts the bytes it pushes over SPI. All pixel
+ * writes of Adafruit_GFX end up in one of the overridden methods, every
+ * address window costs 11 bytes (3 commands, 8 parameter bytes) and every
+ * pixel 2 bytes.
+ */
+class SkirmishTFT : public SkirmishPanel {
+   private:
+    void countPixels(int16_t x, int16_t y, int16_t w, int16_t h);
+
+   public:
+    using SkirmishPanel::SkirmishPanel;
+
+    uint32_t spiBytes = 0;
+
+    void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+    void writePixel(int16_t x, int16_t y, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                       uint16_t color);
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+};
 
 /**
  * An object of this class can be used to control the ILI9341 Display
  * connected to the skirmish phaser module. It provides some methods
  * for rendering text and images and is used by the SkirmishUI class to
  * display the User Interface.
+ *
+ * All drawing functions take gamma corrected colors, use GAMMA() (see
+ * gamma.h) for constants and color() for runtime colors. They only record
+ * draw commands, frames are replayed to the panel by a render task on core
+ * 0 while the UI records the next one. Full frames are rendered in strips.
  */
 class SkirmishDisplay {
    private:
+#ifndef DISPLAY_EMULATOR
     SPIClass spi = SPIClass();
+#endif
+
+    // The UI records into back while the render task replays front
+    DisplayList* back = NULL;
+    DisplayList* front = NULL;
+    volatile bool renderBusy = false;
+    TaskHandle_t renderTaskHandle = NULL;
+
+    // Cache of gamma corrected runtime colors
+    struct {
+        uint32_t rgb;
+        uint16_t color;
+    } palette[DISPLAY_PALETTE_SIZE];
+    uint8_t paletteSize = 0;
+    uint8_t paletteNext = 0;
+
+    void output(const DisplayCommand* command, const char* text = NULL);
+    void outputShape(uint8_t type, uint16_t color, int16_t x0, int16_t y0,
+                     int16_t x1, int16_t y1, int16_t x2 = 0, int16_t y2 = 0);
+    bool submit();
+    void renderList(DisplayList* list);
+    static void renderTask(void* param);
 
    public:
     SkirmishDisplay();
     void init();
+    void sleep();
+
+#ifdef DISPLAY_EMULATOR
+    SkirmishTFT tft;
+#else
+    SkirmishTFT tft = SkirmishTFT(&spi, PIN_TFT_DC, PIN_TFT_CS, PIN_TFT_RESET);
+#endif
+    StripRenderer strips = StripRenderer(&tft);
+    TextCache textCache;
 
-    Adafruit_ILI9341 tft =
-        Adafruit_ILI9341(&spi, PIN_TFT_DC, PIN_TFT_CS, PIN_TFT_RESET);
+    // Statistics of the last replayed list, written by the render task
+    volatile uint32_t frameSpiBytes = 0;
+    volatile uint32_t frameTime = 0;
+
+    // Frame functions
+    void beginFrame(bool full, bool useStrips = true);
+    void endFrame();
+    void flush();
+    void waitIdle();
+    bool isBusy();
 
     // Color functions
-    uint16_t gammaCorrection(uint16_t color);
     uint16_t color(uint8_t r, uint8_t g, uint8_t b);
 
-    void setTextColor(uint16_t color);
     void clear();
     void clear(uint16_t bgColor);
 
+    // Shape functions
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                  uint16_t color);
+    void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                      int16_t x2, int16_t y2, uint16_t color);
+    void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w,
+                    int16_t h, uint16_t color);
+    void drawImage(int16_t x, int16_t y, const uint8_t* image, int16_t w,
+                   int16_t h, uint8_t scale, uint16_t color, uint16_t bgColor);
+
     // Text functions
-    void setFont(const GFXfont* f);
-    void centerText(const char* text, uint16_t y, uint8_t fontSize,
-                    bool clearLine, uint16_t bgColor);
-    void centerText(const char* text, uint16_t y, uint8_t fontSize);
+    void textBounds(const char* text, int16_t x, int16_t y,
+                    const GFXfont* font, uint8_t fontSize, int16_t* x1,
+                    int16_t* y1, uint16_t* w, uint16_t* h);
+    void drawText(const char* text, int16_t x, int16_t y, const GFXfont* font,
+                  uint8_t fontSize, uint16_t color);
+    void centerText(const char* text, int16_t y, const GFXfont* font,
+                    uint8_t fontSize, uint16_t color);
 
     // Vector Functions
     void drawVec(const uint8_t* vec, uint8_t x, uint16_t y, uint16_t color,
                  bool mirror = false);
+    void drawRuns(const SkvecRuns* runs, int16_t x, int16_t y,
+                  uint16_t color);
 };
@@ -0,0 +1,243 @@
+/*
+Skirmish ESP32 Firmware
+
+Display list
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "display_list.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../fonts/skvec_runs.h"
+
+#ifdef DISPLAY_EMULATOR
+uint8_t DisplayList::executing = DL_NONE;
+#endif
+
+/**
+ * Display list constructor, allocates the buffers
+ *
+ * @param commandCapacity max amount of commands
+ * @param textCapacity max amount of text bytes (including terminators)
+ */
+DisplayList::DisplayList(uint16_t commandCapacity, uint16_t textCapacity) {
+    this->commandCapacity = commandCapacity;
+    this->textCapacity = textCapacity;
+    commands =
+        (DisplayCommand*)malloc(commandCapacity * sizeof(DisplayCommand));
+    textPool = (char*)malloc(textCapacity * sizeof(char));
+    if (commands == NULL || textPool == NULL) {
+        this->commandCapacity = 0;
+        this->textCapacity = 0;
+    }
+}
+
+/**
+ * @return false if the buffers couldn't be allocated
+ */
+bool DisplayList::isAllocated() { return commandCapacity > 0; }
+
+/**
+ * Appends a command. The text of text commands is copied to the list.
+ *
+ * @param command the command
+ * @param text the text of a DL_TEXT command
+ * @return false if the list is full
+ */
+bool DisplayList::add(const DisplayCommand* command, const char* text) {
+    if (commandCount >= commandCapacity) return false;
+
+    DisplayCommand* entry = &commands[commandCount];
+    *entry = *command;
+
+    if (command->type == DL_TEXT) {
+        uint16_t length = strlen(text) + 1;
+        if (textUsed + length > textCapacity) return false;
+        memcpy(&textPool[textUsed], text, length);
+        entry->text = textUsed;
+        textUsed += length;
+    }
+
+    commandCount++;
+    return true;
+}
+
+/**
+ * Removes all commands
+ */
+void DisplayList::clear() {
+    commandCount = 0;
+    textUsed = 0;
+    fullFrame = false;
+    useStrips = true;
+}
+
+uint16_t DisplayList::count() { return commandCount; }
+
+bool DisplayList::isEmpty() { return commandCount == 0; }
+
+/**
+ * Executes all commands touching the given rows in the recorded order
+ *
+ * @param gfx target of the commands
+ * @param top first row
+ * @param bottom last row
+ */
+void DisplayList::replay(Adafruit_GFX* gfx, int16_t top, int16_t bottom) {
+    for (uint16_t i = 0; i < commandCount; i++) {
+        DisplayCommand* command = &commands[i];
+        if (command->bottom < top || command->top > bottom) continue;
+        execute(gfx, command, &textPool[command->text], top, bottom);
+    }
+}
+
+/**
+ * Executes a single command
+ *
+ * @param gfx target of the command
+ * @param command the command
+ * @param text the text of a DL_TEXT command
+ * @param top first row that is drawn (only used by runs)
+ * @param bottom last row that is drawn (only used by runs)
+ */
+void DisplayList::execute(Adafruit_GFX* gfx, const DisplayCommand* command,
+                          const char* text, int16_t top, int16_t bottom) {
+    const DisplayCommand* c = command;
+#ifdef DISPLAY_EMULATOR
+    executing = c->type;
+#endif
+    switch (c->type) {
+        case DL_FILL_RECT:
+            gfx->fillRect(c->x0, c->y0, c->x1, c->y1, c->color);
+            break;
+        case DL_RECT:
+            gfx->drawRect(c->x0, c->y0, c->x1, c->y1, c->color);
+            break;
+        case DL_LINE:
+            gfx->drawLine(c->x0, c->y0, c->x1, c->y1, c->color);
+            break;
+        case DL_FILL_TRIANGLE:
+            gfx->fillTriangle(c->x0, c->y0, c->x1, c->y1, c->x2, c->y2,
+                              c->color);
+            break;
+        case DL_TRIANGLE:
+            gfx->drawTriangle(c->x0, c->y0, c->x1, c->y1, c->x2, c->y2,
+                              c->color);
+            break;
+        case DL_BITMAP:
+            blitBitmap(gfx, c->x0, c->y0, (const uint8_t*)c->data, c->x1,
+                       c->y1, c->color);
+            break;
+        case DL_TEXT:
+            gfx->setFont((const GFXfont*)c->data);
+            gfx->setTextSize(c->fontSize);
+            gfx->setTextColor(c->color);
+            gfx->setCursor(c->x0, c->y0);
+            gfx->print(text);
+            break;
+        case DL_IMAGE:
+            blitImage(gfx, c);
+            break;
+        case DL_RUNS:
+            blitRuns(gfx, (const SkvecRuns*)c->data, c->x0, c->y0, c->color,
+                     top, bottom);
+            break;
+    }
+#ifdef DISPLAY_EMULATOR
+    executing = DL_NONE;
+#endif
+}
+
+/**
+ * Draws a 1-bpp bitmap (format of Adafruit_GFX::drawBitmap()) as
+ * horizontal runs, every run is a single fill instead of one write per
+ * pixel
+ *
+ * @param gfx target
+ * @param x, y upper left corner
+ * @param bitmap the bitmap
+ * @param w, h size of the bitmap
+ * @param color color of the set pixels
+ */
+void DisplayList::blitBitmap(Adafruit_GFX* gfx, int16_t x, int16_t y,
+                             const uint8_t* bitmap, int16_t w, int16_t h,
+                             uint16_t color) {
+    int16_t stride = (w + 7) / 8;
+
+    gfx->startWrite();
+    for (int16_t row = 0; row < h; row++) {
+        const uint8_t* line = &bitmap[row * stride];
+        int16_t start = -1;
+        for (int16_t i = 0; i <= w; i++) {
+            bool set = i < w && (line[i >> 3] & (0x80 >> (i & 7)));
+            if (set && start < 0) {
+                start = i;
+            } else if (!set && start >= 0) {
+                gfx->writeFastHLine(x + start, y + row, i - start, color);
+                start = -1;
+            }
+        }
+    }
+    gfx->endWrite();
+}
+
+/**
+ * Draws an opaque 1-bpp image scaled by an integer factor. Neighbouring
+ * bits of the same value are drawn as one fill.
+ *
+ * @param gfx target
+ * @param command the DL_IMAGE command
+ */
+void DisplayList::blitImage(Adafruit_GFX* gfx, const DisplayCommand* command) {
+    const uint8_t* image = (const uint8_t*)command->data;
+    int16_t w = command->x1;
+    int16_t h = command->y1;
+    int16_t scale = command->x2;
+    int16_t stride = (w + 7) / 8;
+
+    gfx->startWrite();
+    for (int16_t row = 0; row < h; row++) {
+        const uint8_t* line = &image[row * stride];
+        int16_t y = command->y0 + row * scale;
+        int16_t start = 0;
+        for (int16_t i = 1; i <= w; i++) {
+            bool set = line[start >> 3] & (0x80 >> (start & 7));
+            if (i < w && set == (bool)(line[i >> 3] & (0x80 >> (i & 7)))) {
+                continue;
+            }
+            gfx->writeFillRect(command->x0 + start * scale, y,
+                               (i - start) * scale, scale,
+                               set ? command->color : command->bgColor);
+            start = i;
+        }
+    }
+    gfx->endWrite();
+}
+
+/**
+ * Draws a compiled SKVEC graphic, every run is a single fill. Runs are
+ * sorted by their first row, so runs below the given rows end the loop.
+ *
+ * @param gfx target
+ * @param runs the graphic
+ * @param x, y offset
+ * @param color color of the graphic
+ * @param top first row that is drawn
+ * @param bottom last row that is drawn
+ */
+void DisplayList::blitRuns(Adafruit_GFX* gfx, const SkvecRuns* runs,
+                           int16_t x, int16_t y, uint16_t color, int16_t top,
+                           int16_t bottom) {
+    gfx->startWrite();
+    for (uint16_t i = 0; i < runs->count; i++) {
+        const SkvecRun* run = &runs->runs[i];
+        int16_t runTop = y + run->y;
+        if (runTop > bottom) break;
+        if (runTop + run->h <= top) continue;
+        gfx->writeFillRect(x + run->x, runTop, run->w, run->h, color);
+    }
+    gfx->endWrite();
+}
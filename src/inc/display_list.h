@@ -0,0 +1,99 @@
+/*
+Skirmish ESP32 Firmware
+
+Display list - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "Adafruit_GFX.h"
+
+#define DL_FILL_RECT 0
+#define DL_RECT 1
+#define DL_LINE 2
+#define DL_FILL_TRIANGLE 3
+#define DL_TRIANGLE 4
+#define DL_BITMAP 5
+#define DL_TEXT 6
+#define DL_RUNS 7
+#define DL_IMAGE 8
+#define DL_TYPES 9
+#define DL_NONE 0xff
+
+struct SkvecRuns;
+
+/**
+ * A single draw command. Colors are already gamma corrected. top and
+ * bottom are the first and last row the command touches, they are used
+ * to skip commands outside of a strip.
+ *
+ * Coordinates by type:
+ *  rect:     x0, y0, w = x1, h = y1
+ *  line:     x0, y0 to x1, y1
+ *  triangle: x0, y0, x1, y1, x2, y2
+ *  bitmap:   x0, y0, w = x1, h = y1, data = bitmap (also cached texts)
+ *  text:     cursor x0, y0, data = font, text = offset in the text pool
+ *  runs:     offset x0, y0, data = SkvecRuns (see skvec_runs.h)
+ *  image:    x0, y0, w = x1, h = y1 (in bits), scale = x2, data = image,
+ *            unset bits are drawn in bgColor
+ */
+typedef struct {
+    uint8_t type;
+    uint8_t fontSize;
+    uint16_t color;
+    int16_t top, bottom;
+    int16_t x0, y0, x1, y1, x2, y2;
+    uint16_t text;
+    uint16_t bgColor;
+    const void* data;
+} DisplayCommand;
+
+/**
+ * A list of draw commands recorded for one frame, replayed to the panel
+ * or to a strip buffer.
+ */
+class DisplayList {
+   private:
+    DisplayCommand* commands;
+    uint16_t commandCapacity;
+    uint16_t commandCount = 0;
+
+    char* textPool;
+    uint16_t textCapacity;
+    uint16_t textUsed = 0;
+
+   public:
+    DisplayList(uint16_t commandCapacity, uint16_t textCapacity);
+
+    // The list covers the whole screen and may be rendered in strips
+    bool fullFrame = false;
+    bool useStrips = true;
+
+    bool isAllocated();
+    bool add(const DisplayCommand* command, const char* text = NULL);
+    void clear();
+    uint16_t count();
+    bool isEmpty();
+
+#ifdef DISPLAY_EMULATOR
+    // Type of the command that is executed or DL_NONE, the emulated panel
+    // accounts the pixels it receives to it
+    static uint8_t executing;
+#endif
+
+    void replay(Adafruit_GFX* gfx, int16_t top, int16_t bottom);
+    static void execute(Adafruit_GFX* gfx, const DisplayCommand* command,
+                        const char* text, int16_t top = 0,
+                        int16_t bottom = 0x7fff);
+    static void blitBitmap(Adafruit_GFX* gfx, int16_t x, int16_t y,
+                           const uint8_t* bitmap, int16_t w, int16_t h,
+                           uint16_t color);
+    static void blitImage(Adafruit_GFX* gfx, const DisplayCommand* command);
+    static void blitRuns(Adafruit_GFX* gfx, const SkvecRuns* runs, int16_t x,
+                         int16_t y, uint16_t color, int16_t top,
+                         int16_t bottom);
+};
@@ -9,6 +9,7 @@ Copyright (C) 2023 Ole Lange
 #include <inc/game.h>
 #include <inc/log.h>
 #include <inc/time.h>
+#include <inc/trigger.h>
 #include <string.h>
 
 // Macro to set a variable to a specific value from a json object called "root"
@@ -82,11 +83,15 @@ void Player::reset() {
     phaserEnable = false;
     phaserDisableUntil = 0;
     maxShotInterval = 0;
+    fireMode = FIRE_MODE_SEMI;
+    burstLength = 3;
     rank = 0;
     inviolable = true;
     inviolableUntil = 0;
     wasHit = false;
     hasHit = false;
+    blasterSynth = false;
+    blasterSynthParams = BlasterSynthParams();
 
     currentSid = 1;
 }
@@ -208,10 +213,18 @@ void Game::updatePGTData(JsonObject *root) {
     P_SET_IF_CONTAINED(player.phaserEnable, "p_pe");
     P_SET_IF_CONTAINED(player.phaserDisableUntil, "p_pdu");
     P_SET_IF_CONTAINED(player.maxShotInterval, "p_msi");
+    P_SET_IF_CONTAINED(player.fireMode, "p_fm");
+    P_SET_IF_CONTAINED(player.burstLength, "p_bl");
     P_SET_IF_CONTAINED(player.rank, "p_r");
     P_SET_IF_CONTAINED(player.inviolable, "p_i");
     P_SET_IF_CONTAINED(player.inviolableUntil, "p_iu");
     P_SET_IF_CONTAINED(player.inviolableLightsOff, "p_ilo");
+    P_SET_IF_CONTAINED(player.blasterSynth, "p_bs");
+    P_SET_IF_CONTAINED(player.blasterSynthParams.startFreq, "p_bsf0");
+    P_SET_IF_CONTAINED(player.blasterSynthParams.endFreq, "p_bsf1");
+    P_SET_IF_CONTAINED(player.blasterSynthParams.duration, "p_bsd");
+    P_SET_IF_CONTAINED(player.blasterSynthParams.noise, "p_bsn");
+    P_SET_IF_CONTAINED(player.blasterSynthParams.waveform, "p_bsw");
 
     afterDataUpdate();
     player.afterDataUpdate();
@@ -9,6 +9,7 @@ Copyright (C) 2023 Ole Lange
 #pragma once
 
 #include <ArduinoJson.h>
+#include <inc/blaster_synth.h>
 
 class Player {
    private:
@@ -30,11 +31,17 @@ class Player {
     bool phaserEnable;
     uint32_t phaserDisableUntil;
     uint16_t maxShotInterval;
+    uint8_t fireMode;     // FIRE_MODE_*
+    uint8_t burstLength;  // Shots per press in FIRE_MODE_BURST
     uint8_t rank;
     bool inviolable;
     uint32_t inviolableUntil;
     bool inviolableLightsOff;
 
+    // Use a synthesized blaster sound instead of the blaster clip
+    bool blasterSynth;
+    BlasterSynthParams blasterSynthParams;
+
     bool wasHit = false;
     char* wasHitBy;
 
@@ -0,0 +1,102 @@
+/*
+Skirmish ESP32 Firmware
+
+Gamma correction - Header file
+
+The display colors are gamma corrected before they are sent to the panel.
+gammaCorrect() is constexpr, so constant colors (see theme.h) are corrected
+at compile time with GAMMA(), runtime colors use the palette cache of
+SkirmishDisplay.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../conf.h"
+
+constexpr uint8_t gammaCurveG[256] = {
+    0,   0,   1,   1,   2,   3,   4,   4,   5,   6,   7,   8,   8,   9,   10,
+    11,  12,  12,  13,  14,  15,  16,  17,  18,  18,  19,  20,  21,  22,  23,
+    24,  25,  26,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  35,  36,
+    37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  50,
+    51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  65,
+    66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,  80,
+    81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,
+    96,  97,  98,  99,  100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110,
+    111, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125,
+    126, 127, 128, 129, 130, 131, 132, 133, 134, 136, 137, 138, 139, 140, 141,
+    142, 143, 144, 145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156,
+    157, 159, 160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170, 171, 172,
+    173, 174, 175, 177, 178, 179, 180, 181, 182, 183, 184, 185, 186, 187, 188,
+    189, 190, 191, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204,
+    205, 207, 208, 209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 220, 221,
+    222, 223, 224, 225, 226, 227, 228, 229, 230, 231, 233, 234, 235, 236, 237,
+    238, 239, 240, 241, 242, 244, 245, 246, 247, 248, 249, 250, 251, 252, 253,
+    255};
+constexpr uint8_t gammaCurveB[256] = {
+    0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   3,   4,   4,   5,   5,
+    6,   6,   7,   8,   8,   9,   9,   10,  11,  11,  12,  13,  13,  14,  15,
+    15,  16,  17,  17,  18,  19,  20,  20,  21,  22,  22,  23,  24,  25,  25,
+    26,  27,  28,  29,  29,  30,  31,  32,  33,  33,  34,  35,  36,  37,  38,
+    38,  39,  40,  41,  42,  43,  43,  44,  45,  46,  47,  48,  49,  50,  51,
+    51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  63,  64,
+    65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
+    80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,
+    95,  96,  97,  98,  99,  100, 101, 103, 104, 105, 106, 107, 108, 109, 110,
+    111, 112, 113, 114, 115, 116, 118, 119, 120, 121, 122, 123, 124, 125, 126,
+    127, 129, 130, 131, 132, 133, 134, 135, 136, 137, 139, 140, 141, 142, 143,
+    144, 145, 147, 148, 149, 150, 151, 152, 153, 155, 156, 157, 158, 159, 160,
+    162, 163, 164, 165, 166, 168, 169, 170, 171, 172, 173, 175, 176, 177, 178,
+    179, 181, 182, 183, 184, 185, 187, 188, 189, 190, 192, 193, 194, 195, 196,
+    198, 199, 200, 201, 203, 204, 205, 206, 207, 209, 210, 211, 212, 214, 215,
+    216, 217, 219, 220, 221, 222, 224, 225, 226, 228, 229, 230, 231, 233, 234,
+    235, 236, 238, 239, 240, 242, 243, 244, 245, 247, 248, 249, 251, 252, 253,
+    255};
+
+/**
+ * Expands a 5 bit channel to 8 bit
+ */
+constexpr uint8_t gammaExpand5(uint16_t value) {
+    return ((value * 527) + 23) >> 6;
+}
+
+/**
+ * Expands a 6 bit channel to 8 bit
+ */
+constexpr uint8_t gammaExpand6(uint16_t value) {
+    return ((value * 259) + 33) >> 6;
+}
+
+/**
+ * Gamma correction for RGB565 values. Red is passed through, green and
+ * blue are corrected with the curves above.
+ *
+ * @param color RGB565 color input value
+ * @return RGB565 output value gamma corrected
+ */
+constexpr uint16_t gammaCorrect(uint16_t color) {
+#ifdef GAMMA_CORRECTION
+    return (uint16_t)((((gammaExpand5((color >> 11) & 0x1F) >> 3) & 0x1f)
+                       << 11) |
+                      (((gammaCurveG[gammaExpand6((color >> 5) & 0x3F)] >> 2) &
+                        0x3f)
+                       << 5) |
+                      ((gammaCurveB[gammaExpand5(color & 0x1F)] >> 3) & 0x1f));
+#else
+    return color;
+#endif
+}
+
+/**
+ * Forces the correction of a constant color to happen at compile time,
+ * also in debug builds
+ */
+template <uint16_t color>
+struct GammaCorrected {
+    enum : uint16_t { value = gammaCorrect(color) };
+};
+
+#define GAMMA(color) ((uint16_t)GammaCorrected<(color)>::value)
@@ -0,0 +1,133 @@
+/*
+Skirmish ESP32 Firmware
+
+Haptics
+
+Drives the vibration motor with LEDC PWM and plays vibration patterns.
+Every step of a pattern is started by a one-shot esp_timer, so the
+pattern plays with the same timing no matter how busy the main loop is.
+The timer callback is the only code that touches the motor; starting a
+pattern only hands it to the callback.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "haptics.h"
+
+#include <esp_timer.h>
+
+#include "../conf.h"
+#include "battery.h"
+#include "log.h"
+
+static const HapticStep shotPattern[] = {{255, 60}, {120, 40}, {0, 0}};
+
+static const HapticStep hitPattern[] = {
+    {255, 150}, {0, 80}, {255, 150}, {0, 80}, {180, 250}, {0, 0}};
+
+static const HapticStep countdownTickPattern[] = {{200, 40}, {0, 0}};
+
+static const HapticStep gameStartPattern[] = {
+    {150, 100}, {0, 60}, {200, 100}, {0, 60}, {255, 300}, {0, 0}};
+
+// Patterns by HAPTIC_* id
+static const HapticStep *patterns[] = {shotPattern, hitPattern,
+                                       countdownTickPattern, gameStartPattern};
+
+static esp_timer_handle_t stepTimer = NULL;
+
+// Pattern handed to the timer callback, and the one it is playing
+static portMUX_TYPE patternLock = portMUX_INITIALIZER_UNLOCKED;
+static const HapticStep *pendingPattern = NULL;
+static const HapticStep *currentStep = NULL;
+
+// Stopping is a pattern without steps
+static const HapticStep stopPattern[] = {{0, 0}};
+
+/**
+ * Sets the motor power
+ *
+ * @param intensity power (0-255)
+ */
+static void setIntensity(uint8_t intensity) {
+    ledcWrite(HAPTICS_LEDC_CHANNEL, intensity);
+    batterySetLoad(BATTERY_LOAD_VIBRATION, intensity > 0);
+}
+
+/**
+ * Timer callback, applies the next step of the pattern and schedules the
+ * one after it
+ */
+static void nextStep(void *arg) {
+    portENTER_CRITICAL(&patternLock);
+    if (pendingPattern != NULL) {
+        currentStep = pendingPattern;
+        pendingPattern = NULL;
+    }
+    const HapticStep *step = currentStep;
+    if (step != NULL && step->duration > 0) currentStep++;
+    portEXIT_CRITICAL(&patternLock);
+
+    if (step == NULL || step->duration == 0) {
+        setIntensity(0);
+        return;
+    }
+
+    setIntensity(step->intensity);
+    esp_timer_start_once(stepTimer, step->duration * 1000);
+}
+
+/**
+ * Plays a predefined pattern, replacing the one that is playing
+ *
+ * @param pattern HAPTIC_*
+ */
+void hapticsPlay(uint8_t pattern) {
+    if (pattern >= sizeof(patterns) / sizeof(patterns[0])) return;
+    hapticsPlayPattern(patterns[pattern]);
+}
+
+/**
+ * Plays a pattern, replacing the one that is playing
+ *
+ * @param steps steps ending with a step of duration 0, must stay valid
+ * while the pattern plays
+ */
+void hapticsPlayPattern(const HapticStep *steps) {
+    // Without hapticsInit() (NO_VIBR_MOTOR) patterns are ignored
+    if (stepTimer == NULL) return;
+
+    portENTER_CRITICAL(&patternLock);
+    pendingPattern = steps;
+    portEXIT_CRITICAL(&patternLock);
+
+    // If the callback is running right now the timer can't be restarted,
+    // it picks the pattern up when its step is over
+    esp_timer_stop(stepTimer);
+    esp_timer_start_once(stepTimer, 0);
+}
+
+/**
+ * Turns the motor off
+ */
+void hapticsStop() { hapticsPlayPattern(stopPattern); }
+
+/**
+ * Initializes the PWM output of the vibration motor
+ *
+ * Pins required in this module are:
+ * - PIN_VIBR_MOTOR: Pin connected to the driver for the vibration motor.
+ */
+void hapticsInit() {
+    logInfo("Init: Haptics");
+
+    ledcSetup(HAPTICS_LEDC_CHANNEL, HAPTICS_PWM_FREQUENCY, 8);
+    ledcAttachPin(PIN_VIBR_MOTOR, HAPTICS_LEDC_CHANNEL);
+    ledcWrite(HAPTICS_LEDC_CHANNEL, 0);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = nextStep;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "haptics";
+    esp_timer_create(&timerArgs, &stepTimer);
+}
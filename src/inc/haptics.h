@@ -0,0 +1,32 @@
+/*
+Skirmish ESP32 Firmware
+
+Haptics - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * A step of a vibration pattern. Patterns are arrays of steps ending with
+ * a step of duration 0.
+ */
+typedef struct {
+    uint8_t intensity;  // Motor power (0-255)
+    uint16_t duration;  // Milliseconds
+} HapticStep;
+
+// Predefined patterns
+#define HAPTIC_SHOT 0
+#define HAPTIC_HIT 1
+#define HAPTIC_COUNTDOWN_TICK 2
+#define HAPTIC_GAME_START 3
+
+void hapticsInit();
+
+void hapticsPlay(uint8_t pattern);
+void hapticsPlayPattern(const HapticStep *steps);
+void hapticsStop();
@@ -13,12 +13,6 @@ Copyright (C) 2023 Ole Lange
 
 #include <Arduino.h>
 
-bool hardwareWasTriggerPressed();
-
 void hardwarePowerOff();
-uint16_t hardwareReadVBAT();
-float hardwareBatteryPercent();
-void hardwareVibrate(uint16_t duration);
 
-void hardwareLoop();
 void hardwareInit();
\ No newline at end of file
@@ -48,14 +48,17 @@ void initESPNow(bool isRetry) {
  */
 void onReceive(const uint8_t *mac_addr, const uint8_t *data, int data_len) {
     if (data_len == 6) {
-        char macStr[18];
-        snprintf(macStr, sizeof(macStr), "%02x:%02x:%02x:%02x:%02x:%02x",
-                 mac_addr[0], mac_addr[1], mac_addr[2], mac_addr[3], mac_addr[4], mac_addr[5]);
-        char dataStr[18];
-        snprintf(dataStr, sizeof(dataStr), "%02x,%02x,%02x,%02x,%02x,%02x",
-                 data[0], data[1], data[2], data[3], data[4], data[5]);
-
-        logDebug("Received %s from %s", dataStr, macStr);
+        if (LOG_ENABLED(LOGLEVEL_DEBUG)) {
+            char macStr[18];
+            snprintf(macStr, sizeof(macStr), "%02x:%02x:%02x:%02x:%02x:%02x",
+                     mac_addr[0], mac_addr[1], mac_addr[2], mac_addr[3],
+                     mac_addr[4], mac_addr[5]);
+            char dataStr[18];
+            snprintf(dataStr, sizeof(dataStr), "%02x,%02x,%02x,%02x,%02x,%02x",
+                     data[0], data[1], data[2], data[3], data[4], data[5]);
+
+            logDebug("Received %s from %s", dataStr, macStr);
+        }
 
         if (data[0] == CMD_GOT_HIT) {
             receivedGotHit = true;
@@ -11,6 +11,7 @@ Copyright (C) 2023 Ole Lange
 #include <Arduino.h>
 #include <conf.h>
 
+#include "inc/battery.h"
 #include "inc/log.h"
 
 /**
@@ -109,5 +110,7 @@ void infraredTransmitShot(uint8_t pid, uint32_t sid) {
     logDebug("  checksum: %02x", checksum);
     logDebug("  packet:   %08x", irpack);
 
+    batterySetLoad(BATTERY_LOAD_IR, true);
     irSendNECblk(irpack, PIN_IR_LED, 38);
+    batterySetLoad(BATTERY_LOAD_IR, false);
 }
\ No newline at end of file
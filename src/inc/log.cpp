@@ -3,12 +3,24 @@ Skirmish ESP32 Firmware
 
 Logging utility
 
+Log calls only record the address of their format string and the raw
+arguments into a lock-free ring buffer (see log_ring.cpp), the formatting
+and the serial output are done by a background task. The calls are safe
+from every task and cost a few microseconds.
+
+The task writes the records as text, or with LOG_BINARY as binary frames
+that are decoded on the host with the firmware ELF file
+(scripts/log_decoder.py). Records of a minimum level can additionally be
+passed as text to a sink (logSetSink()), e.g. the diagnostics channel.
+
 Copyright (C) 2023 Ole Lange
 */
 
 #include <Arduino.h>
 #include <conf.h>
 #include <inc/const.h>
+#include <inc/log.h>
+#include <inc/log_ring.h>
 
 // ANSI Escape Sequence colors
 const char* ANSI_BLACK = "\u001b[30m";
@@ -21,81 +33,197 @@ const char* ANSI_CYAN = "\u001b[36m";
 const char* ANSI_WHITE = "\u001b[37m";
 const char* ANSI_RESET = "\u001b[0m";
 
-// Buffer for the current log line
-char* currentLogLine;
+static const char* levelColors[] = {ANSI_GREEN, ANSI_BLUE, ANSI_YELLOW,
+                                    ANSI_RED, ANSI_MAGENTA};
+static const char* levelNames[] = {"DEBUG", "INFO", "WARNING", "ERROR",
+                                   "FATAL"};
 
-/**
- * Initialize the logging utility
- */
-void logInit() {
-    Serial.begin(LOG_SERIAL_SPEED);
+static_assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0 &&
+                  LOG_BUFFER_SIZE >= LOG_RECORD_MAX,
+              "LOG_BUFFER_SIZE has to be a power of two of at least "
+              "LOG_RECORD_MAX bytes");
 
-    // Allocate memory for the log line buffer
-    currentLogLine = (char*)malloc(256 * sizeof(char));
-}
+// Frames of LOG_BINARY start with these bytes
+#define LOG_SYNC_0 0xa5
+#define LOG_SYNC_1 0x5a
 
-// Macro for the generic logging function.
-#define LOG(color, levelString)                                           \
-    {                                                                     \
-        va_list args;                                                     \
-        va_start(args, val);                                              \
-        vsprintf(currentLogLine, val, args);                              \
-        Serial.printf("[%s%s%s]%s\t%10lu%s - %s\r\n", color, levelString, \
-                      ANSI_RESET, ANSI_CYAN, millis(), ANSI_RESET,        \
-                      currentLogLine);                                    \
-    }
+static uint8_t ringData[LOG_BUFFER_SIZE] __attribute__((aligned(4)));
+static LogRing ring = {ringData, LOG_BUFFER_SIZE - 1, 0, 0, 0};
+
+static const char* droppedFormat = "%u log messages dropped";
+
+// Receives the records of at least sinkLevel as text, called by the drain
+static void (*volatile sink)(uint8_t level, uint32_t time,
+                             const char* text) = NULL;
+static volatile uint8_t sinkLevel = LOGLEVEL_OFF;
+
+static void drain();
 
 /**
- * Log a debug message. Use like printf
+ * Records a log message
  *
- * @param val Format string
+ * @param level LOGLEVEL_*
+ * @param format format string, has to stay valid (string literal)
+ * @param args arguments of the format string
  */
-void logDebug(const char* val, ...) {
-#if LOGLEVEL <= LOGLEVEL_DEBUG
-    LOG(ANSI_GREEN, "DEBUG");
+static void record(uint8_t level, const char* format, va_list args) {
+    uint8_t data[LOG_RECORD_MAX] __attribute__((aligned(4)));
+    logRingEncode(data, level, millis(), format, args);
+    logRingWrite(&ring, data);
+
+#ifdef DISPLAY_EMULATOR
+    // There is no background task on the host
+    drain();
 #endif
 }
 
 /**
- * Log a info message. Use like printf
+ * Writes a record to the serial port
  *
- * @param val Format string
+ * @param data the record
  */
-void logInfo(const char* val, ...) {
-#if LOGLEVEL <= LOGLEVEL_INFO
-    LOG(ANSI_BLUE, "INFO");
+static void output(const uint8_t* data) {
+#ifdef LOG_BINARY
+    uint16_t length = data[0] | (data[1] << 8);
+    Serial.write(LOG_SYNC_0);
+    Serial.write(LOG_SYNC_1);
+    Serial.write(data, length);
+#else
+    static char line[256];
+    uint8_t level = min(data[2], (uint8_t)LOGLEVEL_FATAL);
+    uint32_t time;
+    memcpy(&time, &data[4], 4);
+    logRingFormat(data, line, sizeof(line));
+    Serial.printf("[%s%s%s]%s\t%10lu%s - %s\r\n", levelColors[level],
+                  levelNames[level], ANSI_RESET, ANSI_CYAN,
+                  (unsigned long)time, ANSI_RESET, line);
 #endif
 }
 
 /**
- * Log a warning message. Use like printf
+ * Passes a record to the sink if there is one and it takes the level
  *
- * @param val Format string
+ * @param data the record
  */
-void logWarn(const char* val, ...) {
-#if LOGLEVEL <= LOGLEVEL_INFO
-    LOG(ANSI_YELLOW, "WARNING");
+static void forward(const uint8_t* data) {
+    void (*target)(uint8_t, uint32_t, const char*) = sink;
+    if (target == NULL || data[2] < sinkLevel) return;
+
+    char text[128];
+    uint32_t time;
+    memcpy(&time, &data[4], 4);
+    logRingFormat(data, text, sizeof(text));
+    target(data[2], time, text);
+}
+
+/**
+ * Writes the committed records to the serial port
+ */
+static void drain() {
+    uint8_t data[LOG_RECORD_MAX] __attribute__((aligned(4)));
+
+    while (logRingRead(&ring, data) > 0) {
+        output(data);
+        forward(data);
+    }
+
+    uint32_t lost = logRingTakeDropped(&ring);
+    if (lost > 0) {
+        uint32_t time = millis();
+        uint32_t header = (LOG_HEADER_SIZE + 4) | ((uint32_t)LOGLEVEL_WARN << 16);
+        memcpy(&data[0], &header, 4);
+        memcpy(&data[4], &time, 4);
+        memcpy(&data[8], &droppedFormat, sizeof(droppedFormat));
+        memcpy(&data[LOG_HEADER_SIZE], &lost, 4);
+        output(data);
+        forward(data);
+    }
+}
+
+#ifndef DISPLAY_EMULATOR
+/**
+ * Task writing the records to the serial port
+ */
+static void drainTask(void* param) {
+    while (true) {
+        drain();
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+    }
+}
+#endif
+
+/**
+ * Initialize the logging utility
+ */
+void logInit() {
+    Serial.begin(LOG_SERIAL_SPEED);
+
+#ifndef DISPLAY_EMULATOR
+    xTaskCreatePinnedToCore(drainTask, "logDrainTask", 3072, NULL, 0, NULL,
+                            0);
 #endif
 }
 
 /**
- * Log a error message. Use like printf
+ * Sets the sink that receives the records of a minimum level as text. It
+ * is called by the background task and must not block.
  *
- * @param val Format string
+ * @param target the sink or NULL
+ * @param level lowest level passed to the sink (LOGLEVEL_*)
  */
-void logError(const char* val, ...) {
-#if LOGLEVEL <= LOGLEVEL_INFO
-    LOG(ANSI_RED, "ERROR");
-#endif
+void logSetSink(void (*target)(uint8_t level, uint32_t time, const char* text),
+                uint8_t level) {
+    sinkLevel = level;
+    sink = target;
 }
 
 /**
- * Log a fatal error message. Use like printf
+ * Records a log message, use the log* macros instead. Use like printf
  *
- * @param val Format string
+ * @param level LOGLEVEL_*
+ * @param format Format string, has to stay valid (string literal)
  */
-void logFatal(const char* val, ...) {
-#if LOGLEVEL <= LOGLEVEL_INFO
-    LOG(ANSI_MAGENTA, "FATAL");
+void logWrite(uint8_t level, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    record(level, format, args);
+    va_end(args);
+}
+
+#ifdef LOG_BENCHMARK
+#define LOG_BENCHMARK_CALLS 50
+
+// The same calls compiled with debug messages enabled and disabled
+#undef LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL LOGLEVEL_DEBUG
+static uint32_t benchmarkEnabled() {
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < LOG_BENCHMARK_CALLS; i++) {
+        logDebug("  packet:   %08lx", (unsigned long)i);
+    }
+    return micros() - start;
+}
+
+#undef LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL LOGLEVEL_OFF
+static uint32_t benchmarkDisabled() {
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < LOG_BENCHMARK_CALLS; i++) {
+        logDebug("  packet:   %08lx", (unsigned long)i);
+    }
+    return micros() - start;
+}
+
+/**
+ * Measures the time a debug message takes on the calling side, with
+ * debug messages enabled and compiled out
+ */
+void logBenchmark() {
+    uint32_t enabled = benchmarkEnabled();
+    uint32_t disabled = benchmarkDisabled();
+    logWrite(LOGLEVEL_INFO,
+             "Log benchmark: %lu ns per call enabled, %lu ns disabled",
+             (unsigned long)enabled * 1000 / LOG_BENCHMARK_CALLS,
+             (unsigned long)disabled * 1000 / LOG_BENCHMARK_CALLS);
+}
 #endif
-}
\ No newline at end of file
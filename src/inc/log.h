@@ -3,6 +3,15 @@ Skirmish ESP32 Firmware
 
 Logging utility
 
+Log calls are macros: calls below the level of the module compile to
+nothing, their arguments are not evaluated. The format strings of all
+calls are checked by the compiler, enabled or not.
+
+The level is LOG_LEVEL (conf.h), a module can override it by defining
+LOG_MODULE_LEVEL before it includes any header:
+
+    #define LOG_MODULE_LEVEL LOGLEVEL_WARN
+
 Copyright (C) 2023 Ole Lange
 */
 
@@ -10,10 +19,34 @@ Copyright (C) 2023 Ole Lange
 
 #include <Arduino.h>
 
+#include "../conf.h"
+
+#ifndef LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL LOG_LEVEL
+#endif
+
+// True if messages of the level are logged in this module, for work that
+// is only done to log something
+#define LOG_ENABLED(level) ((level) >= LOG_MODULE_LEVEL)
+
+// The condition is constant, disabled calls are removed by the compiler
+#define LOG_AT(level, ...)                                    \
+    do {                                                      \
+        if (LOG_ENABLED(level)) logWrite(level, __VA_ARGS__); \
+    } while (0)
+
+#define logDebug(...) LOG_AT(LOGLEVEL_DEBUG, __VA_ARGS__)
+#define logInfo(...) LOG_AT(LOGLEVEL_INFO, __VA_ARGS__)
+#define logWarn(...) LOG_AT(LOGLEVEL_WARN, __VA_ARGS__)
+#define logError(...) LOG_AT(LOGLEVEL_ERROR, __VA_ARGS__)
+#define logFatal(...) LOG_AT(LOGLEVEL_FATAL, __VA_ARGS__)
+
 void logInit();
+void logWrite(uint8_t level, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+void logSetSink(void (*target)(uint8_t level, uint32_t time, const char* text),
+                uint8_t level);
 
-void logDebug(const char* val, ...);
-void logInfo(const char* val, ...);
-void logWarn(const char* val, ...);
-void logError(const char* val, ...);
-void logFatal(const char* val, ...);
\ No newline at end of file
+#ifdef LOG_BENCHMARK
+void logBenchmark();
+#endif
@@ -0,0 +1,331 @@
+/*
+Skirmish ESP32 Firmware
+
+Log ring buffer
+
+Records of log calls (see log.cpp) are kept in a lock-free ring buffer.
+Writers reserve their record with a compare and swap on the write index
+and commit it by writing its header last, so records of several tasks can
+be written at the same time. A single reader takes the committed records
+in the order they were reserved: a record that was reserved first but
+committed later holds back the ones after it. Records that don't fit into
+the ring are dropped and counted.
+
+Doesn't depend on the Arduino framework so it can be built and checked
+on the host.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "log_ring.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Argument kinds of a conversion
+#define LOG_ARG_NONE 0    // %% or unsupported
+#define LOG_ARG_INT 1     // 4 bytes
+#define LOG_ARG_INT64 2   // 8 bytes (%ll)
+#define LOG_ARG_DOUBLE 3  // Stored as 4 byte float
+#define LOG_ARG_STRING 4  // Length byte and the characters
+
+/**
+ * Parses a conversion specification
+ *
+ * @param spec the character after the %
+ * @param kind set to the LOG_ARG_* of the argument
+ * @return the character after the specification
+ */
+static const char* parseSpec(const char* spec, uint8_t* kind) {
+    while (*spec == '-' || *spec == '+' || *spec == ' ' || *spec == '#' ||
+           *spec == '0') {
+        spec++;
+    }
+    while ((*spec >= '0' && *spec <= '9') || *spec == '.') spec++;
+
+    uint8_t longs = 0;
+    while (*spec == 'h' || *spec == 'l' || *spec == 'z' || *spec == 'j' ||
+           *spec == 't') {
+        if (*spec == 'l') longs++;
+        spec++;
+    }
+
+    switch (*spec) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'c':
+            *kind = longs >= 2 || (longs == 1 && sizeof(long) == 8)
+                        ? LOG_ARG_INT64
+                        : LOG_ARG_INT;
+            break;
+        case 'p':
+            *kind = sizeof(void*) == 8 ? LOG_ARG_INT64 : LOG_ARG_INT;
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            *kind = LOG_ARG_DOUBLE;
+            break;
+        case 's':
+            *kind = LOG_ARG_STRING;
+            break;
+        default:
+            *kind = LOG_ARG_NONE;
+    }
+    return *spec != 0 ? spec + 1 : spec;
+}
+
+/**
+ * Initializes an empty ring
+ *
+ * @param ring the ring
+ * @param data memory of the ring, aligned to 4 bytes
+ * @param size size of the memory, a power of two of at least 4
+ */
+void logRingInit(LogRing* ring, uint8_t* data, uint32_t size) {
+    memset(data, 0, size);
+    ring->data = data;
+    ring->mask = size - 1;
+    ring->writeIndex = 0;
+    ring->readIndex = 0;
+    ring->dropped = 0;
+}
+
+/**
+ * Copies bytes into the ring, wrapping around at its end
+ */
+static void copyIn(LogRing* ring, uint32_t index, const uint8_t* data,
+                   uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        ring->data[(index + i) & ring->mask] = data[i];
+    }
+}
+
+/**
+ * Copies bytes out of the ring and clears them for the next writer
+ */
+static void copyOut(LogRing* ring, uint32_t index, uint8_t* data,
+                    uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        data[i] = ring->data[(index + i) & ring->mask];
+        ring->data[(index + i) & ring->mask] = 0;
+    }
+}
+
+/**
+ * Records a log call
+ *
+ * @param [out] record LOG_RECORD_MAX bytes, aligned to 4
+ * @param level LOGLEVEL_*
+ * @param time millis() of the call
+ * @param format format string, has to stay valid (string literal)
+ * @param args arguments of the format string
+ * @return length of the record, a multiple of 4
+ */
+uint16_t logRingEncode(uint8_t* record, uint8_t level, uint32_t time,
+                       const char* format, va_list args) {
+    uint16_t length = LOG_HEADER_SIZE;
+
+    memcpy(&record[4], &time, 4);
+    memcpy(&record[8], &format, sizeof(format));
+
+    for (const char* c = format; *c != 0; c++) {
+        if (*c != '%') continue;
+
+        uint8_t kind;
+        c = parseSpec(c + 1, &kind) - 1;
+
+        // Arguments that don't fit are left out, they are printed as 0
+        if (kind == LOG_ARG_INT && length + 4 <= LOG_RECORD_MAX) {
+            uint32_t value = va_arg(args, uint32_t);
+            memcpy(&record[length], &value, 4);
+            length += 4;
+        } else if (kind == LOG_ARG_INT64 && length + 8 <= LOG_RECORD_MAX) {
+            uint64_t value = va_arg(args, uint64_t);
+            memcpy(&record[length], &value, 8);
+            length += 8;
+        } else if (kind == LOG_ARG_DOUBLE && length + 4 <= LOG_RECORD_MAX) {
+            float value = va_arg(args, double);
+            memcpy(&record[length], &value, 4);
+            length += 4;
+        } else if (kind == LOG_ARG_STRING && length < LOG_RECORD_MAX) {
+            const char* value = va_arg(args, const char*);
+            if (value == NULL) value = "(null)";
+            uint8_t size = strnlen(value, LOG_STRING_MAX);
+            if (size > LOG_RECORD_MAX - length - 1) {
+                size = LOG_RECORD_MAX - length - 1;
+            }
+            record[length++] = size;
+            memcpy(&record[length], value, size);
+            length += size;
+        } else if (kind != LOG_ARG_NONE) {
+            break;
+        }
+    }
+    length = (length + 3) & ~3;
+
+    uint32_t header = length | ((uint32_t)level << 16);
+    memcpy(&record[0], &header, 4);
+    return length;
+}
+
+/**
+ * Reserves space in the ring
+ *
+ * @param ring the ring
+ * @param length length of the record
+ * @return index of the record, -1 if the ring is full
+ */
+int64_t logRingReserve(LogRing* ring, uint16_t length) {
+    uint32_t start = __atomic_load_n(&ring->writeIndex, __ATOMIC_RELAXED);
+    do {
+        uint32_t used =
+            start - __atomic_load_n(&ring->readIndex, __ATOMIC_ACQUIRE);
+        if (used + length > ring->mask + 1) return -1;
+    } while (!__atomic_compare_exchange_n(&ring->writeIndex, &start,
+                                          start + length, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+    return start;
+}
+
+/**
+ * Copies a record into the space reserved for it, the header is written
+ * last so the reader doesn't see a partial record
+ *
+ * @param ring the ring
+ * @param index index returned by logRingReserve()
+ * @param record the record (logRingEncode())
+ */
+void logRingCommit(LogRing* ring, uint32_t index, const uint8_t* record) {
+    uint32_t header;
+    memcpy(&header, record, 4);
+
+    copyIn(ring, index + 4, &record[4], (header & 0xffff) - 4);
+    __atomic_store_n((uint32_t*)&ring->data[index & ring->mask], header,
+                     __ATOMIC_RELEASE);
+}
+
+/**
+ * Reserves space for a record and commits it, it is dropped and counted
+ * if the ring is full
+ *
+ * @param ring the ring
+ * @param record the record (logRingEncode())
+ * @return false if it was dropped
+ */
+bool logRingWrite(LogRing* ring, const uint8_t* record) {
+    int64_t index = logRingReserve(ring, record[0] | (record[1] << 8));
+    if (index < 0) {
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    logRingCommit(ring, index, record);
+    return true;
+}
+
+/**
+ * Takes the next record out of the ring, only one task may read
+ *
+ * @param ring the ring
+ * @param [out] record LOG_RECORD_MAX bytes, aligned to 4
+ * @return length of the record, 0 if the next one isn't committed yet
+ */
+uint16_t logRingRead(LogRing* ring, uint8_t* record) {
+    uint32_t index = __atomic_load_n(&ring->readIndex, __ATOMIC_RELAXED);
+    uint32_t header = __atomic_load_n(
+        (uint32_t*)&ring->data[index & ring->mask], __ATOMIC_ACQUIRE);
+    if (header == 0) return 0;
+
+    uint16_t length = header & 0xffff;
+    copyOut(ring, index, record, length);
+    __atomic_store_n(&ring->readIndex, index + length, __ATOMIC_RELEASE);
+    return length;
+}
+
+/**
+ * @param ring the ring
+ * @return the amount of records dropped since the last call
+ */
+uint32_t logRingTakeDropped(LogRing* ring) {
+    return __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * Formats a record as text
+ *
+ * @param record the record
+ * @param line output buffer
+ * @param size size of the output buffer
+ */
+void logRingFormat(const uint8_t* record, char* line, size_t size) {
+    uint16_t length = record[0] | (record[1] << 8);
+    const char* format;
+    memcpy(&format, &record[8], sizeof(format));
+
+    uint16_t offset = LOG_HEADER_SIZE;
+    size_t used = 0;
+    for (const char* c = format; *c != 0 && used + 1 < size;) {
+        if (*c != '%') {
+            line[used++] = *c++;
+            continue;
+        }
+
+        uint8_t kind;
+        const char* end = parseSpec(c + 1, &kind);
+
+        char spec[16];
+        size_t specLength = end - c;
+        if (specLength > sizeof(spec) - 1) specLength = sizeof(spec) - 1;
+        memcpy(spec, c, specLength);
+        spec[specLength] = 0;
+        c = end;
+
+        int written = 0;
+        if (kind == LOG_ARG_NONE) {
+            written = snprintf(&line[used], size - used, "%s",
+                               strcmp(spec, "%%") == 0 ? "%" : spec);
+        } else if (kind == LOG_ARG_INT) {
+            uint32_t value = 0;
+            if (offset + 4 <= length) memcpy(&value, &record[offset], 4);
+            offset += 4;
+            written = snprintf(&line[used], size - used, spec, value);
+        } else if (kind == LOG_ARG_INT64) {
+            uint64_t value = 0;
+            if (offset + 8 <= length) memcpy(&value, &record[offset], 8);
+            offset += 8;
+            written = snprintf(&line[used], size - used, spec, value);
+        } else if (kind == LOG_ARG_DOUBLE) {
+            float value = 0;
+            if (offset + 4 <= length) memcpy(&value, &record[offset], 4);
+            offset += 4;
+            written = snprintf(&line[used], size - used, spec, (double)value);
+        } else {
+            char value[LOG_STRING_MAX + 1] = "";
+            if (offset < length) {
+                uint8_t stringLength = record[offset];
+                if (stringLength > LOG_STRING_MAX) {
+                    stringLength = LOG_STRING_MAX;
+                }
+                if (offset + 1 + stringLength <= length) {
+                    memcpy(value, &record[offset + 1], stringLength);
+                    value[stringLength] = 0;
+                }
+                offset += 1 + stringLength;
+            }
+            written = snprintf(&line[used], size - used, spec, value);
+        }
+        if (written > 0) {
+            used += written;
+            if (used > size - 1) used = size - 1;
+        }
+    }
+    line[used] = 0;
+}
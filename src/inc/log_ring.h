@@ -0,0 +1,53 @@
+/*
+Skirmish ESP32 Firmware
+
+Log ring buffer - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Records are aligned to 4 bytes, their first word is the header:
+
+    uint16_t length   length of the record including the header
+    uint8_t level     LOGLEVEL_*
+    uint8_t reserved
+    uint32_t time     millis()
+    const char *      address of the format string
+    arguments         packed, in the order of the conversions
+
+A header of 0 marks a record that isn't committed yet.
+*/
+#define LOG_HEADER_SIZE (8 + sizeof(const char*))
+#define LOG_RECORD_MAX 128
+#define LOG_STRING_MAX 32
+
+/**
+ * Lock-free ring of log records, written by any task and read by one
+ */
+typedef struct {
+    uint8_t* data;  // size bytes, aligned to 4
+    uint32_t mask;  // size - 1, the size is a power of two
+    volatile uint32_t writeIndex;
+    volatile uint32_t readIndex;
+    volatile uint32_t dropped;
+} LogRing;
+
+void logRingInit(LogRing* ring, uint8_t* data, uint32_t size);
+
+uint16_t logRingEncode(uint8_t* record, uint8_t level, uint32_t time,
+                       const char* format, va_list args);
+int64_t logRingReserve(LogRing* ring, uint16_t length);
+void logRingCommit(LogRing* ring, uint32_t index, const uint8_t* record);
+bool logRingWrite(LogRing* ring, const uint8_t* record);
+
+uint16_t logRingRead(LogRing* ring, uint8_t* record);
+uint32_t logRingTakeDropped(LogRing* ring);
+
+void logRingFormat(const uint8_t* record, char* line, size_t size);
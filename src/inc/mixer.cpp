@@ -0,0 +1,53 @@
+/*
+Skirmish ESP32 Firmware
+
+Audio mixer
+
+Fixed-point mixing kernel used by the audio driver. It doesn't depend
+on the Arduino framework so it can be built and checked on the host.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "mixer.h"
+
+/**
+ * Converts a float gain to a Q1.15 mixer gain
+ *
+ * @param gain gain [0-1]
+ * @return Q1.15 gain
+ */
+uint16_t mixerGain(float gain) {
+    if (gain <= 0) return 0;
+    if (gain >= 1) return MIXER_GAIN_UNITY;
+    return (uint16_t)(gain * MIXER_GAIN_UNITY);
+}
+
+/**
+ * Mixes a block of samples from several voices into one block. Each
+ * sample is scaled by the gain of its voice, the sum is saturated to
+ * 16 bit. The cost is fixed at voiceCount multiply-adds per sample.
+ *
+ * @param [out] out mixed samples
+ * @param voices sample blocks of the voices (each samples long)
+ * @param gains Q1.15 gain of each voice
+ * @param voiceCount amount of voices
+ * @param samples amount of samples per block (frames * channels)
+ */
+void mixerMixBlock(int16_t* out, const int16_t* const* voices,
+                   const uint16_t* gains, uint8_t voiceCount,
+                   uint16_t samples) {
+    for (uint16_t i = 0; i < samples; i++) {
+        int32_t acc = 0;
+        for (uint8_t v = 0; v < voiceCount; v++) {
+            acc += ((int32_t)voices[v][i] * gains[v]) >> 15;
+        }
+
+        if (acc > INT16_MAX)
+            acc = INT16_MAX;
+        else if (acc < INT16_MIN)
+            acc = INT16_MIN;
+
+        out[i] = (int16_t)acc;
+    }
+}
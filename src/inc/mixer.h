@@ -0,0 +1,19 @@
+/*
+Skirmish ESP32 Firmware
+
+Audio mixer - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// Gains are unsigned Q1.15 fixed point values, 0x8000 is unity gain
+#define MIXER_GAIN_UNITY 0x8000
+
+uint16_t mixerGain(float gain);
+void mixerMixBlock(int16_t* out, const int16_t* const* voices,
+                   const uint16_t* gains, uint8_t voiceCount,
+                   uint16_t samples);
@@ -0,0 +1,188 @@
+/*
+Skirmish ESP32 Firmware
+
+Power management
+
+Chooses the CPU frequency and automatic light sleep by phase of the
+device (esp_pm). The main loop sleeps for the loop delay of the phase at
+the end of every pass, which gives the idle task (and with it light
+sleep and frequency scaling) a chance to run. BLE and ESP-NOW stay
+alive: their drivers hold power management locks while they need the
+radio, and the minimum frequency never drops the APB clock the SPI, I2C
+and I2S peripherals run from. Light sleep stops those clocks though, so
+audio, the display render task and the trigger debounce hold a
+POWER_LOCK_* while they are busy: light sleep only happens while all of
+them are idle.
+
+The wall time spent in every phase is logged every POWER_LOG_INTERVAL
+milliseconds. It is not the time spent in light sleep or at a frequency,
+esp_pm only counts those with CONFIG_PM_PROFILING.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "power.h"
+
+#include <esp32/pm.h>
+#include <esp_pm.h>
+
+#include "../conf.h"
+#include "log.h"
+
+/**
+ * Power policy of a phase
+ */
+typedef struct {
+    uint16_t maxFrequency;  // MHz
+    uint16_t minFrequency;  // MHz, at least 80 to keep the APB clock
+    bool lightSleep;
+    uint16_t loopDelay;  // Sleep at the end of a main loop pass (ms), 0: none
+} PowerPolicy;
+
+// Policies by POWER_PHASE_*
+static const PowerPolicy policies[POWER_PHASES] = {
+    {80, 80, true, 50},    // Disconnected: only advertising
+    {160, 80, true, 20},   // Lobby: waiting for the game
+    {240, 80, false, 5},   // Countdown
+    {240, 240, false, 0},  // Running: shots and hits without latency
+};
+
+static const char *phaseNames[POWER_PHASES] = {"disconnected", "lobby",
+                                               "countdown", "running"};
+
+static uint8_t currentPhase = 0xff;
+static uint32_t phaseStart = 0;
+static uint32_t lastLog = 0;
+
+// Time spent in every phase (ms), without the current one
+static uint32_t phaseTime[POWER_PHASES];
+
+// Cleared when the framework doesn't support the feature
+static bool pmSupported = true;
+static bool lightSleepSupported = true;
+
+// Light sleep locks by POWER_LOCK_*, NULL without esp_pm support
+static esp_pm_lock_handle_t locks[POWER_LOCKS];
+static const char *lockNames[POWER_LOCKS] = {"audio", "display", "trigger"};
+
+/**
+ * Applies the policy of a phase
+ *
+ * @param policy the policy
+ */
+static void applyPolicy(const PowerPolicy *policy) {
+    if (pmSupported) {
+        esp_pm_config_esp32_t config = {};
+        config.max_freq_mhz = policy->maxFrequency;
+        config.min_freq_mhz = policy->minFrequency;
+        config.light_sleep_enable =
+            policy->lightSleep && lightSleepSupported;
+
+        esp_err_t result = esp_pm_configure(&config);
+        if (result == ESP_ERR_NOT_SUPPORTED && config.light_sleep_enable) {
+            logWarn("Light sleep is not supported by the framework");
+            lightSleepSupported = false;
+            config.light_sleep_enable = false;
+            result = esp_pm_configure(&config);
+        }
+        if (result == ESP_OK) return;
+
+        logWarn("Power management is not supported (%d)", result);
+        pmSupported = false;
+    }
+
+    // Without esp_pm the frequency is fixed to the maximum of the phase
+    setCpuFrequencyMhz(policy->maxFrequency);
+}
+
+/**
+ * Logs the wall time spent in every phase
+ *
+ * @param now current time (millis())
+ */
+static void logStats(uint32_t now) {
+    unsigned long seconds[POWER_PHASES];
+    for (uint8_t i = 0; i < POWER_PHASES; i++) {
+        seconds[i] = phaseTime[i];
+        if (i == currentPhase) seconds[i] += now - phaseStart;
+        seconds[i] /= 1000;
+    }
+
+    logInfo("Phase time: %s %lus, %s %lus, %s %lus, %s %lus", phaseNames[0],
+            seconds[0], phaseNames[1], seconds[1], phaseNames[2], seconds[2],
+            phaseNames[3], seconds[3]);
+}
+
+/**
+ * Switches to the power policy of a phase, call once per loop pass
+ *
+ * @param phase POWER_PHASE_*
+ */
+void powerUpdate(uint8_t phase) {
+    uint32_t now = millis();
+
+    if (phase != currentPhase && phase < POWER_PHASES) {
+        if (currentPhase < POWER_PHASES) {
+            phaseTime[currentPhase] += now - phaseStart;
+        }
+        currentPhase = phase;
+        phaseStart = now;
+
+        const PowerPolicy *policy = &policies[phase];
+        logDebug("Power: %s (%d-%d MHz, light sleep %s)", phaseNames[phase],
+                 policy->minFrequency, policy->maxFrequency,
+                 policy->lightSleep && lightSleepSupported ? "on" : "off");
+        applyPolicy(policy);
+    }
+
+    if (now - lastLog > POWER_LOG_INTERVAL) {
+        lastLog = now;
+        logStats(now);
+    }
+}
+
+/**
+ * Sleeps for the loop delay of the current phase, call at the end of the
+ * main loop. Without a loop delay the next pass starts right away.
+ */
+void powerIdle() {
+    if (currentPhase >= POWER_PHASES) return;
+    uint16_t loopDelay = policies[currentPhase].loopDelay;
+    if (loopDelay > 0) vTaskDelay(pdMS_TO_TICKS(loopDelay));
+}
+
+/**
+ * Keeps the device out of light sleep until the lock is released, can be
+ * called from an ISR. Every call needs one powerRelease().
+ *
+ * @param lock POWER_LOCK_*
+ */
+void IRAM_ATTR powerAcquire(uint8_t lock) {
+    if (locks[lock] != NULL) esp_pm_lock_acquire(locks[lock]);
+}
+
+/**
+ * Releases a lock taken with powerAcquire(), can be called from an ISR
+ *
+ * @param lock POWER_LOCK_*
+ */
+void IRAM_ATTR powerRelease(uint8_t lock) {
+    if (locks[lock] != NULL) esp_pm_lock_release(locks[lock]);
+}
+
+/**
+ * Initializes the power management, the device starts disconnected. Has
+ * to be called before the modules using the locks are initialized.
+ */
+void powerInit() {
+    logInfo("Init: Power management");
+
+    for (uint8_t i = 0; i < POWER_LOCKS; i++) {
+        if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, lockNames[i],
+                               &locks[i]) != ESP_OK) {
+            locks[i] = NULL;
+        }
+    }
+
+    powerUpdate(POWER_PHASE_DISCONNECTED);
+}
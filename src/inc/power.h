@@ -0,0 +1,32 @@
+/*
+Skirmish ESP32 Firmware
+
+Power management - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+// Phases of the device with their own power policy
+#define POWER_PHASE_DISCONNECTED 0
+#define POWER_PHASE_LOBBY 1
+#define POWER_PHASE_COUNTDOWN 2
+#define POWER_PHASE_RUNNING 3
+#define POWER_PHASES 4
+
+// Activities that keep the device out of light sleep while they run, the
+// clocks of I2S, SPI and the hardware timers stop in light sleep
+#define POWER_LOCK_AUDIO 0    // Audio task while a clip is playing
+#define POWER_LOCK_DISPLAY 1  // Render task while a list is replayed
+#define POWER_LOCK_TRIGGER 2  // Trigger debounce timer while it runs
+#define POWER_LOCKS 3
+
+void powerInit();
+void powerUpdate(uint8_t phase);
+void powerIdle();
+
+void powerAcquire(uint8_t lock);
+void powerRelease(uint8_t lock);
@@ -0,0 +1,153 @@
+/*
+Skirmish ESP32 Firmware
+
+Flight recorder
+
+Keeps the last RECORDER_EVENTS events (boots, scene changes, shots, hits,
+BLE connects and disconnects, new heap low-water marks) in a ring buffer
+in RTC slow memory. The buffer isn't initialized at boot, so it survives
+panics, watchdog and software resets and deep sleep; a magic value tells
+it apart from the random contents after a power-on.
+
+At boot the events of the previous boots are copied and base64 encoded,
+they are uploaded to the app once it is connected (ACTION_FLIGHT_RECORD).
+Every boot starts with a RECORD_BOOT event carrying the reset reason and
+the boot count, events of a boot that were uploaded before are sent again
+and can be told apart by it.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "recorder.h"
+
+#include <esp_system.h>
+#include <mbedtls/base64.h>
+
+#include "../conf.h"
+#include "log.h"
+
+#define RECORDER_MAGIC 0x534b4652  // "SKFR"
+
+#if RECORDER_EVENTS > 40
+#error "The flight record doesn't fit into one BLE message"
+#endif
+
+// Size of the base64 encoded events, incl. the terminating null
+#define RECORDER_REPORT_SIZE \
+    (((RECORDER_EVENTS * sizeof(RecorderEvent) + 2) / 3) * 4 + 1)
+
+/**
+ * State kept in RTC memory across resets
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t head;   // Index of the next event
+    uint16_t count;  // Number of valid events
+    uint32_t boots;
+    RecorderEvent events[RECORDER_EVENTS];
+} RecorderState;
+
+RTC_NOINIT_ATTR static RecorderState state;
+
+// Events are recorded from the main loop and the bluetooth task
+static portMUX_TYPE stateLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Events of the previous boots, oldest first
+static char report[RECORDER_REPORT_SIZE];
+static bool reportPending = false;
+
+// Last recorded heap low-water mark (bytes)
+static uint32_t heapLowWater = 0;
+
+/**
+ * Encodes the events of the previous boots for the upload
+ */
+static void createReport() {
+    RecorderEvent events[RECORDER_EVENTS];
+    uint16_t first = (state.head + RECORDER_EVENTS - state.count) %
+                     RECORDER_EVENTS;
+    for (uint16_t i = 0; i < state.count; i++) {
+        events[i] = state.events[(first + i) % RECORDER_EVENTS];
+    }
+
+    size_t length = 0;
+    if (mbedtls_base64_encode((unsigned char *)report, sizeof(report),
+                              &length, (const unsigned char *)events,
+                              state.count * sizeof(RecorderEvent)) != 0) {
+        logError("Flight recorder: couldn't encode the report");
+        return;
+    }
+    reportPending = true;
+}
+
+/**
+ * Prepares the report of the previous boots and records the boot, call
+ * as early as possible
+ */
+void recorderInit() {
+    if (state.magic != RECORDER_MAGIC || state.head >= RECORDER_EVENTS ||
+        state.count > RECORDER_EVENTS) {
+        memset(&state, 0, sizeof(state));
+        state.magic = RECORDER_MAGIC;
+    } else if (state.count > 0) {
+        createReport();
+    }
+
+    state.boots++;
+    esp_reset_reason_t reason = esp_reset_reason();
+    recorderRecord(RECORD_BOOT, reason, state.boots);
+
+    logInfo("Flight recorder: boot %lu, reset reason %d, %u events recorded",
+            (unsigned long)state.boots, reason, state.count);
+}
+
+/**
+ * Records an event
+ *
+ * @param type RECORD_*
+ * @param a first value, see recorder.h
+ * @param b second value, see recorder.h
+ */
+void recorderRecord(uint8_t type, uint8_t a, uint16_t b) {
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&stateLock);
+    RecorderEvent *event = &state.events[state.head];
+    event->time = now;
+    event->type = type;
+    event->a = a;
+    event->b = b;
+    state.head = (state.head + 1) % RECORDER_EVENTS;
+    if (state.count < RECORDER_EVENTS) state.count++;
+    portEXIT_CRITICAL(&stateLock);
+}
+
+/**
+ * Records the heap low-water mark when it dropped by RECORDER_HEAP_STEP
+ * bytes, call once per loop pass
+ */
+void recorderUpdate() {
+    uint32_t lowWater = esp_get_minimum_free_heap_size();
+    if (heapLowWater != 0 && heapLowWater - lowWater < RECORDER_HEAP_STEP) {
+        return;
+    }
+
+    heapLowWater = lowWater;
+    recorderRecord(RECORD_HEAP_LOW, lowWater >> 16, lowWater & 0xffff);
+}
+
+/**
+ * @return true if the events of the previous boots weren't uploaded yet
+ */
+bool recorderReportPending() { return reportPending; }
+
+/**
+ * @return the events of the previous boots (RecorderEvent), oldest first
+ * and base64 encoded
+ */
+const char *recorderReport() { return report; }
+
+/**
+ * Marks the report as uploaded
+ */
+void recorderReportSent() { reportPending = false; }
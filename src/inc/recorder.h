@@ -0,0 +1,39 @@
+/*
+Skirmish ESP32 Firmware
+
+Flight recorder - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+// Recorded events and the meaning of their a and b fields
+#define RECORD_BOOT 0            // a: reset reason, b: boot count
+#define RECORD_SCENE 1           // a: scene (SCENE_*)
+#define RECORD_SHOT 2            // b: shot ID
+#define RECORD_HIT 3             // a: player ID of the shooter, b: shot ID
+#define RECORD_BLE_CONNECT 4     //
+#define RECORD_BLE_DISCONNECT 5  //
+#define RECORD_HEAP_LOW 6        // a << 16 | b: lowest free heap (bytes)
+
+/**
+ * A recorded event, uploaded as is (little endian, 8 bytes)
+ */
+typedef struct {
+    uint32_t time;  // millis() of the boot that recorded it
+    uint8_t type;   // RECORD_*
+    uint8_t a;
+    uint16_t b;
+} RecorderEvent;
+
+void recorderInit();
+
+void recorderRecord(uint8_t type, uint8_t a, uint16_t b);
+void recorderUpdate();
+
+bool recorderReportPending();
+const char *recorderReport();
+void recorderReportSent();
@@ -16,7 +16,7 @@ Copyright (C) 2023 Ole Lange
 #include "../../theme.h"
 #include "../audio.h"
 #include "../const.h"
-#include "../hardware_control.h"
+#include "../haptics.h"
 #include "../hitpoint.h"
 #include "../log.h"
 #include "../time.h"
@@ -26,8 +26,12 @@ Copyright (C) 2023 Ole Lange
  */
 CountdownScene::CountdownScene(SkirmishUI *ui) : SkirmishUIScene(ui) {
     this->id = SCENE_COUNTDOWN;
-    countdown = (char *)malloc(3 * sizeof(char));
-    strcpy(countdown, "  ");
+
+#ifndef NO_DISPLAY
+    countdown = new LabelWidget(ui->display, 120, 200, SDT_HEADER_FONT, 3,
+                                SDT_TEXT_COLOR, SDT_BG_COLOR);
+    addWidget(countdown);
+#endif
 }
 
 /**
@@ -42,42 +46,35 @@ bool CountdownScene::update() {
     secLeft = ui->game->startTime - getCurrentTS();
     if (secLeft >= 0 && secLeft != prevSecLeft) {
         prevSecLeft = secLeft;
-        sprintf(countdown, "%d", secLeft);
+
+#ifndef NO_DISPLAY
+        char text[4];
+        snprintf(text, sizeof(text), "%d", secLeft);
+        countdown->setText(text);
+#endif
 
 #ifndef NO_AUDIO
         if (secLeft == 3) {
-            audioBegin("/three.wav");
+            audioBegin(ASSET_SOUND_THREE, AUDIO_PRIORITY_CUE);
         } else if (secLeft == 2) {
-            audioBegin("/two.wav");
+            audioBegin(ASSET_SOUND_TWO, AUDIO_PRIORITY_CUE);
         } else if (secLeft == 1) {
-            audioBegin("/one.wav");
+            audioBegin(ASSET_SOUND_ONE, AUDIO_PRIORITY_CUE);
         } else if (secLeft == 0) {
-            audioBegin("/fight.wav");
+            audioBegin(ASSET_SOUND_FIGHT, AUDIO_PRIORITY_CUE);
         }
 #endif
-        hardwareVibrate(150);
+        if (secLeft > 0) hapticsPlay(HAPTIC_COUNTDOWN_TICK);
 
         return true;  // render if countdown has changed
     }
 
     // if the countdown is finished change to the game scene
     if (secLeft <= 0) {
-        hardwareVibrate(300);
+        hapticsPlay(HAPTIC_GAME_START);
         ui->setScene(SCENE_GAME);
         return false;
     }
 
     return false;
 }
-
-/**
- * Renders the scene
- */
-void CountdownScene::render() {
-#ifndef NO_DISPLAY
-    ui->display->setFont(SDT_HEADER_FONT);
-    ui->display->setTextColor(SDT_TEXT_COLOR);
-
-    ui->display->centerText(countdown, 200, 3, true, SDT_BG_COLOR);
-#endif
-}
@@ -15,12 +15,11 @@ class CountdownScene : public SkirmishUIScene {
     int16_t secLeft;
     int16_t prevSecLeft;
 
-    char* countdown;
+    LabelWidget* countdown;
 
    public:
     CountdownScene(SkirmishUI* ui);
 
     void onSet(uint8_t id);
     bool update();
-    void render();
 };
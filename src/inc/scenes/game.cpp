@@ -14,26 +14,81 @@ Copyright (C) 2023 Ole Lange
 
 #include "../../conf.h"
 #include "../../fonts/bitmaps.h"
+#include "../../fonts/skvec_runs.h"
 #include "../../theme.h"
 #include "../const.h"
-#include "../hardware_control.h"
+#include "../haptics.h"
 #include "../hitpoint.h"
 // #include "../mocks.h"  // MOCK: REMOVE
 
+#define HITPOINT_STATE(anim, r, g, b)                  \
+    (((uint32_t)(anim) << 24) | ((uint32_t)(r) << 16) | \
+     ((uint32_t)(g) << 8) | (uint32_t)(b))
+#define HITPOINT_STATE_UNKNOWN 0xffffffff
+
 /**
  * Constructor of the scene. Sets the ID
  */
 GameScene::GameScene(SkirmishUI *ui) : SkirmishUIScene(ui) {
     this->id = SCENE_GAME;
 
-    knownPlayerName = (char *)malloc(33 * sizeof(char));
-    knownTeamName = (char *)malloc(33 * sizeof(char));
+#ifndef NO_DISPLAY
+    SkirmishDisplay *display = ui->display;
+
+    playerBar = new VecWidget(display, &skvecRuns_playerBar, 0, 0,
+                              SDT_PRIMARY_COLOR);
+    gameName = new LabelWidget(display, 120, 75, SDT_HEADER_FONT, 1,
+                               SDT_PRIMARY_COLOR, SDT_BG_COLOR);
+    playerName = new LabelWidget(display, 120, 110, SDT_SUBHEADER_FONT, 1,
+                                 SDT_PRIMARY_COLOR, SDT_BG_COLOR);
+    playerRank = new LabelWidget(display, 120, 127, SDT_SUBHEADER_FONT, 1,
+                                 SDT_SECONDARY_COLOR, SDT_BG_COLOR);
+    teamName = new LabelWidget(display, 120, 160, SDT_SUBHEADER_FONT, 1,
+                               SDT_PRIMARY_COLOR, SDT_BG_COLOR);
+    teamRank = new LabelWidget(display, 120, 177, SDT_SUBHEADER_FONT, 1,
+                               SDT_SECONDARY_COLOR, SDT_BG_COLOR);
+    ammo = new CounterWidget(display, 15, 210, "\x0F %d", SDT_TEXT_FONT, 2,
+                             SDT_TEXT_COLOR, SDT_BG_COLOR);
+    points = new CounterWidget(display, 140, 210, "\x04 %05d", SDT_TEXT_FONT,
+                               2, SDT_TEXT_COLOR, SDT_BG_COLOR);
+    healthSymbol = new LabelWidget(display, 15, 237, SDT_TEXT_FONT, 2,
+                                   SDT_TEXT_COLOR, SDT_BG_COLOR,
+                                   WIDGET_ALIGN_LEFT);
+    healthSymbol->setText("\x03");
+    health = new BarWidget(display, 30, 240, 10, 17, 10, 2, 10,
+                           SDT_HEALTH_COLOR, SDT_HEALTH_BG_COLOR);
+    phaserIcon = new IconWidget(display, 6, 266, bitmapPhaser, 48, 48,
+                                SDT_GAME_SYMBOL_DISABLED_COLOR, SDT_BG_COLOR);
+    shieldIcon = new IconWidget(display, 66, 266, bitmapShield, 48, 48,
+                                SDT_GAME_SYMBOL_DISABLED_COLOR, SDT_BG_COLOR);
+    ammoIcon = new IconWidget(display, 126, 266, bitmapAmmo, 48, 48,
+                              SDT_GAME_SYMBOL_DISABLED_COLOR, SDT_BG_COLOR);
+
+    addWidget(playerBar);
+    addWidget(gameName);
+    addWidget(playerName);
+    addWidget(playerRank);
+    addWidget(teamName);
+    addWidget(teamRank);
+    addWidget(ammo);
+    addWidget(points);
+    addWidget(healthSymbol);
+    addWidget(health);
+    addWidget(phaserIcon);
+    addWidget(shieldIcon);
+    addWidget(ammoIcon);
+#endif
 }
 
 /**
  * Is called when the scene is set
  */
-void GameScene::onSet(uint8_t id) {}
+void GameScene::onSet(uint8_t id) {
+    // Other scenes changed the hitpoints and everything has to be redrawn
+    hitpointState = HITPOINT_STATE_UNKNOWN;
+    dataChanged = true;
+    snapValues = true;
+}
 
 /**
  * Updates the splashscreen scene
@@ -43,16 +98,16 @@ bool GameScene::update() {
 
     // Start blinking if the player got hit
     if (ui->game->player.wasHit) {
-        hardwareVibrate(150);
+        hapticsPlay(HAPTIC_HIT);
         hitBlinkUntil = mnow + 1500;
         ui->game->player.wasHit = false;
-        return true;
+        hitFlash.begin(255, 0, UI_HIT_FLASH_TIME, mnow);
+        ui->startAnimation();
     }
 
     // Stop blinking after the specified delay
     if (mnow > hitBlinkUntil && hitBlinkUntil != 0) {
         hitBlinkUntil = 0;
-        return true;
     }
 
     // Show msgbox if the player has hit
@@ -61,208 +116,155 @@ bool GameScene::update() {
         ui->game->player.hasHit = false;
     }
 
-    // Re-Render if the canFire state changed
-    prevCanFire = canFire;
     canFire = ui->game->player.canFire();
-    if (canFire != prevCanFire) {
-        return true;
-    }
 
     if (ui->game->wasDataUpdated | ui->game->player.wasDataUpdated |
         ui->game->team.wasDataUpdated) {
         ui->game->wasDataUpdated = false;
         ui->game->player.wasDataUpdated = false;
         ui->game->team.wasDataUpdated = false;
-
-        if (strcmp(knownPlayerName, ui->game->player.name) != 0) {
-            strcpy(knownPlayerName, ui->game->player.name);
-            ui->clearRequired = true;
-        }
-
-        if (strcmp(knownTeamName, ui->game->team.name) != 0) {
-            strcpy(knownTeamName, ui->game->team.name);
-            ui->clearRequired = true;
-        }
-
-        return true;
+        dataChanged = true;
     }
 
+    updateHitpoints();
+
+#ifndef NO_DISPLAY
+    updateWidgets();
+    return isDirty();
+#else
     return false;
+#endif
 }
 
 /**
- * Renders the scene
+ * Sends the hitpoint animation and color if they changed. Every
+ * change is a slow I2C transfer, so the state is not sent periodically.
  */
-void GameScene::render() {
-    uint8_t player_r, player_g, player_b;
+void GameScene::updateHitpoints() {
+    uint8_t animation = HP_ANIM_SOLID;
+    uint8_t r = 0, g = 0, b = 0;
 
-    player_r = ui->game->player.color_r;
-    player_g = ui->game->player.color_g;
-    player_b = ui->game->player.color_b;
-
-    // Set hitpoint color
     if (hitBlinkUntil > 0) {
-        hitpointSelectAnimation(HP_ANIM_BLINK);
-        hitpointSetAnimationSpeed(15);
-        hitpointSetColor(255, 255, 255);
-    } else {
-        if (!ui->game->player.isInviolable() ||
-            !ui->game->player.inviolableLightsOff) {
-            hitpointSelectAnimation(HP_ANIM_SOLID);
-            hitpointSetColor(player_r, player_g, player_b);
-        } else {
-            hitpointSelectAnimation(HP_ANIM_SOLID);
-            hitpointSetColor(0, 0, 0);
-        }
+        animation = HP_ANIM_BLINK;
+        r = g = b = 255;
+    } else if (!ui->game->player.isInviolable() ||
+               !ui->game->player.inviolableLightsOff) {
+        r = ui->game->player.color_r;
+        g = ui->game->player.color_g;
+        b = ui->game->player.color_b;
     }
 
-#ifndef NO_DISPLAY
-
-    // Drawing player colored bar
-    uint16_t playerColor = ui->display->gammaCorrection(
-        ui->display->color(ui->game->player.color_r, ui->game->player.color_g,
-                           ui->game->player.color_b));
-
-    ui->display->tft.fillRect(35, 27, 170, 13, playerColor);
-    ui->display->tft.fillTriangle(26, 33, 35, 27, 35, 39, playerColor);
-    ui->display->tft.fillTriangle(214, 33, 205, 27, 205, 39, playerColor);
-
-    // Drawing game name
-    if (strlen(ui->game->gid) < 10)  // Selecting font size based on length
-        ui->display->setFont(SDT_HEADER_FONT);
-    else
-        ui->display->setFont(SDT_SUBHEADER_FONT);
-
-    ui->display->setTextColor(SDT_PRIMARY_COLOR);
-    ui->display->centerText(ui->game->gid, 75, 1);
-
-    // Drawing player name
-    ui->display->setFont(SDT_SUBHEADER_FONT);
-    ui->display->setTextColor(SDT_PRIMARY_COLOR);
-    ui->display->centerText(ui->game->player.name, 110, 1);
-
-    // Drawing player ranking
-    char rankingString[8];
-    sprintf(rankingString, "%d/%d", ui->game->player.rank,
-            ui->game->playerCount);
-    ui->display->setFont(SDT_SUBHEADER_FONT);
-    ui->display->setTextColor(SDT_SECONDARY_COLOR);
-    ui->display->centerText(rankingString, 127, 1, true, SDT_BG_COLOR);
-
-    // Drawing team name
-    if (ui->game->team.tid != 0) {  // Team ID 0 -> No Team
-        ui->display->setFont(SDT_SUBHEADER_FONT);
-        ui->display->setTextColor(SDT_PRIMARY_COLOR);
-        ui->display->centerText(ui->game->team.name, 160, 1);
-    }
-
-    // Drawing team ranking
-    if (ui->game->team.tid != 0) {  // Team ID 0 -> No Team
-        sprintf(rankingString, "%d/%d", ui->game->team.rank,
-                ui->game->teamCount);
-        ui->display->setFont(SDT_SUBHEADER_FONT);
-        ui->display->setTextColor(SDT_SECONDARY_COLOR);
-        ui->display->centerText(rankingString, 177, 1, true, SDT_BG_COLOR);
-    }
+    uint32_t state = HITPOINT_STATE(animation, r, g, b);
+    if (state == hitpointState) return;
+    hitpointState = state;
 
-    // Clear line with ammo and points display
-    ui->display->tft.fillRect(0, 210, 240, 20,
-                              ui->display->gammaCorrection(SDT_BG_COLOR));
-
-    // Drawing Left Ammo
-    if (ui->game->player.ammoLimit) {
-        ui->display->setFont(SDT_TEXT_FONT);
-        ui->display->tft.setTextSize(2);
-        ui->display->setTextColor(SDT_TEXT_COLOR);
-        ui->display->tft.setCursor(15, 210);
-        ui->display->tft.printf("\x0F %d", ui->game->player.ammo);
-    }
+    hitpointSelectAnimation(animation);
+    if (animation == HP_ANIM_BLINK) hitpointSetAnimationSpeed(15);
+    hitpointSetColor(r, g, b);
+}
 
-    // Drawing Points
-    ui->display->setFont(SDT_TEXT_FONT);
-    ui->display->tft.setTextSize(2);
-    ui->display->setTextColor(SDT_TEXT_COLOR);
-    ui->display->tft.setCursor(140, 210);
-    ui->display->tft.printf("\x04 %05d", ui->game->player.points);
-
-    // Drawing Health
-    uint16_t healthY = 240;
-    uint8_t healthX = 30;
-    uint16_t color = SDT_HEALTH_COLOR;
-    uint8_t barWidth = 17;
-    uint8_t barHeight = 10;
-    uint8_t barSpace = 2;
-    ui->display->setFont(SDT_TEXT_FONT);
-    ui->display->tft.setTextSize(2);
-    ui->display->setTextColor(SDT_TEXT_COLOR);
-    ui->display->tft.setCursor(15, healthY - 3);
-    ui->display->tft.printf("\x03");
-    for (int j = 0; j < 10; j++) {
-        for (int i = 0; i < barWidth; i++) {
-            if ((j * barWidth) + i <
-                ((float)ui->game->player.health * (barWidth / 10.0)))
-                color = SDT_HEALTH_COLOR;
-            else
-                color = SDT_HEALTH_BG_COLOR;
-            ui->display->tft.drawLine(
-                healthX + 10 + i + ((barWidth + barSpace) * j), healthY,
-                healthX + i + ((barWidth + barSpace) * j), healthY + barHeight,
-                ui->display->gammaCorrection(color));
+#ifndef NO_DISPLAY
+/**
+ * Passes the current game data to the widgets. Widgets ignore values that
+ * didn't change, texts are only formatted if new data was received.
+ */
+void GameScene::updateWidgets() {
+    Game *game = ui->game;
+    uint32_t now = millis();
+
+    if (dataChanged) {
+        dataChanged = false;
+
+        playerColor = ui->display->color(
+            game->player.color_r, game->player.color_g, game->player.color_b);
+        playerBar->setColor(
+            blendColor(playerColor, SDT_TEXT_COLOR, hitFlash.value(now)));
+
+        // Selecting font size based on length
+        gameName->setFont(strlen(game->gid) < 10 ? SDT_HEADER_FONT
+                                                 : SDT_SUBHEADER_FONT);
+        gameName->setText(game->gid);
+        playerName->setText(game->player.name);
+
+        char rankingString[8];
+        snprintf(rankingString, sizeof(rankingString), "%d/%d",
+                 game->player.rank, game->playerCount);
+        playerRank->setText(rankingString);
+
+        // Team ID 0 -> No Team
+        teamName->setVisible(game->team.tid != 0);
+        teamName->setText(game->team.name);
+        teamRank->setVisible(game->team.tid != 0);
+        snprintf(rankingString, sizeof(rankingString), "%d/%d",
+                 game->team.rank, game->teamCount);
+        teamRank->setText(rankingString);
+
+        roll(&pointsRoll, game->player.points, now);
+        roll(&healthRoll, (int32_t)(game->player.health * 100), now);
+        if (snapValues) {
+            snapValues = false;
+            applyAnimations(now);
         }
     }
 
-    // Clearing symbol area
-    ui->display->tft.fillRect(0, 260, 240, 60,
-                              ui->display->gammaCorrection(SDT_BG_COLOR));
-
-    // Drawing Phaser Enable Symbol
-    ui->display->tft.drawBitmap(
-        6, 266, bitmapPhaser, 48, 48,
-        ui->display->gammaCorrection(canFire ? SDT_PRIMARY_COLOR
-                                             : SDT_GAME_SYMBOL_DISABLED_COLOR));
-    // Drawing Inviolable Symbol
-    ui->display->tft.drawBitmap(
-        66, 266, bitmapShield, 48, 48,
-        ui->display->gammaCorrection(ui->game->player.isInviolable()
-                                         ? SDT_PRIMARY_COLOR
-                                         : SDT_GAME_SYMBOL_DISABLED_COLOR));
-    // Drawing Ammo Limit Symbol
-    ui->display->tft.drawBitmap(
-        126, 266, bitmapAmmo, 48, 48,
-        ui->display->gammaCorrection(ui->game->player.ammoLimit
-                                         ? SDT_PRIMARY_COLOR
-                                         : SDT_GAME_SYMBOL_DISABLED_COLOR));
-
-    /*
-    // Drawling line over it if canFire is false
-    if (!canFire) {
-        ui->display->tft.drawLine(6, 312, 52, 266, 0xffff);
-        ui->display->tft.drawLine(6, 313, 53, 266, 0xffff);
-        ui->display->tft.drawLine(6, 314, 54, 266, 0xffff);
-        ui->display->tft.drawLine(7, 314, 54, 267, 0xffff);
-        ui->display->tft.drawLine(8, 314, 54, 268, 0xffff);
-    }
-
-    if (!ui->game->player.isInviolable()) {
-        ui->display->tft.drawLine(66, 312, 112, 266, 0xffff);
-        ui->display->tft.drawLine(66, 313, 113, 266, 0xffff);
-        ui->display->tft.drawLine(66, 314, 114, 266, 0xffff);
-        ui->display->tft.drawLine(67, 314, 114, 267, 0xffff);
-        ui->display->tft.drawLine(68, 314, 114, 268, 0xffff);
-    }
+    // These change without new data (time, shots) and are
+    // checked on every update
+    ammo->setVisible(game->player.ammoLimit);
+    ammo->setValue(game->player.ammo);
+    phaserIcon->setColor(canFire ? SDT_PRIMARY_COLOR
+                                 : SDT_GAME_SYMBOL_DISABLED_COLOR);
+    shieldIcon->setColor(game->player.isInviolable()
+                             ? SDT_PRIMARY_COLOR
+                             : SDT_GAME_SYMBOL_DISABLED_COLOR);
+    ammoIcon->setColor(game->player.ammoLimit
+                           ? SDT_PRIMARY_COLOR
+                           : SDT_GAME_SYMBOL_DISABLED_COLOR);
+}
 
-    if (!ui->game->player.ammoLimit) {
-        ui->display->tft.drawLine(126, 312, 172, 266, 0xffff);
-        ui->display->tft.drawLine(126, 313, 173, 266, 0xffff);
-        ui->display->tft.drawLine(126, 314, 174, 266, 0xffff);
-        ui->display->tft.drawLine(127, 314, 174, 267, 0xffff);
-        ui->display->tft.drawLine(128, 314, 174, 268, 0xffff);
+/**
+ * Lets a value roll to its new value, or jumps to it if the scene was just
+ * entered
+ *
+ * @param tween the tween of the value
+ * @param value the new value
+ * @param now current time (millis())
+ */
+void GameScene::roll(Tween *tween, int32_t value, uint32_t now) {
+    if (tween->target() == value) return;
+    if (snapValues) {
+        tween->set(value);
+        return;
     }
-    */
+    tween->begin(tween->value(now), value, UI_COUNTER_ROLL_TIME, now);
+    ui->startAnimation();
+}
 
-    // Drawing Additional Symbol field
-    // TODO
+/**
+ * Sets the animated widgets to the values of the given time
+ *
+ * @param now time of the frame (millis())
+ */
+void GameScene::applyAnimations(uint32_t now) {
+    points->setValue(pointsRoll.value(now));
+    health->setValue(healthRoll.value(now) / 100.0f, 100);
+    playerBar->setColor(
+        blendColor(playerColor, SDT_TEXT_COLOR, hitFlash.value(now)));
+}
+#endif
 
-    // Drawing msg box showing if you've hit someone
+/**
+ * Draws the hit flash and rolls the points and the health bar, widgets
+ * only redraw what changed between two frames
+ *
+ * @param now time of the frame (millis())
+ * @return true if an animation is still running
+ */
+bool GameScene::animate(uint32_t now) {
+#ifndef NO_DISPLAY
+    applyAnimations(now);
+    return hitFlash.isRunning(now) || pointsRoll.isRunning(now) ||
+           healthRoll.isRunning(now);
+#else
+    return false;
 #endif
 }
@@ -11,18 +11,48 @@ Copyright (C) 2023 Ole Lange
 #include "scene.h"
 
 class GameScene : public SkirmishUIScene {
+   private:
+    VecWidget *playerBar;
+    LabelWidget *gameName;
+    LabelWidget *playerName;
+    LabelWidget *playerRank;
+    LabelWidget *teamName;
+    LabelWidget *teamRank;
+    CounterWidget *ammo;
+    CounterWidget *points;
+    LabelWidget *healthSymbol;
+    BarWidget *health;
+    IconWidget *phaserIcon;
+    IconWidget *shieldIcon;
+    IconWidget *ammoIcon;
+
+    bool dataChanged = true;
+
+    // Hit flash of the player bar and rolling points and health, values
+    // jump without animation when the scene is entered
+    Tween hitFlash;
+    Tween pointsRoll;
+    Tween healthRoll;  // Hundredths
+    uint16_t playerColor = 0;
+    bool snapValues = true;
+
+    void roll(Tween *tween, int32_t value, uint32_t now);
+    void applyAnimations(uint32_t now);
+
+    // Last state sent to the hitpoints (animation and color)
+    uint32_t hitpointState;
+
+    void updateHitpoints();
+    void updateWidgets();
+
    public:
     GameScene(SkirmishUI *ui);
 
     void onSet(uint8_t id);
     bool update();
-    void render();
+    bool animate(uint32_t now);
 
     uint32_t hitBlinkUntil = 0;
 
-    bool prevCanFire = false;
     bool canFire = false;
-
-    char *knownTeamName;
-    char *knownPlayerName;
 };
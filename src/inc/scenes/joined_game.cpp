@@ -9,7 +9,7 @@ Copyright (C) 2023 Ole Lange
 #include "joined_game.h"
 
 #include "../../conf.h"
-#include "../../fonts/skvec.h"
+#include "../../fonts/skvec_runs.h"
 #include "../../theme.h"
 #include "../const.h"
 #include "../hitpoint.h"
@@ -19,6 +19,21 @@ Copyright (C) 2023 Ole Lange
  */
 JoinedGameScene::JoinedGameScene(SkirmishUI *ui) : SkirmishUIScene(ui) {
     this->id = SCENE_JOINED_GAME;
+
+#ifndef NO_DISPLAY
+    title = new LabelWidget(ui->display, 120, 170, SDT_HEADER_FONT,
+                            SDT_HEADER_FONT_SIZE, SDT_PRIMARY_COLOR,
+                            SDT_BG_COLOR);
+    title->setText("SKIRMISH");
+    gameNameBlock = new VecWidget(ui->display, &skvecRuns_gameNameBlock, 40,
+                                  185, SDT_PRIMARY_COLOR);
+    gameName = new LabelWidget(ui->display, 120, 210, SDT_SUBHEADER_FONT, 1,
+                               SDT_BG_COLOR, SDT_PRIMARY_COLOR);
+
+    addWidget(title);
+    addWidget(gameNameBlock);
+    addWidget(gameName);
+#endif
 }
 
 /**
@@ -32,26 +47,12 @@ void JoinedGameScene::onSet(uint8_t id) {}
 bool JoinedGameScene::update() {
     if (ui->game->startTime > 0) {
         ui->setScene(SCENE_COUNTDOWN);
+        return false;
     }
 
-    return false;
-}
-
-/**
- * Renders the scene
- */
-void JoinedGameScene::render() {
 #ifndef NO_DISPLAY
-    ui->display->setFont(SDT_HEADER_FONT);
-
-    ui->display->setTextColor(SDT_PRIMARY_COLOR);
-    ui->display->centerText("SKIRMISH", 170, SDT_HEADER_FONT_SIZE);
-
-    ui->display->drawVec(skvec_gameNameBlock, 40, 185, SDT_PRIMARY_COLOR);
-
-    ui->display->setFont(SDT_SUBHEADER_FONT);
-    ui->display->setTextColor(SDT_BG_COLOR);
-    ui->display->centerText(ui->game->gid, 210, 1);
-
+    gameName->setText(ui->game->gid);
 #endif
+
+    return isDirty();
 }
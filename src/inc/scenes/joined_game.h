@@ -11,10 +11,14 @@ Copyright (C) 2023 Ole Lange
 #include "scene.h"
 
 class JoinedGameScene : public SkirmishUIScene {
+   private:
+    LabelWidget *title;
+    VecWidget *gameNameBlock;
+    LabelWidget *gameName;
+
    public:
     JoinedGameScene(SkirmishUI *ui);
 
     void onSet(uint8_t id);
     bool update();
-    void render();
 };
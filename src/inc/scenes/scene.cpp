@@ -8,6 +8,8 @@ Copyright (C) 2023 Ole Lange
 
 #include "scene.h"
 
+#include "../log.h"
+
 /**
  * Constructor
  */
@@ -28,6 +30,60 @@ void SkirmishUIScene::onSet(uint8_t id) { this->id = id; }
  */
 bool SkirmishUIScene::update() { return false; }
 
-void SkirmishUIScene::render() {}
+/**
+ * Advances the animations of the scene to the given time, only called
+ * while an animation is running (see SkirmishUI::startAnimation()).
+ * Widgets are set to the animated values and redrawn by render().
+ *
+ * @param now time of the frame (millis())
+ * @return true if an animation is still running
+ */
+bool SkirmishUIScene::animate(uint32_t now) { return false; }
+
+/**
+ * Registers a widget of the scene, registered widgets are
+ * invalidated and rendered by the default implementations
+ *
+ * @param widget the widget
+ */
+void SkirmishUIScene::addWidget(SkirmishUIWidget *widget) {
+    if (widgetCount >= SCENE_MAX_WIDGETS) {
+        logError("Scene %d: Too many widgets", id);
+        return;
+    }
+    widgets[widgetCount++] = widget;
+}
+
+/**
+ * Forces all widgets to be redrawn on the next render() call
+ *
+ * @param cleared true if the screen was cleared
+ */
+void SkirmishUIScene::invalidate(bool cleared) {
+    for (uint8_t i = 0; i < widgetCount; i++) {
+        widgets[i]->invalidate(cleared);
+    }
+}
+
+/**
+ * @return true if any widget has to be redrawn
+ */
+bool SkirmishUIScene::isDirty() {
+    for (uint8_t i = 0; i < widgetCount; i++) {
+        if (widgets[i]->isDirty()) return true;
+    }
+    return false;
+}
+
+/**
+ * Renders all widgets that changed since the last call
+ */
+void SkirmishUIScene::render() {
+#ifndef NO_DISPLAY
+    for (uint8_t i = 0; i < widgetCount; i++) {
+        widgets[i]->render();
+    }
+#endif
+}
 
 uint8_t SkirmishUIScene::getID() { return id; }
@@ -9,15 +9,24 @@ Copyright (C) 2023 Ole Lange
 #pragma once
 
 #include "../ui.h"
+#include "../widgets.h"
+
+#define SCENE_MAX_WIDGETS 16
 
 /**
  * Classes inherited from this class are drawing the
- * scenes
+ * scenes. Scenes are built of widgets which are only
+ * redrawn if their value changed.
  */
 class SkirmishUIScene {
    protected:
     uint8_t id;
 
+    SkirmishUIWidget *widgets[SCENE_MAX_WIDGETS];
+    uint8_t widgetCount = 0;
+
+    void addWidget(SkirmishUIWidget *widget);
+
    public:
     SkirmishUIScene(SkirmishUI *ui);
 
@@ -27,6 +36,9 @@ class SkirmishUIScene {
 
     virtual void onSet(uint8_t id);
     virtual bool update();
+    virtual bool animate(uint32_t now);
+    virtual void invalidate(bool cleared);
+    bool isDirty();
     virtual void render();
 };
 
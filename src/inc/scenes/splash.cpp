@@ -23,9 +23,20 @@ Copyright (C) 2023 Ole Lange
 SplashscreenScene::SplashscreenScene(SkirmishUI *ui) : SkirmishUIScene(ui) {
     this->id = SCENE_SPLASHSCREEN;
 
-    splashText = (char *)malloc(32 * sizeof(char));
+#ifndef NO_DISPLAY
+    title = new LabelWidget(ui->display, 120, 170, SDT_HEADER_FONT,
+                            SDT_HEADER_FONT_SIZE, SDT_PRIMARY_COLOR,
+                            SDT_BG_COLOR);
+    title->setText("SKIRMISH");
+    splashText = new LabelWidget(ui->display, 120, 175, SDT_TEXT_FONT, 1,
+                                 SDT_TEXT_COLOR, SDT_BG_COLOR);
+
+    addWidget(title);
+    addWidget(splashText);
+#endif
 
-    qrBytes = (uint8_t *)malloc(qrcode_getBufferSize(3) * sizeof(uint8_t));
+    qrBytes = (uint8_t *)malloc(qrcode_getBufferSize(SPLASH_QR_VERSION) * sizeof(uint8_t));
+    qrImage = (uint8_t *)malloc(SPLASH_QR_MODULES * SPLASH_QR_STRIDE);
 }
 
 /**
@@ -33,10 +44,11 @@ SplashscreenScene::SplashscreenScene(SkirmishUI *ui) : SkirmishUIScene(ui) {
  */
 void SplashscreenScene::onSet(uint8_t id) {
     this->id = id;
+    const char *text;
     if (id == SCENE_SPLASHSCREEN) {
-        strcpy(splashText, "Loading...");
+        text = "Loading...";
     } else if (id == SCENE_BLE_CONNECT) {
-        strcpy(splashText, "Waiting for connection...");
+        text = "Waiting for connection...";
 
         // Setting hitpoints to breathe animation
         // to indicate that the device is waiting
@@ -45,69 +57,88 @@ void SplashscreenScene::onSet(uint8_t id) {
         hitpointSetAnimationSpeed(2);
         hitpointSetColor(SDT_PRIMARY_COLOR_RGB);
 
-        // Generating QR Code
-        qrcode_initText(&nameQR, qrBytes, 3, ECC_LOW, ui->bluetooth->getName());
+        // Generating QR Code, its modules are packed into an image once
+        qrcode_initText(&nameQR, qrBytes, SPLASH_QR_VERSION, ECC_LOW,
+                        ui->bluetooth->getName());
+        memset(qrImage, 0, SPLASH_QR_MODULES * SPLASH_QR_STRIDE);
+        for (uint8_t y = 0; y < nameQR.size; y++) {
+            for (uint8_t x = 0; x < nameQR.size; x++) {
+                if (!qrcode_getModule(&nameQR, x, y)) continue;
+                qrImage[y * SPLASH_QR_STRIDE + (x >> 3)] |= 0x80 >> (x & 7);
+            }
+        }
     } else if (id == SCENE_BLE_RECONNECT) {
-        strcpy(splashText, "Please re-connect!");
+        text = "Please re-connect!";
 
         hitpointSelectAnimation(HP_ANIM_ROTATE);
         hitpointSetAnimationSpeed(8);
         hitpointSetColor(0, 0, 255);
 
     } else if (id == SCENE_NO_GAME) {
-        strcpy(splashText, "Please join a game!");
+        text = "Please join a game!";
 
         // turn off leds
         hitpointSelectAnimation(HP_ANIM_SOLID);
         hitpointSetColor(this->ui->stbR, this->ui->stbG, this->ui->stbB);
+        standbyColor =
+            (ui->stbR << 16) | (ui->stbG << 8) | (uint32_t)ui->stbB;
     } else {
-        strcpy(splashText, "<INVALID SCENE>");
+        text = "<INVALID SCENE>";
     }
+
+#ifndef NO_DISPLAY
+    uint8_t base_y = 170;
+    if (id == SCENE_BLE_CONNECT) base_y = 80;
+
+    title->setPosition(120, base_y);
+    title->setColor((id == SCENE_BLE_RECONNECT) ? SDT_SECONDARY_COLOR
+                                                : SDT_PRIMARY_COLOR);
+    splashText->setPosition(120, base_y + 5);
+    splashText->setText(text);
+#endif
 }
 
 /**
  * Updates the splashscreen scene
  */
-bool SplashscreenScene::update() { return false; }
+bool SplashscreenScene::update() {
+    // Following standby color changes
+    if (this->id == SCENE_NO_GAME) {
+        uint32_t color =
+            (ui->stbR << 16) | (ui->stbG << 8) | (uint32_t)ui->stbB;
+        if (color != standbyColor) {
+            standbyColor = color;
+            hitpointSelectAnimation(HP_ANIM_SOLID);
+            hitpointSetColor(this->ui->stbR, this->ui->stbG, this->ui->stbB);
+        }
+    }
+
+    return isDirty();
+}
+
+/**
+ * Forces a redraw of the widgets and the qr code
+ *
+ * @param cleared true if the screen was cleared
+ */
+void SplashscreenScene::invalidate(bool cleared) {
+    SkirmishUIScene::invalidate(cleared);
+    qrDirty = true;
+}
 
 /**
  * Renders the scene
  */
 void SplashscreenScene::render() {
-    if (this->id == SCENE_NO_GAME) {
-        hitpointSelectAnimation(HP_ANIM_SOLID);
-        hitpointSetColor(this->ui->stbR, this->ui->stbG, this->ui->stbB);
-    }
+    SkirmishUIScene::render();
 #ifndef NO_DISPLAY
-    ui->display->setFont(SDT_HEADER_FONT);
-
-    uint8_t base_y = 170;
-    if (id == SCENE_BLE_CONNECT) base_y = 80;
-
-    ui->display->setTextColor((id == SCENE_BLE_RECONNECT) ? SDT_SECONDARY_COLOR
-                                                          : SDT_PRIMARY_COLOR);
-    ui->display->centerText("SKIRMISH", base_y, SDT_HEADER_FONT_SIZE);
-
-    ui->display->setFont(SDT_TEXT_FONT);
-    ui->display->setTextColor(SDT_TEXT_COLOR);
-    ui->display->centerText(splashText, base_y + 5, 1);
-
     // Render a qr code to the connect scene
-    if (id == SCENE_BLE_CONNECT) {
+    if (id == SCENE_BLE_CONNECT && qrDirty) {
+        qrDirty = false;
         uint8_t pos_x = 120 - (nameQR.size * 5) / 2;
-        for (uint8_t y = 0; y < nameQR.size; y++) {
-            for (uint8_t x = 0; x < nameQR.size; x++) {
-                if (qrcode_getModule(&nameQR, x, y)) {
-                    ui->display->tft.fillRect(
-                        pos_x + (x * 5), base_y + 55 + (y * 5), 5, 5,
-                        ui->display->gammaCorrection(SDT_TEXT_COLOR));
-                } else {
-                    ui->display->tft.fillRect(
-                        pos_x + (x * 5), base_y + 55 + (y * 5), 5, 5,
-                        ui->display->gammaCorrection(SDT_BG_COLOR));
-                }
-            }
-        }
+        uint8_t base_y = 80;
+        ui->display->drawImage(pos_x, base_y + 55, qrImage, nameQR.size,
+                               nameQR.size, 5, SDT_TEXT_COLOR, SDT_BG_COLOR);
     }
 #endif
 }
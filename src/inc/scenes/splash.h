@@ -14,17 +14,29 @@ Copyright (C) 2023 Ole Lange
 #include "qrcode.h"  // MOCK: ADD
 #include "scene.h"
 
+// Size of the device name QR code (version 3)
+#define SPLASH_QR_VERSION 3
+#define SPLASH_QR_MODULES 29
+#define SPLASH_QR_STRIDE ((SPLASH_QR_MODULES + 7) / 8)
+
 class SplashscreenScene : public SkirmishUIScene {
    private:
-    char* splashText;
+    LabelWidget* title;
+    LabelWidget* splashText;
 
     QRCode nameQR;
     uint8_t* qrBytes;
+    uint8_t* qrImage;  // Modules as 1-bit image, rows padded to full bytes
+    bool qrDirty = false;
+
+    // Standby color currently shown by the hitpoints
+    uint32_t standbyColor;
 
    public:
     SplashscreenScene(SkirmishUI* ui);
 
     void onSet(uint8_t id);
     bool update();
+    void invalidate(bool cleared);
     void render();
 };
@@ -9,11 +9,13 @@ Copyright (C) 2023 Ole Lange
 #include <ArduinoJson.h>
 #include <inc/bluetooth.h>
 #include <inc/const.h>
+#include <inc/diagnostics.h>
 #include <inc/hardware_control.h>
 #ifndef NO_HPNOW
 #include <inc/hpnow.h>
 #endif
 #include <inc/log.h>
+#include <inc/recorder.h>
 #include <inc/skirmcom.h>
 #include <inc/time.h>
 #include <inc/ui.h>
@@ -116,6 +118,14 @@ void SkirmCom::onReceive(DynamicJsonDocument *data) {
             }
         }
 
+        // Starts or stops the diagnostics, parameter "diag" and optionally
+        // "diag_l", the lowest level of the log messages that are sent
+        if (action == ACTION_DIAGNOSTICS) {
+            uint8_t level = root["diag_l"] | LOGLEVEL_INFO;
+            diagnosticsEnable(root["diag"] | false, level);
+            continue;
+        }
+
         if (action == ACTION_POWER_OFF) {
             logInfo("Good Bye!");
             hardwarePowerOff();
@@ -163,12 +173,17 @@ void SkirmCom::onReceive(DynamicJsonDocument *data) {
 /**
  * Member function that is called by the onConnectCallback function
  */
-void SkirmCom::onConnect() {}
+void SkirmCom::onConnect() { recorderRecord(RECORD_BLE_CONNECT, 0, 0); }
 
 /**
  * Member function that is called by the onDisconnectCallback function
  */
 void SkirmCom::onDisconnect() {
+    recorderRecord(RECORD_BLE_DISCONNECT, 0, 0);
+
+    // The next connection has to enable the diagnostics again
+    if (diagnosticsEnabled()) diagnosticsEnable(false, LOGLEVEL_OFF);
+
     // Resetting game on disconnect
     // game->reset();
 }
@@ -267,6 +282,28 @@ void SkirmCom::hwStatus(float battery) {
     bleDriver->writeJsonData(jsonOutDocument);
 }
 
+/**
+ * This method uploads the flight record of the previous boots to the app
+ *
+ * @param record the recorded events, base64 encoded (recorderReport())
+ */
+void SkirmCom::flightRecord(const char *record) {
+    // Clear current data
+    jsonOutDocument->clear();
+
+    // Generating Json Data
+    /*
+    { "a": [ACTION_FLIGHT_RECORD], "fr": record, "d_id": name }
+    */
+    JsonArray actions = jsonOutDocument->createNestedArray("a");
+    actions.add(ACTION_FLIGHT_RECORD);
+    jsonOutDocument->operator[]("fr") = record;
+    jsonOutDocument->operator[]("d_id") = this->bleDriver->getName();
+
+    // Sending data
+    bleDriver->writeJsonData(jsonOutDocument);
+}
+
 /**
  * This method triggers the HP_GOT_HIT action oon the server.
  *
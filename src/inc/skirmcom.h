@@ -39,6 +39,7 @@ public:
     void gotHit(uint8_t pid, uint16_t sid, uint8_t hitLocation);
 
     void hwStatus(float battery);
+    void flightRecord(const char *record);
 
     void hpGotHit(uint8_t hpmode, uint8_t pid, uint16_t sid);
 };
\ No newline at end of file
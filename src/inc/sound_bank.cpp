@@ -0,0 +1,114 @@
+/*
+Skirmish ESP32 Firmware
+
+Sound bank
+
+Keeps short, frequently played audio clips in RAM (or PSRAM if
+available) so playing them doesn't compete with code execution for
+the flash cache. Clips that are not resident are streamed from the
+memory mapped asset archive by the audio driver.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <Arduino.h>
+#include <conf.h>
+#include <inc/assets.h>
+#include <inc/log.h>
+#include <inc/sound_bank.h>
+
+// Clips that should be loaded at boot, ordered by priority. The blaster
+// sound is played on every shot and is loaded first, the countdown cues
+// follow as long as the memory budget allows it.
+const uint16_t hotClips[] = {ASSET_SOUND_BLASTER, ASSET_SOUND_THREE,
+                             ASSET_SOUND_TWO, ASSET_SOUND_ONE,
+                             ASSET_SOUND_FIGHT};
+
+struct SoundBankEntry {
+    uint16_t assetId;
+    uint8_t* data;
+    uint32_t length;
+};
+
+SoundBankEntry soundBankEntries[SOUND_BANK_MAX_ENTRIES];
+uint8_t soundBankEntryCount = 0;
+uint32_t soundBankUsedBytes = 0;
+
+/**
+ * Copies a clip from the asset archive into the sound bank.
+ *
+ * @param assetId asset ID of the clip
+ * @return true if the clip is resident afterwards
+ */
+bool soundBankLoad(uint16_t assetId) {
+    if (soundBankEntryCount >= SOUND_BANK_MAX_ENTRIES) {
+        logWarn("-> Sound bank full, not loading asset %d", assetId);
+        return false;
+    }
+
+    const uint8_t* asset;
+    uint32_t length;
+    if (!assetGet(assetId, &asset, &length)) {
+        logWarn("-> Sound bank: asset %d not found", assetId);
+        return false;
+    }
+
+    uint32_t budget =
+        psramFound() ? SOUND_BANK_PSRAM_BUDGET : SOUND_BANK_BUDGET;
+    if (soundBankUsedBytes + length > budget) {
+        logDebug("-> Sound bank: asset %d (%d bytes) exceeds budget, "
+                 "streaming it",
+                 assetId, length);
+        return false;
+    }
+
+    uint8_t* data =
+        (uint8_t*)(psramFound() ? ps_malloc(length) : malloc(length));
+    if (data == NULL) {
+        logWarn("-> Sound bank: out of memory loading asset %d", assetId);
+        return false;
+    }
+    memcpy(data, asset, length);
+
+    soundBankEntries[soundBankEntryCount] = {assetId, data, length};
+    soundBankEntryCount++;
+    soundBankUsedBytes += length;
+
+    logDebug("-> Sound bank: loaded asset %d (%d bytes)", assetId, length);
+    return true;
+}
+
+/**
+ * Looks up a resident clip.
+ *
+ * @param assetId asset ID of the clip
+ * @param [out] data pointer to the clip data
+ * @param [out] length length of the clip data in bytes
+ * @return true if the clip is resident, false if it has to be streamed
+ */
+bool soundBankLookup(uint16_t assetId, const uint8_t** data,
+                     uint32_t* length) {
+    for (uint8_t i = 0; i < soundBankEntryCount; i++) {
+        if (soundBankEntries[i].assetId == assetId) {
+            *data = soundBankEntries[i].data;
+            *length = soundBankEntries[i].length;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Loads all hot clips into the sound bank. The asset archive must
+ * be initialized.
+ */
+void soundBankInit() {
+    logInfo("Init: Sound bank");
+
+    for (uint8_t i = 0; i < sizeof(hotClips) / sizeof(hotClips[0]); i++) {
+        soundBankLoad(hotClips[i]);
+    }
+
+    logInfo("-> %d clips resident (%d bytes%s)", soundBankEntryCount,
+            soundBankUsedBytes, psramFound() ? ", PSRAM" : "");
+}
@@ -0,0 +1,16 @@
+/*
+Skirmish ESP32 Firmware
+
+Sound bank - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+void soundBankInit();
+bool soundBankLoad(uint16_t assetId);
+bool soundBankLookup(uint16_t assetId, const uint8_t** data,
+                     uint32_t* length);
@@ -0,0 +1,220 @@
+/*
+Skirmish ESP32 Firmware
+
+Standby
+
+Instead of cutting the supply the phaser goes to deep sleep when it wasn't
+connected for a while, the power button (PIN_PWR_OFF) wakes it up again.
+The panel, the hitpoint LEDs, the speaker amp, the IR
+LED and the vibration motor are turned off, their pins are held low. The
+time and the last game the player was in are kept in RTC memory and
+restored after the wakeup, the hitpoints keep their supply so the boot
+doesn't have to wait for them.
+
+The time from boot to advertising is logged for cold boots and wakeups,
+so both can be compared.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "standby.h"
+
+#include <driver/gpio.h>
+#include <driver/rtc_io.h>
+#include <esp_sleep.h>
+#include <sys/time.h>
+
+#include "../conf.h"
+#include "const.h"
+#include "hitpoint.h"
+#include "log.h"
+#include "time.h"
+
+#define STANDBY_MAGIC 0x534b5342  // "SKSB"
+
+/**
+ * State kept in RTC memory during deep sleep
+ */
+typedef struct {
+    uint32_t magic;
+
+    // Timestamp (getCurrentTS()) and RTC clock (s) when entering standby
+    uint32_t timestamp;
+    uint32_t clock;
+
+    // Time from boot to advertising of the last cold boot (ms)
+    uint32_t coldBootAdvertising;
+    uint32_t wakeups;
+
+    // Last game, remembered before it was reset (same sizes as in Game)
+    bool hasGame;
+    char gid[33];
+    uint8_t pid;
+    char playerName[33];
+    uint8_t color[3];
+    uint8_t tid;
+    char teamName[33];
+} StandbyState;
+
+RTC_DATA_ATTR static StandbyState state;
+
+/**
+ * @return seconds of the RTC clock, it keeps running in deep sleep
+ */
+static uint32_t rtcClock() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec;
+}
+
+/**
+ * @return true if the chip woke up from standby (RTC memory is valid)
+ */
+bool standbyWasWakeup() {
+    return esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED &&
+           state.magic == STANDBY_MAGIC;
+}
+
+/**
+ * Releases the pins held in standby and restores the time after a wakeup,
+ * clears the RTC state after a cold boot
+ */
+void standbyInit() {
+    if (!standbyWasWakeup()) {
+        memset(&state, 0, sizeof(state));
+        state.magic = STANDBY_MAGIC;
+        return;
+    }
+
+    state.wakeups++;
+    logInfo("Woke up from standby (%d)", esp_sleep_get_wakeup_cause());
+
+    gpio_deep_sleep_hold_dis();
+    rtc_gpio_deinit((gpio_num_t)PIN_PWR_OFF);
+    gpio_hold_dis((gpio_num_t)PIN_TFT_BLCTRL);
+#ifndef NO_AUDIO
+    gpio_hold_dis((gpio_num_t)PIN_SPK_EN);
+#endif
+#ifndef NO_PHASER
+    gpio_hold_dis((gpio_num_t)PIN_IR_LED);
+#endif
+#ifndef NO_VIBR_MOTOR
+    gpio_hold_dis((gpio_num_t)PIN_VIBR_MOTOR);
+#endif
+
+    if (state.timestamp != 0) {
+        setCurrentTS(state.timestamp + (rtcClock() - state.clock));
+    }
+}
+
+/**
+ * Remembers the game before it is reset, standby restores it
+ *
+ * @param game the game
+ */
+void standbyRememberGame(Game *game) {
+    if (game->gid[0] == 0) return;
+
+    state.hasGame = true;
+    strcpy(state.gid, game->gid);
+    state.pid = game->player.pid;
+    strcpy(state.playerName, game->player.name);
+    state.color[0] = game->player.color_r;
+    state.color[1] = game->player.color_g;
+    state.color[2] = game->player.color_b;
+    state.tid = game->team.tid;
+    strcpy(state.teamName, game->team.name);
+}
+
+/**
+ * Restores the last game after a wakeup. It is not started, the server
+ * sends the current data when the phaser connects again.
+ *
+ * @param game the game
+ */
+void standbyRestoreGame(Game *game) {
+    if (!standbyWasWakeup() || !state.hasGame) return;
+
+    strcpy(game->gid, state.gid);
+    game->player.pid = state.pid;
+    strcpy(game->player.name, state.playerName);
+    game->player.color_r = state.color[0];
+    game->player.color_g = state.color[1];
+    game->player.color_b = state.color[2];
+    game->team.tid = state.tid;
+    strcpy(game->team.name, state.teamName);
+
+    game->dataWasUpdated();
+    game->player.dataWasUpdated();
+    game->team.dataWasUpdated();
+    logInfo("Restored game %s from standby", game->gid);
+}
+
+/**
+ * Logs the time from boot to advertising, call when advertising started
+ */
+void standbyAdvertising() {
+    uint32_t elapsed = millis();
+    if (!standbyWasWakeup()) {
+        state.coldBootAdvertising = elapsed;
+        logInfo("Advertising %lu ms after cold boot", (unsigned long)elapsed);
+        return;
+    }
+
+    logInfo("Advertising %lu ms after wakeup (cold boot: %lu ms)",
+            (unsigned long)elapsed,
+            (unsigned long)state.coldBootAdvertising);
+}
+
+/**
+ * Turns off the outputs that would keep running in deep sleep and holds
+ * their pins low
+ */
+static void outputsOff() {
+    // The hitpoints keep their supply
+    hitpointSelectAnimation(HP_ANIM_SOLID);
+    hitpointSetColor(0, 0, 0);
+
+#ifndef NO_AUDIO
+    digitalWrite(PIN_SPK_EN, LOW);
+    gpio_hold_en((gpio_num_t)PIN_SPK_EN);
+#endif
+#ifndef NO_PHASER
+    pinMode(PIN_IR_LED, OUTPUT);
+    digitalWrite(PIN_IR_LED, LOW);
+    gpio_hold_en((gpio_num_t)PIN_IR_LED);
+#endif
+#ifndef NO_VIBR_MOTOR
+    // Driven by LEDC, taken back as a plain output
+    ledcDetachPin(PIN_VIBR_MOTOR);
+    pinMode(PIN_VIBR_MOTOR, OUTPUT);
+    digitalWrite(PIN_VIBR_MOTOR, LOW);
+    gpio_hold_en((gpio_num_t)PIN_VIBR_MOTOR);
+#endif
+    gpio_deep_sleep_hold_en();
+}
+
+/**
+ * Goes to deep sleep, the chip boots again when the power button is
+ * pressed. The display should be put to sleep before
+ * (SkirmishDisplay::sleep()).
+ */
+void standbyEnter() {
+    logWarn("Entering standby");
+
+    state.timestamp = getCurrentTS();
+    state.clock = rtcClock();
+
+    outputsOff();
+
+    // The power button pulls its pin high
+    rtc_gpio_pullup_dis((gpio_num_t)PIN_PWR_OFF);
+    rtc_gpio_pulldown_en((gpio_num_t)PIN_PWR_OFF);
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)PIN_PWR_OFF, 1);
+
+    // Pulls of the wakeup pin need the RTC peripherals
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+
+    Serial.flush();
+    esp_deep_sleep_start();
+}
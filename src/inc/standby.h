@@ -0,0 +1,21 @@
+/*
+Skirmish ESP32 Firmware
+
+Standby - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <inc/game.h>
+
+bool standbyWasWakeup();
+void standbyInit();
+
+void standbyRememberGame(Game *game);
+void standbyRestoreGame(Game *game);
+void standbyAdvertising();
+
+void standbyEnter();
@@ -0,0 +1,159 @@
+/*
+Skirmish ESP32 Firmware
+
+Strip renderer
+
+Renders full screen frames in strips of DISPLAY_STRIP_HEIGHT rows. The
+strips are rasterized and pushed by the display render task on core 0 (see
+display.cpp), core 1 is left to the game. The Arduino SPI driver has no
+asynchronous transfers, it keeps the core busy while a strip is sent, so
+one strip buffer is enough.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "strip_renderer.h"
+
+#include "../conf.h"
+#include "display.h"
+#include "log.h"
+
+/**
+ * Canvas constructor
+ *
+ * @param w width of the screen
+ * @param h height of the screen
+ */
+StripCanvas::StripCanvas(int16_t w, int16_t h) : Adafruit_GFX(w, h) {}
+
+/**
+ * Selects the strip the following drawing operations go to
+ *
+ * @param buffer RGB565 buffer of width * rows pixels
+ * @param top first row of the strip
+ * @param rows amount of rows
+ */
+void StripCanvas::setStrip(uint16_t *buffer, int16_t top, int16_t rows) {
+    this->buffer = buffer;
+    this->top = top;
+    this->rows = rows;
+}
+
+void StripCanvas::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x < 0 || x >= _width || y < top || y >= top + rows) return;
+    buffer[(y - top) * _width + x] = color;
+}
+
+void StripCanvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                           uint16_t color) {
+    if (w < 0) {
+        x += w + 1;
+        w = -w;
+    }
+    if (h < 0) {
+        y += h + 1;
+        h = -h;
+    }
+
+    // Clipping to the strip
+    int16_t x1 = min((int16_t)(x + w), _width);
+    int16_t y1 = min((int16_t)(y + h), (int16_t)(top + rows));
+    x = max(x, (int16_t)0);
+    y = max(y, top);
+    if (x1 <= x || y1 <= y) return;
+
+    for (int16_t row = y; row < y1; row++) {
+        uint16_t *pixel = &buffer[(row - top) * _width + x];
+        for (int16_t i = x; i < x1; i++) *pixel++ = color;
+    }
+}
+
+void StripCanvas::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                                uint16_t color) {
+    fillRect(x, y, w, h, color);
+}
+
+void StripCanvas::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                uint16_t color) {
+    fillRect(x, y, w, 1, color);
+}
+
+void StripCanvas::writeFastHLine(int16_t x, int16_t y, int16_t w,
+                                 uint16_t color) {
+    fillRect(x, y, w, 1, color);
+}
+
+void StripCanvas::drawFastVLine(int16_t x, int16_t y, int16_t h,
+                                uint16_t color) {
+    fillRect(x, y, 1, h, color);
+}
+
+void StripCanvas::writeFastVLine(int16_t x, int16_t y, int16_t h,
+                                 uint16_t color) {
+    fillRect(x, y, 1, h, color);
+}
+
+/**
+ * Strip renderer constructor
+ *
+ * @param tft the panel the strips are pushed to
+ */
+StripRenderer::StripRenderer(SkirmishTFT *tft) { this->tft = tft; }
+
+/**
+ * Allocates the strip buffer. Has to be called after the panel was
+ * initialized.
+ *
+ * @return false if there is not enough memory, frames are drawn directly
+ * then
+ */
+bool StripRenderer::init() {
+    size_t stripSize = tft->width() * DISPLAY_STRIP_HEIGHT * sizeof(uint16_t);
+    buffer = (uint16_t *)heap_caps_malloc(stripSize, MALLOC_CAP_DMA);
+    if (buffer == NULL) {
+        logWarn("Display: Not enough memory for strips, drawing directly");
+        return false;
+    }
+
+    canvas = new StripCanvas(tft->width(), tft->height());
+    return true;
+}
+
+/**
+ * @return true if init() was successful
+ */
+bool StripRenderer::isReady() { return canvas != NULL; }
+
+/**
+ * Renders a display list strip by strip, every strip is pushed before the
+ * next one is rasterized. Strips are not cleared, the list has to cover the
+ * whole screen.
+ *
+ * @param list the recorded frame
+ */
+void StripRenderer::render(DisplayList *list) {
+    int16_t height = tft->height();
+
+    for (int16_t top = 0; top < height; top += DISPLAY_STRIP_HEIGHT) {
+        int16_t rows = min(DISPLAY_STRIP_HEIGHT, height - top);
+
+        canvas->setStrip(buffer, top, rows);
+        list->replay(canvas, top, top + rows - 1);
+        push(top, rows);
+    }
+}
+
+/**
+ * Sends the rasterized strip to the panel with a single address window
+ *
+ * @param top first row of the strip
+ * @param rows amount of rows
+ */
+void StripRenderer::push(int16_t top, int16_t rows) {
+    uint32_t pixels = tft->width() * rows;
+    tft->startWrite();
+    tft->setAddrWindow(0, top, tft->width(), rows);
+    tft->writePixels(buffer, pixels);
+    tft->endWrite();
+    tft->spiBytes += pixels * 2;
+}
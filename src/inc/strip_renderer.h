@@ -0,0 +1,63 @@
+/*
+Skirmish ESP32 Firmware
+
+Strip renderer - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "Adafruit_GFX.h"
+#include "display_list.h"
+
+class SkirmishTFT;
+
+/**
+ * Adafruit_GFX target drawing into a horizontal strip of the screen held
+ * in RAM. The canvas has the size of the whole screen, pixels outside of
+ * the current strip are dropped.
+ */
+class StripCanvas : public Adafruit_GFX {
+   private:
+    uint16_t *buffer = NULL;
+    int16_t top = 0;
+    int16_t rows = 0;
+
+   public:
+    StripCanvas(int16_t w, int16_t h);
+
+    void setStrip(uint16_t *buffer, int16_t top, int16_t rows);
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                       uint16_t color);
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+};
+
+/**
+ * Renders display lists strip by strip. A strip is rasterized into RAM and
+ * sent to the panel with a single address window instead of one per
+ * drawing operation.
+ */
+class StripRenderer {
+   private:
+    SkirmishTFT *tft;
+    StripCanvas *canvas = NULL;
+    uint16_t *buffer = NULL;
+
+    void push(int16_t top, int16_t rows);
+
+   public:
+    StripRenderer(SkirmishTFT *tft);
+
+    bool init();
+    bool isReady();
+    void render(DisplayList *list);
+};
@@ -0,0 +1,217 @@
+/*
+Skirmish ESP32 Firmware
+
+Text cache
+
+Measuring a text with a GFX font walks all of its glyphs, drawing it walks
+them again pixel by pixel. Most texts of the UI (title, device name, game
+and team names) stay the same for many frames, so their bounds and a 1-bpp
+image are kept here and only recalculated if the text or font changes.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "text_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Selects the image the following drawing operations go to, the image
+ * is cleared
+ *
+ * @param image buffer of (w + 7) / 8 * h bytes
+ * @param w width in pixels
+ * @param h height in pixels
+ */
+void TextRaster::setImage(uint8_t *image, int16_t w, int16_t h) {
+    this->image = image;
+    imageW = w;
+    imageH = h;
+    memset(image, 0, (w + 7) / 8 * h);
+}
+
+void TextRaster::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x < 0 || x >= imageW || y < 0 || y >= imageH) return;
+    image[y * ((imageW + 7) / 8) + (x >> 3)] |= 0x80 >> (x & 7);
+}
+
+/**
+ * Text cache constructor
+ */
+TextCache::TextCache() {
+    memset(entries, 0, sizeof(entries));
+    memset(&scratch, 0, sizeof(scratch));
+}
+
+/**
+ * FNV-1a hash of a text
+ *
+ * @param text the text
+ * @return 32 bit hash
+ */
+uint32_t TextCache::hash(const char *text) {
+    uint32_t value = 2166136261UL;
+    while (*text) {
+        value ^= (uint8_t)*text++;
+        value *= 16777619UL;
+    }
+    return value;
+}
+
+/**
+ * Returns the cached measurement of a text, measures it on a miss. The
+ * bounds are relative to a cursor at 0, 0 (y is the baseline for GFX
+ * fonts, the upper edge otherwise).
+ *
+ * The returned entry is only valid until the next call.
+ *
+ * @param text the text
+ * @param font font or NULL for the built-in font
+ * @param fontSize size multiplier of the font
+ * @return the entry, its image is NULL if the text isn't rasterized (yet)
+ */
+const TextCacheEntry *TextCache::get(const char *text, const GFXfont *font,
+                                     uint8_t fontSize) {
+    uint32_t textHash = hash(text);
+
+    TextCacheEntry *entry = find(text, textHash, font, fontSize);
+    if (entry != NULL) {
+        hits++;
+        entry->lastUsed = generation;
+        if (entry->image == NULL && entry->created != generation) {
+            rasterize(entry);
+        }
+        return entry;
+    }
+    misses++;
+
+    // Long texts and texts that don't fit into the cache any more are
+    // only measured
+    entry = NULL;
+    if (strlen(text) <= DISPLAY_TEXT_CACHE_LENGTH) entry = replace();
+    if (entry == NULL) {
+        entry = &scratch;
+    } else {
+        strcpy(entry->text, text);
+    }
+
+    entry->font = font;
+    entry->fontSize = fontSize;
+    entry->hash = textHash;
+    entry->created = generation;
+    entry->lastUsed = generation;
+
+    // Measuring without wrapping first, texts that only fit into the
+    // screen wrapped are measured the way the panel driver prints them
+    metrics.setFont(font);
+    metrics.setTextSize(fontSize);
+    metrics.setTextWrap(false);
+    metrics.getTextBounds(text, 0, 0, &entry->x1, &entry->y1, &entry->w,
+                          &entry->h);
+    if (entry->x1 + entry->w > metrics.width()) {
+        metrics.setTextWrap(true);
+        metrics.getTextBounds(text, 0, 0, &entry->x1, &entry->y1, &entry->w,
+                              &entry->h);
+    }
+
+    return entry;
+}
+
+/**
+ * Measures a text at the given cursor position, like getTextBounds() of
+ * Adafruit_GFX
+ *
+ * @param text the text
+ * @param x cursor x position
+ * @param y cursor y position (baseline for GFX fonts, upper edge otherwise)
+ * @param font font or NULL for the built-in font
+ * @param fontSize size multiplier of the font
+ * @param x1, y1, w, h output of the bounds
+ */
+void TextCache::measure(const char *text, int16_t x, int16_t y,
+                        const GFXfont *font, uint8_t fontSize, int16_t *x1,
+                        int16_t *y1, uint16_t *w, uint16_t *h) {
+    const TextCacheEntry *entry = get(text, font, fontSize);
+
+    // The cached bounds only apply as long as the text isn't wrapped
+    if (x + entry->x1 + entry->w > metrics.width()) {
+        metrics.setFont(font);
+        metrics.setTextSize(fontSize);
+        metrics.setTextWrap(true);
+        metrics.getTextBounds(text, x, y, x1, y1, w, h);
+        return;
+    }
+
+    *x1 = x + entry->x1;
+    *y1 = y + entry->y1;
+    *w = entry->w;
+    *h = entry->h;
+}
+
+/**
+ * Starts a new generation, called whenever the display lists are swapped.
+ * Images used in the current or the previous generation may still be
+ * referenced by one of the lists.
+ */
+void TextCache::advance() { generation++; }
+
+TextCacheEntry *TextCache::find(const char *text, uint32_t hash,
+                                const GFXfont *font, uint8_t fontSize) {
+    for (uint8_t i = 0; i < DISPLAY_TEXT_CACHE_ENTRIES; i++) {
+        TextCacheEntry *entry = &entries[i];
+        if (entry->created != 0 && entry->hash == hash &&
+            entry->font == font && entry->fontSize == fontSize &&
+            strcmp(entry->text, text) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Frees the least recently used entry that isn't referenced any more
+ *
+ * @return the entry or NULL if all entries are in use
+ */
+TextCacheEntry *TextCache::replace() {
+    TextCacheEntry *oldest = NULL;
+    for (uint8_t i = 0; i < DISPLAY_TEXT_CACHE_ENTRIES; i++) {
+        TextCacheEntry *entry = &entries[i];
+        if (entry->created == 0) return entry;
+        if (entry->lastUsed + 2 > generation) continue;
+        if (oldest == NULL || entry->lastUsed < oldest->lastUsed) {
+            oldest = entry;
+        }
+    }
+
+    if (oldest != NULL && oldest->image != NULL) {
+        free(oldest->image);
+        oldest->image = NULL;
+    }
+    return oldest;
+}
+
+/**
+ * Rasterizes the text of an entry, texts that are wrapped or too large
+ * aren't rasterized
+ *
+ * @param entry the entry
+ */
+void TextCache::rasterize(TextCacheEntry *entry) {
+    if (entry->w == 0 || entry->x1 + entry->w > metrics.width()) return;
+
+    uint32_t size = (entry->w + 7) / 8 * entry->h;
+    if (size > DISPLAY_TEXT_CACHE_IMAGE) return;
+
+    entry->image = (uint8_t *)malloc(size);
+    if (entry->image == NULL) return;
+
+    raster.setImage(entry->image, entry->w, entry->h);
+    raster.setFont(entry->font);
+    raster.setTextSize(entry->fontSize);
+    raster.setTextWrap(false);
+    raster.setTextColor(1);
+    raster.setCursor(-entry->x1, -entry->y1);
+    raster.print(entry->text);
+}
@@ -0,0 +1,102 @@
+/*
+Skirmish ESP32 Firmware
+
+Text cache - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "../conf.h"
+#include "Adafruit_GFX.h"
+
+/**
+ * Adafruit_GFX object that draws nothing, used to measure texts without
+ * touching the state of the panel driver, which is owned by the render
+ * task
+ */
+class TextMetrics : public Adafruit_GFX {
+   public:
+    TextMetrics(int16_t w, int16_t h) : Adafruit_GFX(w, h) {}
+    void drawPixel(int16_t x, int16_t y, uint16_t color) {}
+};
+
+/**
+ * Adafruit_GFX object that rasterizes a text into a 1-bpp image in the
+ * format of drawBitmap() (rows padded to full bytes, MSB first)
+ */
+class TextRaster : public Adafruit_GFX {
+   private:
+    uint8_t *image = NULL;
+    int16_t imageW = 0;
+    int16_t imageH = 0;
+
+   public:
+    TextRaster(int16_t w, int16_t h) : Adafruit_GFX(w, h) {}
+
+    void setImage(uint8_t *image, int16_t w, int16_t h);
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+};
+
+/**
+ * A measured text. The bounds are relative to a cursor at 0, 0, image is
+ * the pre-rasterized text or NULL.
+ */
+typedef struct {
+    const GFXfont *font;
+    uint8_t fontSize;
+    uint32_t hash;
+    char text[DISPLAY_TEXT_CACHE_LENGTH + 1];
+
+    int16_t x1, y1;
+    uint16_t w, h;
+    uint8_t *image;
+
+    // Generations (see TextCache::advance()), 0 = unused entry
+    uint32_t created;
+    uint32_t lastUsed;
+} TextCacheEntry;
+
+/**
+ * Cache of text bounds and 1-bpp text images keyed by font, size and text.
+ * Texts that are still drawn after the frame they were measured in are
+ * rasterized once and blitted as a bitmap afterwards, texts that change
+ * every frame (e.g. counters) are only measured.
+ *
+ * Images are referenced by recorded display lists, so an entry is only
+ * replaced once both lists were swapped after its last use (see
+ * advance()).
+ */
+class TextCache {
+   private:
+    TextCacheEntry entries[DISPLAY_TEXT_CACHE_ENTRIES];
+    TextCacheEntry scratch;
+    uint32_t generation = 2;
+
+    TextMetrics metrics = TextMetrics(240, 320);
+    TextRaster raster = TextRaster(240, 320);
+
+    TextCacheEntry *find(const char *text, uint32_t hash,
+                         const GFXfont *font, uint8_t fontSize);
+    TextCacheEntry *replace();
+    void rasterize(TextCacheEntry *entry);
+
+   public:
+    TextCache();
+
+    // Statistics, for DISPLAY_BENCHMARK
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+
+    const TextCacheEntry *get(const char *text, const GFXfont *font,
+                              uint8_t fontSize);
+    void measure(const char *text, int16_t x, int16_t y, const GFXfont *font,
+                 uint8_t fontSize, int16_t *x1, int16_t *y1, uint16_t *w,
+                 uint16_t *h);
+    void advance();
+
+    static uint32_t hash(const char *text);
+};
@@ -0,0 +1,235 @@
+/*
+Skirmish ESP32 Firmware
+
+Trigger
+
+Debounces the trigger button with a hardware timer: the first edge of a
+bounce starts the timer, the level is read TRIGGER_DEBOUNCE_TIME
+milliseconds later. Settled presses and releases are passed to the main
+loop with the time of their first edge, which schedules the shots of the
+fire mode from them. Shots are scheduled from the previous shot, not from
+the loop pass that noticed them, so the fire rate doesn't depend on how
+long a pass takes.
+
+The debounce timer stops in light sleep, so the device stays awake while
+it runs (POWER_LOCK_TRIGGER). Light sleep is only used while no game is
+running and presses are dropped anyway; edges missed while sleeping are
+picked up by triggerCancel(), which debounces a level that differs from
+the settled one like a new edge.
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "trigger.h"
+
+#include "../conf.h"
+#include "log.h"
+#include "power.h"
+
+// Settled edges, written by the timer ISR and read by triggerShotDue()
+#define TRIGGER_EDGES 8
+static volatile bool edgePressed[TRIGGER_EDGES];
+static volatile uint32_t edgeTime[TRIGGER_EDGES];
+static volatile uint8_t edgeHead = 0;
+static volatile uint8_t edgeTail = 0;
+
+static hw_timer_t *debounceTimer = NULL;
+static volatile bool debouncing = false;
+static volatile uint32_t firstEdge = 0;
+static volatile bool settledPressed = false;
+static portMUX_TYPE debounceLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Fire mode, set by triggerConfigure()
+static uint8_t fireMode = FIRE_MODE_SEMI;
+static uint8_t burstLength = 1;
+static uint16_t shotInterval = 0;
+
+// Trigger state as seen by the main loop
+static bool pressed = false;
+static uint32_t pressedAt = 0;
+static uint32_t releasedAt = 0;
+
+// Shots left to fire in FIRE_MODE_SEMI and FIRE_MODE_BURST, autoFire
+// fires until the trigger is released
+static uint8_t shotsLeft = 0;
+static bool autoFire = false;
+static uint32_t nextShot = 0;
+
+/**
+ * Starts the debounce timer, the device stays out of light sleep until it
+ * fired
+ */
+static void IRAM_ATTR startDebounce() {
+    debouncing = true;
+    firstEdge = millis();
+    powerAcquire(POWER_LOCK_TRIGGER);
+    timerWrite(debounceTimer, 0);
+    timerAlarmEnable(debounceTimer);
+}
+
+/**
+ * Interrupt subroutine called on both edges of the trigger pin, starts the
+ * debounce timer on the first edge of a bounce
+ */
+static void IRAM_ATTR edgeISR() {
+    if (debouncing) return;
+    startDebounce();
+}
+
+/**
+ * Interrupt subroutine of the debounce timer, reads the settled level
+ */
+static void IRAM_ATTR debounceISR() {
+    // Edges from now on start a new debounce
+    debouncing = false;
+    powerRelease(POWER_LOCK_TRIGGER);
+
+    bool level = digitalRead(PIN_TRIGGER) == LOW;
+    if (level == settledPressed) return;
+    settledPressed = level;
+
+    // Edges are dropped if the main loop didn't read them for a while
+    uint8_t next = (edgeHead + 1) % TRIGGER_EDGES;
+    if (next == edgeTail) return;
+    edgePressed[edgeHead] = level;
+    edgeTime[edgeHead] = firstEdge;
+    edgeHead = next;
+}
+
+/**
+ * Applies the edges the timer ISR settled since the last call
+ */
+static void readEdges() {
+    while (edgeTail != edgeHead) {
+        bool edge = edgePressed[edgeTail];
+        uint32_t time = edgeTime[edgeTail];
+        edgeTail = (edgeTail + 1) % TRIGGER_EDGES;
+
+        if (!edge) {
+            pressed = false;
+            releasedAt = time;
+            autoFire = false;
+            continue;
+        }
+
+        pressed = true;
+        pressedAt = time;
+
+        // A burst is finished before the next one starts
+        if (fireMode == FIRE_MODE_BURST && shotsLeft > 0) continue;
+
+        switch (fireMode) {
+            case FIRE_MODE_BURST:
+                shotsLeft = max(burstLength, (uint8_t)1);
+                break;
+            case FIRE_MODE_AUTO:
+                shotsLeft = 0;
+                autoFire = true;
+                break;
+            default:
+                shotsLeft = 1;
+        }
+
+        // The first shot is fired at the press, unless the last shot was
+        // less than an interval before it
+        if ((int32_t)(time - nextShot) > 0) nextShot = time;
+    }
+}
+
+/**
+ * Sets the fire mode, it is applied from the next press on
+ *
+ * @param mode FIRE_MODE_*
+ * @param length shots per press in FIRE_MODE_BURST
+ * @param interval minimum time between two shots (ms), at least
+ *                 TRIGGER_MIN_REPEAT_INTERVAL between the shots of a burst
+ *                 or auto fire
+ */
+void triggerConfigure(uint8_t mode, uint8_t length, uint16_t interval) {
+    fireMode = mode;
+    burstLength = length;
+    shotInterval = interval;
+}
+
+/**
+ * Checks if a shot should be fired, call once per loop pass
+ *
+ * @param now current time (millis())
+ * @return true if a shot is due, it is counted as fired
+ */
+bool triggerShotDue(uint32_t now) {
+    readEdges();
+    if ((shotsLeft == 0 && !autoFire) || (int32_t)(now - nextShot) < 0)
+        return false;
+
+    if (!autoFire) shotsLeft--;
+
+    // Repeated shots don't fire on every loop pass if no interval is set
+    uint16_t interval = shotInterval;
+    if (fireMode != FIRE_MODE_SEMI && interval < TRIGGER_MIN_REPEAT_INTERVAL)
+        interval = TRIGGER_MIN_REPEAT_INTERVAL;
+
+    // Shots missed by more than an interval are dropped instead of being
+    // fired back to back
+    if (now - nextShot >= interval) {
+        nextShot = now + interval;
+    } else {
+        nextShot += interval;
+    }
+    return true;
+}
+
+/**
+ * Drops the shots that are scheduled, e.g. when the player can't fire.
+ * Holding the trigger in FIRE_MODE_AUTO doesn't fire again until the
+ * next press. Also picks up edges missed in light sleep.
+ */
+void triggerCancel() {
+    // An edge missed in light sleep is debounced now (the ISRs run on
+    // this core, the critical section keeps them out)
+    portENTER_CRITICAL(&debounceLock);
+    if (!debouncing && (digitalRead(PIN_TRIGGER) == LOW) != settledPressed) {
+        startDebounce();
+    }
+    portEXIT_CRITICAL(&debounceLock);
+
+    readEdges();
+    shotsLeft = 0;
+    autoFire = false;
+}
+
+/**
+ * @return true if the trigger is held down
+ */
+bool triggerIsPressed() { return pressed; }
+
+/**
+ * @return time of the last press (millis())
+ */
+uint32_t triggerPressedAt() { return pressedAt; }
+
+/**
+ * @return time of the last release (millis())
+ */
+uint32_t triggerReleasedAt() { return releasedAt; }
+
+/**
+ * Initializes the trigger button and its debounce timer
+ *
+ * Pins required in this module are:
+ * - PIN_TRIGGER: Pin connected to the trigger button (active low)
+ */
+void triggerInit() {
+    logInfo("Init: Trigger");
+
+    pinMode(PIN_TRIGGER, INPUT_PULLUP);
+    settledPressed = digitalRead(PIN_TRIGGER) == LOW;
+    pressed = settledPressed;
+
+    // Counting microseconds, the alarm fires once per start
+    debounceTimer = timerBegin(TRIGGER_TIMER, 80, true);
+    timerAttachInterrupt(debounceTimer, debounceISR, true);
+    timerAlarmWrite(debounceTimer, TRIGGER_DEBOUNCE_TIME * 1000, false);
+
+    attachInterrupt(PIN_TRIGGER, edgeISR, CHANGE);
+}
@@ -0,0 +1,26 @@
+/*
+Skirmish ESP32 Firmware
+
+Trigger - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+// Fire modes (Player::fireMode)
+#define FIRE_MODE_SEMI 0   // One shot per press
+#define FIRE_MODE_BURST 1  // Player::burstLength shots per press
+#define FIRE_MODE_AUTO 2   // Shots as long as the trigger is held
+
+void triggerInit();
+void triggerConfigure(uint8_t mode, uint8_t length, uint16_t interval);
+
+bool triggerShotDue(uint32_t now);
+void triggerCancel();
+
+bool triggerIsPressed();
+uint32_t triggerPressedAt();
+uint32_t triggerReleasedAt();
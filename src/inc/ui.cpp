@@ -11,11 +11,13 @@ Copyright (C) 2023 Ole Lange
 #include <stdlib.h>  // included for mocking, maybe required to remove
 #include <string.h>  // included for mocking, maybe required to remove
 
-#include "../fonts/skvec.h"
+#include "../fonts/skvec_runs.h"
 #include "../theme.h"
+#include "battery.h"
 #include "hardware_control.h"
 #include "hitpoint.h"
 #include "log.h"
+#include "recorder.h"
 // #include "mocks.h"  // MOCK: REMOVE
 #include "scenes/countdown.h"
 #include "scenes/game.h"
@@ -80,11 +82,26 @@ void SkirmishUI::setScene(uint8_t scene) {
 
     currentScene->onSet(scene);
 
+#ifndef NO_DISPLAY
+    // The old scene is wiped away before the new one is drawn
+    if (transitionRow < 0) transitionRow = 0;
+    transition.begin(transitionRow, 320, UI_TRANSITION_TIME, millis(),
+                     EASE_IN_OUT);
+    startAnimation();
+#endif
+
     setRenderingRequired();
     clearRequired = true;
+    recorderRecord(RECORD_SCENE, scene, 0);
     logDebug("Changed to scene %d", scene);
 }
 
+/**
+ * Starts drawing animation frames, until neither the scene nor the scene
+ * transition have a running animation
+ */
+void SkirmishUI::startAnimation() { animating = true; }
+
 /**
  * Starts showing a msgbox
  *
@@ -155,18 +172,91 @@ void SkirmishUI::update() {
 }
 
 /**
- * Renders the user interface
+ * Renders the user interface. Widgets, the border and the status overlay
+ * are only redrawn if they changed, unless the screen was cleared. Drawing
+ * only records commands, the display replays them on its render task.
  */
 void SkirmishUI::render() {
+#ifndef NO_DISPLAY
+    // Handing over commands the render task was too busy for last time
+    display->flush();
+
+    // Animation frames are dropped while the display is busy
+    bool animationFrame = false;
+    if (animating) {
+        uint32_t now = millis();
+        animationFrame = animator.beginFrame(now, display->isBusy());
+        if (animationFrame && transitionRow >= 0) {
+            // Scene animations continue with the next frame once the
+            // transition is done
+            if (renderTransition(now)) {
+                animator.endFrame();
+                return;
+            }
+        } else if (animationFrame) {
+            animating = currentScene->animate(now);
+            renderRequired = true;
+        }
+    }
+
+    // The new scene is drawn once the transition is done
+    if (transitionRow >= 0) return;
+#endif
+
     if (!renderRequired) return;
 
     renderRequired = false;
 
-    if (clearRequired) {
-        clearRequired = false;
+    bool cleared = clearRequired;
+    clearRequired = false;
+
+#if !defined(NO_DISPLAY) && defined(DISPLAY_BENCHMARK)
+    if (cleared) {
+        // Rendering the same full frame through both paths
+        display->waitIdle();
+        uint32_t start = micros();
+        renderFrame(true, false);
+        uint32_t recordTime = micros() - start;
+        display->waitIdle();
+        uint32_t directTime = display->frameTime;
+        uint32_t directBytes = display->frameSpiBytes;
+
+        renderFrame(true, true);
+        display->waitIdle();
+
+        logInfo("Display benchmark: recording %lu us, direct %lu us / %lu "
+                "bytes, strips %lu us / %lu bytes",
+                (unsigned long)recordTime, (unsigned long)directTime,
+                (unsigned long)directBytes,
+                (unsigned long)display->frameTime,
+                (unsigned long)display->frameSpiBytes);
+        logInfo("Display benchmark: text cache %lu hits, %lu misses",
+                (unsigned long)display->textCache.hits,
+                (unsigned long)display->textCache.misses);
+        return;
+    }
+#endif
+
+    renderFrame(cleared, true);
+
+#ifndef NO_DISPLAY
+    if (animationFrame) animator.endFrame();
+#endif
+}
+
+/**
+ * Records a frame
+ *
+ * @param cleared true if the screen has to be cleared and drawn completely
+ * @param useStrips render full frames in strips instead of directly
+ */
+void SkirmishUI::renderFrame(bool cleared, bool useStrips) {
+    if (cleared) {
 #ifndef NO_DISPLAY
+        display->beginFrame(true, useStrips);
         display->clear();
 #endif
+        currentScene->invalidate(true);
     }
 
     currentScene->render();
@@ -174,95 +264,136 @@ void SkirmishUI::render() {
 #ifndef NO_DISPLAY
     // Draw border (type game on game scene, secondary color on ble_reconnect
     // scene)
+    uint8_t borderType = BORDER_TYPE_DEFAULT;
+    uint16_t borderColor = SDT_PRIMARY_COLOR;
     if (currentScene->getID() == SCENE_GAME) {
-        border(BORDER_TYPE_GAME,
-               display->color(game->player.color_r, game->player.color_g,
-                              game->player.color_b));
-    } else {
-        border(BORDER_TYPE_DEFAULT,
-               (currentScene->getID() == SCENE_BLE_RECONNECT)
-                   ? SDT_SECONDARY_COLOR
-                   : SDT_PRIMARY_COLOR);
+        borderType = BORDER_TYPE_GAME;
+        borderColor = display->color(game->player.color_r,
+                                     game->player.color_g,
+                                     game->player.color_b);
+    } else if (currentScene->getID() == SCENE_BLE_RECONNECT) {
+        borderColor = SDT_SECONDARY_COLOR;
     }
-    renderStatusOverlay();
-#endif
 
-#ifndef NO_DISPLAY
+    bool borderChanged = cleared || borderType != drawnBorderType ||
+                         borderColor != drawnBorderColor;
+    if (borderChanged) {
+        border(borderType, borderColor);
+        drawnBorderType = borderType;
+        drawnBorderColor = borderColor;
+    }
+    renderStatusOverlay(borderChanged);
+
     if (msgBoxVisible) {
         renderMsgBox();
     }
+
+    display->endFrame();
 #endif
 }
 
 #ifndef NO_DISPLAY
+/**
+ * Draws a frame of the scene transition, only the rows the wipe moved
+ * over since the last frame are drawn
+ *
+ * @param now time of the frame (millis())
+ * @return true if the transition is still running
+ */
+bool SkirmishUI::renderTransition(uint32_t now) {
+    if (!transition.isRunning(now)) {
+        transitionRow = -1;
+        return false;
+    }
+
+    int16_t row = transition.value(now);
+    if (row > transitionRow) {
+        display->fillRect(0, transitionRow, 240, row - transitionRow,
+                          SDT_BG_COLOR);
+    }
+    display->fillRect(0, row, 240, 3, SDT_PRIMARY_COLOR);
+    display->endFrame();
+
+    transitionRow = row;
+    return true;
+}
+
 /**
  * Renders the status overlay (top edge)
+ *
+ * @param force true if the border was redrawn and the whole overlay
+ * has to be drawn again
  */
-void SkirmishUI::renderStatusOverlay() {
+void SkirmishUI::renderStatusOverlay(bool force) {
     // Draw the battery status
-    float batteryPercent = hardwareBatteryPercent();
-    uint8_t batRectWidth = batteryPercent * 18;
-
-    // Unfilled battery symbol
-    display->drawVec(skvec_battery, 210, 3, SDT_BG_COLOR);
+    float batteryCharge = batteryPercent();
+    uint8_t batRectWidth = batteryCharge * 18;
 
     // Fill depending on charge level
     uint16_t batteryColor;
-    if (batteryPercent > 0.7)
+    if (batteryCharge > 0.7)
         batteryColor = SDT_BATTERY_HIGH_COLOR;
-    else if (batteryPercent > 0.3)
+    else if (batteryCharge > 0.3)
         batteryColor = SDT_BATTERY_MID_COLOR;
     else
         batteryColor = SDT_BATTERY_LOW_COLOR;
-    display->tft.fillRect(211, 4, 18, 8,
-                          display->gammaCorrection(SDT_BG_COLOR));
-    display->tft.fillRect(211, 4, batRectWidth, 8,
-                          display->gammaCorrection(batteryColor));
+
+    if (force || batRectWidth != drawnBatteryWidth ||
+        batteryColor != drawnBatteryColor) {
+        // Unfilled battery symbol
+        display->drawRuns(&skvecRuns_battery, 210, 3, SDT_BG_COLOR);
+
+        display->fillRect(211, 4, 18, 8, SDT_BG_COLOR);
+        display->fillRect(211, 4, batRectWidth, 8, batteryColor);
+        drawnBatteryWidth = batRectWidth;
+        drawnBatteryColor = batteryColor;
+    }
 
     // Draw the device name
-    display->setFont(SDT_TEXT_FONT);
-    display->setTextColor(SDT_BG_COLOR);
-    display->centerText(bluetooth->getName(), 5, 1);
+    if (force) {
+        display->centerText(bluetooth->getName(), 5, SDT_TEXT_FONT, 1,
+                            SDT_BG_COLOR);
+    }
 
-    // Drawing the bluetooth symbol (if connected)
-    if (bluetooth->getConnectionState()) {
-        display->drawVec(skvec_bluetooth, 7, 1, SDT_BG_COLOR);
+    // Drawing the bluetooth symbol (if connected), the header is
+    // filled with the border color if it has to disappear
+    bool bluetoothState = bluetooth->getConnectionState();
+    if (force || bluetoothState != drawnBluetoothState) {
+        if (bluetoothState) {
+            display->drawRuns(&skvecRuns_bluetooth, 7, 1, SDT_BG_COLOR);
+        } else if (!force) {
+            display->fillRect(7, 1, 7, 13, drawnBorderColor);
+        }
+        drawnBluetoothState = bluetoothState;
     }
 }
 
 void SkirmishUI::renderMsgBox() {
-    display->tft.fillRect(30, 100, 180, 100,
-                          display->gammaCorrection(SDT_BG_COLOR));
-    display->tft.drawRect(30, 100, 180, 100,
-                          display->gammaCorrection(SDT_SECONDARY_COLOR));
+    display->fillRect(30, 100, 180, 100, SDT_BG_COLOR);
+    display->drawRect(30, 100, 180, 100, SDT_SECONDARY_COLOR);
 
     // Drawing player name
-    if (strlen(msgBoxHeading) > 6) {
-        display->setFont(SDT_SUBHEADER_FONT);
-    } else {
-        display->setFont(SDT_HEADER_FONT);
-    }
-    display->setTextColor(SDT_PRIMARY_COLOR);
-    display->centerText(msgBoxHeading, 140, 1);
+    display->centerText(
+        msgBoxHeading, 140,
+        (strlen(msgBoxHeading) > 6) ? SDT_SUBHEADER_FONT : SDT_HEADER_FONT, 1,
+        SDT_PRIMARY_COLOR);
 
-    display->setFont(SDT_SUBHEADER_FONT);
-    display->setTextColor(SDT_TEXT_COLOR);
-    display->centerText(msgBoxText, 170, 1);
+    display->centerText(msgBoxText, 170, SDT_SUBHEADER_FONT, 1,
+                        SDT_TEXT_COLOR);
 }
 
 void SkirmishUI::border(uint8_t type, uint16_t color) {
-    display->tft.fillRect(0, 0, 240, 16, display->gammaCorrection(color));
-    display->drawVec(skvec_genericBorder, 0, 16, color);
+    display->fillRect(0, 0, 240, 16, color);
+    display->drawRuns(&skvecRuns_genericBorder, 0, 16, color);
     if (type == BORDER_TYPE_DEFAULT) {
-        display->drawVec(skvec_borderTypeDefault, 0, 16, color);
+        display->drawRuns(&skvecRuns_borderTypeDefault, 0, 16, color);
 
     } else if (BORDER_TYPE_GAME) {
-        display->drawVec(skvec_borderTypeGame, 0, 16, color);
+        display->drawRuns(&skvecRuns_borderTypeGame, 0, 16, color);
         // Drawing dotted bottom line
         int16_t x = -5;
         for (uint8_t i = 0; i < 11; i++) {
-            display->tft.fillRect(x, 258, 20, 3,
-                                  display->gammaCorrection(color));
+            display->fillRect(x, 258, 20, 3, color);
             x += 23;
         }
     }
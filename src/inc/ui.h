@@ -10,6 +10,7 @@ Copyright (C) 2023 Ole Lange
 
 #include <stdint.h>
 
+#include "animation.h"
 #include "bluetooth.h"
 #include "display.h"
 #include "game.h"
@@ -38,9 +39,27 @@ class SkirmishUI {
     char *msgBoxText;
     char *msgBoxHeading;
 
-    void renderStatusOverlay();
+    void renderFrame(bool cleared, bool useStrips);
+    void renderStatusOverlay(bool force);
     void renderMsgBox();
 
+    // Animations, the scene transition wipes the screen from top to
+    // bottom, transitionRow is -1 if no transition is running
+    SkirmishAnimator animator;
+    bool animating = false;
+    Tween transition;
+    int16_t transitionRow = -1;
+
+    bool renderTransition(uint32_t now);
+
+    // What is currently drawn, to redraw the border and the status
+    // overlay only if it changed
+    uint8_t drawnBorderType = 0xff;
+    uint16_t drawnBorderColor = 0;
+    uint8_t drawnBatteryWidth = 0xff;
+    uint16_t drawnBatteryColor = 0;
+    bool drawnBluetoothState = false;
+
     bool bluetoothIsConnected;
     bool prevBluetoothIsConnected;
 
@@ -65,6 +84,7 @@ class SkirmishUI {
 
     void setRenderingRequired();
     void setScene(uint8_t scene);
+    void startAnimation();
 
     void setStandbyColor(uint8_t r, uint8_t g, uint8_t b);
 
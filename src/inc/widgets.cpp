@@ -0,0 +1,387 @@
+/*
+Skirmish ESP32 Firmware
+
+User Interface - Widgets
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include "widgets.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Widget base class constructor
+ *
+ * @param display the display the widget is drawn on
+ */
+SkirmishUIWidget::SkirmishUIWidget(SkirmishDisplay *display) {
+    this->display = display;
+}
+
+/**
+ * Forces a redraw on the next render() call
+ *
+ * @param cleared true if the screen was cleared, so nothing of the widget
+ * is visible anymore
+ */
+void SkirmishUIWidget::invalidate(bool cleared) { dirty = true; }
+
+/**
+ * @return true if the widget has to be redrawn
+ */
+bool SkirmishUIWidget::isDirty() { return dirty; }
+
+/**
+ * Draws the widget if it is dirty
+ *
+ * @return true if the widget was drawn
+ */
+bool SkirmishUIWidget::render() {
+    if (!dirty) return false;
+    dirty = false;
+    draw();
+    return true;
+}
+
+/**
+ * Label constructor
+ *
+ * @param display the display the widget is drawn on
+ * @param x left edge or horizontal center of the text (see align)
+ * @param y cursor y position (baseline for GFX fonts, upper edge otherwise)
+ * @param font font or NULL for the built-in font
+ * @param fontSize size multiplier of the font
+ * @param color text color
+ * @param bgColor color used to clear the previous text
+ * @param align WIDGET_ALIGN_LEFT or WIDGET_ALIGN_CENTER
+ */
+LabelWidget::LabelWidget(SkirmishDisplay *display, int16_t x, int16_t y,
+                         const GFXfont *font, uint8_t fontSize, uint16_t color,
+                         uint16_t bgColor, uint8_t align)
+    : SkirmishUIWidget(display) {
+    this->x = x;
+    this->y = y;
+    this->font = font;
+    this->fontSize = fontSize;
+    this->color = color;
+    this->bgColor = bgColor;
+    this->align = align;
+}
+
+void LabelWidget::invalidate(bool cleared) {
+    dirty = true;
+    if (cleared) drawnW = 0;
+}
+
+/**
+ * Sets the text, texts longer than WIDGET_TEXT_LENGTH - 1 are cut
+ *
+ * @param text the new text
+ */
+void LabelWidget::setText(const char *text) {
+    if (strncmp(this->text, text, WIDGET_TEXT_LENGTH - 1) == 0) return;
+    strncpy(this->text, text, WIDGET_TEXT_LENGTH - 1);
+    this->text[WIDGET_TEXT_LENGTH - 1] = 0;
+    dirty = true;
+}
+
+void LabelWidget::setFont(const GFXfont *font) {
+    if (this->font == font) return;
+    this->font = font;
+    dirty = true;
+}
+
+void LabelWidget::setColor(uint16_t color) {
+    if (this->color == color) return;
+    this->color = color;
+    dirty = true;
+}
+
+void LabelWidget::setPosition(int16_t x, int16_t y) {
+    if (this->x == x && this->y == y) return;
+    this->x = x;
+    this->y = y;
+    dirty = true;
+}
+
+/**
+ * Shows or hides the text, the area of a hidden label is cleared
+ *
+ * @param visible new visibility
+ */
+void LabelWidget::setVisible(bool visible) {
+    if (this->visible == visible) return;
+    this->visible = visible;
+    dirty = true;
+}
+
+void LabelWidget::draw() {
+    // Clearing the previous text
+    if (drawnW > 0) {
+        display->fillRect(drawnX, drawnY, drawnW, drawnH, bgColor);
+        drawnW = 0;
+    }
+
+    if (!visible || text[0] == 0) return;
+
+    int16_t x1, y1;
+    uint16_t w, h;
+    display->textBounds(text, 0, y, font, fontSize, &x1, &y1, &w, &h);
+
+    int16_t left = x;
+    if (align == WIDGET_ALIGN_CENTER) left = x - (w / 2);
+
+    display->drawText(text, left, y, font, fontSize, color);
+
+    drawnX = left + x1;
+    drawnY = y1;
+    drawnW = w;
+    drawnH = h;
+}
+
+/**
+ * Counter constructor
+ *
+ * @param display the display the widget is drawn on
+ * @param x left edge or horizontal center of the text (see align)
+ * @param y cursor y position (baseline for GFX fonts, upper edge otherwise)
+ * @param format printf format string with one integer argument
+ * @param font font or NULL for the built-in font
+ * @param fontSize size multiplier of the font
+ * @param color text color
+ * @param bgColor color used to clear the previous text
+ * @param align WIDGET_ALIGN_LEFT or WIDGET_ALIGN_CENTER
+ */
+CounterWidget::CounterWidget(SkirmishDisplay *display, int16_t x, int16_t y,
+                             const char *format, const GFXfont *font,
+                             uint8_t fontSize, uint16_t color,
+                             uint16_t bgColor, uint8_t align)
+    : LabelWidget(display, x, y, font, fontSize, color, bgColor, align) {
+    this->format = format;
+}
+
+/**
+ * Sets the value, the text is only formatted if the value changed
+ *
+ * @param value the new value
+ */
+void CounterWidget::setValue(int32_t value) {
+    if (hasValue && this->value == value) return;
+    this->value = value;
+    hasValue = true;
+
+    char buffer[WIDGET_TEXT_LENGTH];
+    snprintf(buffer, WIDGET_TEXT_LENGTH, format, value);
+    setText(buffer);
+}
+
+/**
+ * Bar constructor
+ *
+ * @param display the display the widget is drawn on
+ * @param x left edge of the lower end of the first segment
+ * @param y upper edge
+ * @param segments amount of segments
+ * @param segmentWidth lines per segment
+ * @param segmentHeight height of the segments
+ * @param segmentSpace space between two segments
+ * @param slant horizontal offset of the upper end of the segments
+ * @param color color of filled lines
+ * @param bgColor color of empty lines
+ */
+BarWidget::BarWidget(SkirmishDisplay *display, int16_t x, int16_t y,
+                     uint8_t segments, uint8_t segmentWidth,
+                     uint8_t segmentHeight, uint8_t segmentSpace,
+                     uint8_t slant, uint16_t color, uint16_t bgColor)
+    : SkirmishUIWidget(display) {
+    this->x = x;
+    this->y = y;
+    this->segments = segments;
+    this->segmentWidth = segmentWidth;
+    this->segmentHeight = segmentHeight;
+    this->segmentSpace = segmentSpace;
+    this->color = color;
+    this->bgColor = bgColor;
+
+    rowStart = new int16_t[segmentHeight + 1];
+    rowEnd = new int16_t[segmentHeight + 1];
+    for (uint8_t row = 0; row <= segmentHeight; row++) {
+        rowStart[row] = INT16_MAX;
+        rowEnd[row] = INT16_MIN;
+    }
+
+    // Pixels of the line from (slant, 0) to (0, segmentHeight), the same
+    // way Adafruit_GFX::writeLine() draws it. The other lines of the
+    // segment are copies shifted to the right.
+    int16_t x0 = slant, y0 = 0, x1 = 0, y1 = segmentHeight;
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) {
+        int16_t t = x0;
+        x0 = y0;
+        y0 = t;
+        t = x1;
+        x1 = y1;
+        y1 = t;
+    }
+    if (x0 > x1) {
+        int16_t t = x0;
+        x0 = x1;
+        x1 = t;
+        t = y0;
+        y0 = y1;
+        y1 = t;
+    }
+    int16_t dx = x1 - x0;
+    int16_t dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = (y0 < y1) ? 1 : -1;
+    for (; x0 <= x1; x0++) {
+        int16_t px = steep ? y0 : x0;
+        int16_t row = steep ? x0 : y0;
+        rowStart[row] = min(rowStart[row], px);
+        rowEnd[row] = max(rowEnd[row], px);
+        err -= dy;
+        if (err < 0) {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+/**
+ * Sets the fill level of the bar
+ *
+ * @param value current value
+ * @param maxValue value of a completely filled bar
+ */
+void BarWidget::setValue(float value, float maxValue) {
+    if (maxValue <= 0) return;
+    value = constrain(value, 0, maxValue);
+
+    // Rounding up, a bar is only empty if the value is 0
+    uint16_t lines = segments * segmentWidth;
+    uint16_t filled = ceilf(value * lines / maxValue);
+    if (filled == filledLines) return;
+    filledLines = filled;
+    dirty = true;
+}
+
+void BarWidget::invalidate(bool cleared) {
+    drawn = false;
+    dirty = true;
+}
+
+/**
+ * Returns where the filled part of a segment row ends. The lines overlap
+ * if they are flatter than 45 degrees, a pixel shows the color of the
+ * last line drawn over it.
+ *
+ * @param row row of the segment
+ * @param filled amount of filled lines of the segment
+ * @return first x offset (relative to the segment) that is not filled
+ */
+int16_t BarWidget::filledEnd(uint8_t row, uint8_t filled) {
+    if (filled < segmentWidth) return rowStart[row] + filled;
+    return rowEnd[row] + segmentWidth;
+}
+
+void BarWidget::draw() {
+    for (uint8_t j = 0; j < segments; j++) {
+        int16_t segmentX = x + (segmentWidth + segmentSpace) * j;
+        int16_t first = j * segmentWidth;
+        uint8_t filled = constrain(filledLines - first, 0, segmentWidth);
+        uint8_t before = constrain(drawnLines - first, 0, segmentWidth);
+        if (drawn && filled == before) continue;
+
+        for (uint8_t row = 0; row <= segmentHeight; row++) {
+            int16_t end = filledEnd(row, filled);
+            if (!drawn) {
+                // Whole row: filled and empty span
+                int16_t rowW = rowEnd[row] + segmentWidth - end;
+                if (end > rowStart[row]) {
+                    display->fillRect(segmentX + rowStart[row], y + row,
+                                      end - rowStart[row], 1, color);
+                }
+                if (rowW > 0) {
+                    display->fillRect(segmentX + end, y + row, rowW, 1,
+                                      bgColor);
+                }
+                continue;
+            }
+
+            // Only the span between the old and the new fill level
+            int16_t previousEnd = filledEnd(row, before);
+            display->fillRect(segmentX + min(end, previousEnd), y + row,
+                              abs(end - previousEnd), 1,
+                              (filled > before) ? color : bgColor);
+        }
+    }
+
+    drawnLines = filledLines;
+    drawn = true;
+}
+
+/**
+ * Icon constructor
+ *
+ * @param display the display the widget is drawn on
+ * @param x left edge
+ * @param y upper edge
+ * @param bitmap 1-bit bitmap, rows padded to full bytes
+ * @param w width of the bitmap
+ * @param h height of the bitmap
+ * @param color color of the set bits
+ * @param bgColor color of the unset bits
+ */
+IconWidget::IconWidget(SkirmishDisplay *display, int16_t x, int16_t y,
+                       const uint8_t *bitmap, int16_t w, int16_t h,
+                       uint16_t color, uint16_t bgColor)
+    : SkirmishUIWidget(display) {
+    this->x = x;
+    this->y = y;
+    this->bitmap = bitmap;
+    this->w = w;
+    this->h = h;
+    this->color = color;
+    this->bgColor = bgColor;
+}
+
+void IconWidget::setColor(uint16_t color) {
+    if (this->color == color) return;
+    this->color = color;
+    dirty = true;
+}
+
+void IconWidget::draw() {
+    display->fillRect(x, y, w, h, bgColor);
+    display->drawBitmap(x, y, bitmap, w, h, color);
+}
+
+/**
+ * Vector graphic constructor
+ *
+ * @param display the display the widget is drawn on
+ * @param runs the compiled skvec graphic (see skvec_runs.h)
+ * @param x x-axis offset
+ * @param y y-axis offset
+ * @param color color of the graphic
+ */
+VecWidget::VecWidget(SkirmishDisplay *display, const SkvecRuns *runs,
+                     int16_t x, int16_t y, uint16_t color)
+    : SkirmishUIWidget(display) {
+    this->runs = runs;
+    this->x = x;
+    this->y = y;
+    this->color = color;
+}
+
+void VecWidget::setColor(uint16_t color) {
+    if (this->color == color) return;
+    this->color = color;
+    dirty = true;
+}
+
+void VecWidget::draw() { display->drawRuns(runs, x, y, color); }
@@ -0,0 +1,172 @@
+/*
+Skirmish ESP32 Firmware
+
+User Interface - Widgets - Header file
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "display.h"
+
+#define WIDGET_ALIGN_LEFT 0
+#define WIDGET_ALIGN_CENTER 1
+
+#define WIDGET_TEXT_LENGTH 33
+
+/**
+ * Base class of the retained widgets the scenes are built of. A widget
+ * owns a rectangle of the screen and remembers what it has drawn there.
+ * Setting a new value only marks the widget as dirty, render() redraws
+ * it if the value changed or the screen was cleared in between.
+ */
+class SkirmishUIWidget {
+   protected:
+    SkirmishDisplay *display;
+    bool dirty = true;
+
+    virtual void draw() = 0;
+
+   public:
+    SkirmishUIWidget(SkirmishDisplay *display);
+
+    virtual void invalidate(bool cleared);
+    bool isDirty();
+    bool render();
+};
+
+/**
+ * A single line of text. Clears the area of the previous text before the
+ * new one is printed.
+ */
+class LabelWidget : public SkirmishUIWidget {
+   protected:
+    char text[WIDGET_TEXT_LENGTH] = "";
+    int16_t x, y;
+    const GFXfont *font;
+    uint8_t fontSize;
+    uint16_t color;
+    uint16_t bgColor;
+    uint8_t align;
+    bool visible = true;
+
+    // Area covered by the last drawn text, drawnW is 0 if nothing is drawn
+    int16_t drawnX = 0, drawnY = 0;
+    uint16_t drawnW = 0, drawnH = 0;
+
+    void draw();
+
+   public:
+    LabelWidget(SkirmishDisplay *display, int16_t x, int16_t y,
+                const GFXfont *font, uint8_t fontSize, uint16_t color,
+                uint16_t bgColor, uint8_t align = WIDGET_ALIGN_CENTER);
+
+    void invalidate(bool cleared);
+    void setText(const char *text);
+    void setFont(const GFXfont *font);
+    void setColor(uint16_t color);
+    void setPosition(int16_t x, int16_t y);
+    void setVisible(bool visible);
+};
+
+/**
+ * A label showing a number through a printf format string
+ */
+class CounterWidget : public LabelWidget {
+   private:
+    const char *format;
+    int32_t value = 0;
+    bool hasValue = false;
+
+   public:
+    CounterWidget(SkirmishDisplay *display, int16_t x, int16_t y,
+                  const char *format, const GFXfont *font, uint8_t fontSize,
+                  uint16_t color, uint16_t bgColor,
+                  uint8_t align = WIDGET_ALIGN_LEFT);
+
+    void setValue(int32_t value);
+};
+
+/**
+ * A bar of slanted segments, e.g. the health bar. Each segment consists
+ * of segmentWidth lines which are filled from left to right.
+ *
+ * The lines are never drawn one by one: every row of a segment is split
+ * into a filled and an empty span, computed from the pixels of the first
+ * line once. A new value only redraws the spans between the old and the
+ * new fill level.
+ */
+class BarWidget : public SkirmishUIWidget {
+   private:
+    int16_t x, y;
+    uint8_t segments;
+    uint8_t segmentWidth;
+    uint8_t segmentHeight;
+    uint8_t segmentSpace;
+    uint16_t color;
+    uint16_t bgColor;
+
+    // First and last pixel of the first line of a segment per row
+    int16_t *rowStart;
+    int16_t *rowEnd;
+
+    uint16_t filledLines = 0;
+    uint16_t drawnLines = 0;
+    bool drawn = false;
+
+    int16_t filledEnd(uint8_t row, uint8_t filled);
+    void draw();
+
+   public:
+    BarWidget(SkirmishDisplay *display, int16_t x, int16_t y,
+              uint8_t segments, uint8_t segmentWidth, uint8_t segmentHeight,
+              uint8_t segmentSpace, uint8_t slant, uint16_t color,
+              uint16_t bgColor);
+
+    void invalidate(bool cleared);
+    void setValue(float value, float maxValue);
+};
+
+/**
+ * A 1-bit bitmap drawn in a single color
+ */
+class IconWidget : public SkirmishUIWidget {
+   private:
+    int16_t x, y;
+    const uint8_t *bitmap;
+    int16_t w, h;
+    uint16_t color;
+    uint16_t bgColor;
+
+    void draw();
+
+   public:
+    IconWidget(SkirmishDisplay *display, int16_t x, int16_t y,
+               const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color,
+               uint16_t bgColor);
+
+    void setColor(uint16_t color);
+};
+
+/**
+ * A skvec graphic drawn in a single color. Changing the color overdraws
+ * the same shapes, so no clearing is required.
+ */
+class VecWidget : public SkirmishUIWidget {
+   private:
+    const SkvecRuns *runs;
+    int16_t x;
+    int16_t y;
+    uint16_t color;
+
+    void draw();
+
+   public:
+    VecWidget(SkirmishDisplay *display, const SkvecRuns *runs, int16_t x,
+              int16_t y, uint16_t color);
+
+    void setColor(uint16_t color);
+};
@@ -5,24 +5,32 @@ Copyright (C) 2023 Ole Lange
 */
 
 #include <Arduino.h>
-#include <SPIFFS.h>
+#include <inc/assets.h>
+#include <inc/battery.h>
 #include <inc/const.h>
+#include <inc/diagnostics.h>
 #include <inc/hardware_control.h>
+#include <inc/haptics.h>
 #include <inc/hitpoint.h>
 #include <inc/log.h>
+#include <inc/power.h>
+#include <inc/recorder.h>
 #ifndef NO_DISPLAY
 #include <inc/display.h>
 #endif
 #include <inc/bluetooth.h>
 #include <inc/skirmcom.h>
+#include <inc/standby.h>
 #include <inc/ui.h>
 #include <theme.h>
 #ifndef NO_AUDIO
 #include <inc/audio.h>
 #endif
 #include <inc/game.h>
+#include <inc/time.h>
 #ifndef NO_PHASER
 #include <inc/infrared.h>
+#include <inc/trigger.h>
 #endif
 #ifndef NO_HPNOW
 #include <inc/hpnow.h>
@@ -42,26 +50,37 @@ SkirmishUI *userInterface;
 bool previousConnectionState = false;
 
 void setup() {
-    // Wait some time for the hitpoints to init
-    delay(250);
+    // Wait some time for the hitpoints to init, they keep their supply in
+    // standby
+    if (!standbyWasWakeup()) delay(250);
 
     // Initializing all drivers / utils that require an initialisation
     logInit();
     logInfo("Logging initialized. Welcome!");
+#ifdef LOG_BENCHMARK
+    logBenchmark();
+#endif
+    standbyInit();
+    recorderInit();
 
 #ifndef NO_DISPLAY
     display.init();
 #endif
 
     hardwareInit();
+    batteryInit();
+    powerInit();
+#ifndef NO_VIBR_MOTOR
+    hapticsInit();
+#endif
     hitpointInit();
     hitpointSyncTime();
 #ifndef NO_PHASER
     infraredInit();
+    triggerInit();
 #endif
 
-    logInfo("Init: SPIFFS");
-    SPIFFS.begin();
+    assetsInit();
 
 // Initing audio, when the pwr off button is pressed at boot
 // the audio gain will be set to 0 -> silence
@@ -77,7 +96,9 @@ void setup() {
 #endif
 
     game = new Game();
+    standbyRestoreGame(game);
     bluetoothDriver = new SkirmishBluetooth();
+    diagnosticsInit(bluetoothDriver);
 
 #ifndef NO_DISPLAY
     userInterface = new SkirmishUI(&display, bluetoothDriver, game);
@@ -90,16 +111,17 @@ void setup() {
     com->init();
 
     bluetoothDriver->init();
+    standbyAdvertising();
     userInterface->setScene(SCENE_BLE_CONNECT);
 
 #ifndef NO_HPNOW
     hpnowInit();
 #endif
 
-    logInfo("Current Battery Voltage is %d", hardwareReadVBAT());
+    logInfo("Current Battery Voltage is %d", batteryMillivolts());
 
 #ifndef NO_AUDIO
-    audioBegin("/bootup.wav");
+    audioBegin(ASSET_SOUND_BOOTUP, AUDIO_PRIORITY_CUE);
 #endif
 }
 
@@ -107,22 +129,22 @@ uint32_t hwStatusLastSend = 0;
 
 uint32_t hitpointTimesyncLastSend = 0;
 
-uint32_t lastFiredShot = 0;
 uint32_t mnow;
 
+// Set once the app connected, a game restored from standby is kept before
+bool connectedSinceBoot = false;
+
 uint32_t lastReceivedShot = 0;
 uint8_t pid;
 uint16_t sid;
 
 uint8_t hitLocation;
 
-bool triggerPressed = false;
 bool hitpointEvent = false;
 bool hpnowGotHitEvent = false;
 
 void loop() {
-    hardwareLoop();
-
+    uint32_t loopStart = micros();
     mnow = millis();
 
     if (mnow - hitpointTimesyncLastSend > HP_TIMESYNC_SEND_INTERVAL) {
@@ -131,26 +153,40 @@ void loop() {
     }
 
     if (mnow - hwStatusLastSend > HW_STATUS_SEND_INTERVAL) {
-        com->hwStatus(hardwareBatteryPercent());
+        com->hwStatus(batteryPercent());
         hwStatusLastSend = mnow;
     }
 
-    // Turn of the phaser if it was not connected for a while
+    // Upload the flight record of the previous boots once after connecting
+    if (recorderReportPending() && bluetoothDriver->getConnectionState() &&
+        mnow - bluetoothDriver->lastConnectedTime > RECORDER_UPLOAD_DELAY) {
+        com->flightRecord(recorderReport());
+        recorderReportSent();
+    }
+    recorderUpdate();
+
+    // Put the phaser to standby if it was not connected for a while
     if (mnow - bluetoothDriver->lastDisconnectedTime >
             (NOT_CONNECTED_POWER_OFF_TIMEOUT * 60000) &&
         !bluetoothDriver->getConnectionState()) {
-        hardwarePowerOff();
+#ifndef NO_DISPLAY
+        display.sleep();
+#endif
+        standbyEnter();
     }
 
-    // Reset the game if the phaser was not connected for a while
+    // Reset the game if the phaser was not connected for a while. The game
+    // restored after a wakeup is kept until the first connection.
+    if (bluetoothDriver->getConnectionState()) connectedSinceBoot = true;
     if (mnow - bluetoothDriver->lastDisconnectedTime >
             CONNECTION_LOSS_RESET_TIMEOUT &&
-        !bluetoothDriver->getConnectionState()) {
+        !bluetoothDriver->getConnectionState() &&
+        (connectedSinceBoot || !standbyWasWakeup())) {
+        standbyRememberGame(game);
         game->reset();
         userInterface->setScene(SCENE_BLE_CONNECT);
     }
 
-    triggerPressed = hardwareWasTriggerPressed();
     hitpointEvent = hitpointEventTriggered();
 #ifndef NO_HPNOW
     hpnowGotHitEvent = hpnowGotHit();
@@ -158,10 +194,8 @@ void loop() {
 
 #ifndef NO_PHASER
 #ifdef PHASER_DEBUG_SHOOTING
-    if (triggerPressed && mnow - lastFiredShot > 100) {
-        lastFiredShot = mnow;
-        infraredTransmitShot(0xde, 0xadbe);
-    }
+    triggerConfigure(FIRE_MODE_SEMI, 1, 100);
+    if (triggerShotDue(mnow)) infraredTransmitShot(0xde, 0xadbe);
 #endif
 #endif
 
@@ -176,25 +210,40 @@ void loop() {
 #endif
 #endif
 
+#ifndef NO_PHASER
+    // Presses before the game started don't fire when it starts
+    if (!game->isRunning()) triggerCancel();
+#endif
+
     if (game->isRunning()) {
 #ifndef NO_PHASER
-        if (triggerPressed && game->player.canFire() &&
-            mnow - lastFiredShot > game->player.maxShotInterval) {
+        triggerConfigure(game->player.fireMode, game->player.burstLength,
+                         game->player.maxShotInterval);
+        bool shotDue = triggerShotDue(mnow);
+        if (shotDue && !game->player.canFire()) {
+            // Bursts and auto fire stop, e.g. when the ammo runs out
+            triggerCancel();
+            shotDue = false;
+        }
+        if (shotDue) {
             infraredTransmitShot(game->player.pid, game->player.currentSid);
 #ifndef NO_AUDIO
-            audioBegin("/blaster.wav");
+            if (game->player.blasterSynth)
+                audioBeginSynth(&game->player.blasterSynthParams);
+            else
+                audioBegin(ASSET_SOUND_BLASTER);
 #endif
 #ifndef NO_VIBR_MOTOR
-            hardwareVibrate(150);
+            hapticsPlay(HAPTIC_SHOT);
 #endif
             com->shotFired(game->player.currentSid);
+            recorderRecord(RECORD_SHOT, 0, game->player.currentSid);
 
             if (game->player.ammoLimit) {
                 game->player.ammo -= 1;
                 game->player.dataWasUpdated();
             }
 
-            lastFiredShot = mnow;
             game->player.currentSid++;
         }
 #endif
@@ -214,6 +263,7 @@ void loop() {
                 // notify the server.
                 if (pid != game->player.pid) {
                     com->gotHit(pid, sid, hitLocation);
+                    recorderRecord(RECORD_HIT, pid, sid);
                 }
             }
         }
@@ -228,4 +278,22 @@ void loop() {
 
     userInterface->update();
     userInterface->render();
+
+    // Power policy of the current phase, the game counts as counting down
+    // POWER_COUNTDOWN_TIME seconds before it starts
+    uint8_t phase = POWER_PHASE_LOBBY;
+    if (!bluetoothDriver->getConnectionState()) {
+        phase = POWER_PHASE_DISCONNECTED;
+    } else if (game->isRunning()) {
+        phase = POWER_PHASE_RUNNING;
+    } else if (game->startTime != 0 &&
+               game->startTime - getCurrentTS() <= POWER_COUNTDOWN_TIME) {
+        phase = POWER_PHASE_COUNTDOWN;
+    }
+    powerUpdate(phase);
+
+    // Diagnostics are sent last, after the game messages of this pass
+    diagnosticsLatency(DIAG_LATENCY_LOOP, micros() - loopStart);
+    diagnosticsUpdate(millis());
+    powerIdle();
 }
\ No newline at end of file
@@ -8,11 +8,13 @@ Copyright (C) 2023 Ole Lange
 
 #include "fonts/theNeueBlack10pt.h"
 #include "fonts/theNeueBlack18pt.h"
+#include "inc/gamma.h"
 
 // Themeing (SDT -> Skirmish Display Theme)
-#define SDT_BG_COLOR 0x2945
+// Colors are RGB565, gamma corrected at compile time
+#define SDT_BG_COLOR GAMMA(0x2945)
 
-#define SDT_TEXT_COLOR 0xDEFB
+#define SDT_TEXT_COLOR GAMMA(0xDEFB)
 
 #define SDT_HEADER_FONT &TheNeue_Black18pt7b
 #define SDT_HEADER_FONT_SIZE 1
@@ -22,17 +24,17 @@ Copyright (C) 2023 Ole Lange
 #define SDT_TEXT_FONT NULL
 #define SDT_TEXT_FONT_SIZE 2
 
-#define SDT_PRIMARY_COLOR 0xE8EC
+#define SDT_PRIMARY_COLOR GAMMA(0xE8EC)
 #define SDT_PRIMARY_COLOR_RGB 233, 30, 99
 
-#define SDT_SECONDARY_COLOR 0x5ADD
+#define SDT_SECONDARY_COLOR GAMMA(0x5ADD)
 #define SDT_SECONDARY_COLOR_RGB 90, 90, 233
 
-#define SDT_BATTERY_LOW_COLOR 0xF9E4
-#define SDT_BATTERY_MID_COLOR 0xFDE4
-#define SDT_BATTERY_HIGH_COLOR 0x6743
+#define SDT_BATTERY_LOW_COLOR GAMMA(0xF9E4)
+#define SDT_BATTERY_MID_COLOR GAMMA(0xFDE4)
+#define SDT_BATTERY_HIGH_COLOR GAMMA(0x6743)
 
-#define SDT_HEALTH_COLOR 0x6743
-#define SDT_HEALTH_BG_COLOR 0x632C
+#define SDT_HEALTH_COLOR GAMMA(0x6743)
+#define SDT_HEALTH_BG_COLOR GAMMA(0x632C)
 
-#define SDT_GAME_SYMBOL_DISABLED_COLOR 0x0000
+#define SDT_GAME_SYMBOL_DISABLED_COLOR GAMMA(0x0000)
@@ -0,0 +1,300 @@
+/*
+Skirmish ESP32 Firmware
+
+IMA-ADPCM decoder test
+
+Encodes test tones with the encoder of scripts/encode_audio.py (ported
+below), checks that adpcmDecodeBlock() reproduces the encoder's
+reconstruction exactly and benchmarks the decoder (see src/inc/adpcm.cpp).
+
+    pio test -e native -f test_adpcm
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <inc/adpcm.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <chrono>
+
+#define SAMPLE_RATE 24000
+
+// Seconds of audio decoded by the benchmark
+#define BENCHMARK_SECONDS 10
+
+// Tables of the IMA-ADPCM standard
+static const int16_t stepTable[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const int8_t indexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                      -1, -1, -1, -1, 2, 4, 6, 8};
+
+/**
+ * Encoder state of one channel, same as ChannelEncoder in
+ * scripts/encode_audio.py
+ */
+typedef struct {
+    int32_t predictor;
+    int8_t index;
+} ChannelEncoder;
+
+static uint8_t block[ADPCM_MAX_BLOCK_ALIGN];
+static int16_t input[ADPCM_MAX_BLOCK_FRAMES * 2];
+static int16_t expected[ADPCM_MAX_BLOCK_FRAMES * 2];
+static int16_t output[ADPCM_MAX_BLOCK_FRAMES * 2];
+
+/**
+ * Encodes one sample
+ *
+ * @param encoder state of the channel
+ * @param sample the sample
+ * @param [out] decoded the sample the decoder will reconstruct
+ * @return the nibble
+ */
+static uint8_t encodeSample(ChannelEncoder *encoder, int16_t sample,
+                            int16_t *decoded) {
+    int32_t step = stepTable[encoder->index];
+    int32_t diff = sample - encoder->predictor;
+    uint8_t nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    int32_t vpdiff = step >> 3;
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 1;
+        vpdiff += step;
+    }
+
+    if (nibble & 8)
+        encoder->predictor -= vpdiff;
+    else
+        encoder->predictor += vpdiff;
+    if (encoder->predictor > 32767) encoder->predictor = 32767;
+    if (encoder->predictor < -32768) encoder->predictor = -32768;
+
+    encoder->index += indexTable[nibble];
+    if (encoder->index < 0) encoder->index = 0;
+    if (encoder->index > 88) encoder->index = 88;
+
+    *decoded = (int16_t)encoder->predictor;
+    return nibble;
+}
+
+/**
+ * Encodes one block of input, the reconstruction is written to expected
+ * (same as encode_block() in scripts/encode_audio.py)
+ *
+ * @param encoders state of every channel
+ * @param blockAlign size of the block in bytes
+ * @param channels amount of channels
+ */
+static void encodeBlock(ChannelEncoder *encoders, uint16_t blockAlign,
+                        uint8_t channels) {
+    uint16_t frames = adpcmBlockFrames(blockAlign, channels);
+    uint8_t *data = block;
+
+    for (uint8_t c = 0; c < channels; c++) {
+        encoders[c].predictor = input[c];
+        expected[c] = input[c];
+        *data++ = input[c] & 0xff;
+        *data++ = (uint16_t)input[c] >> 8;
+        *data++ = encoders[c].index;
+        *data++ = 0;
+    }
+
+    for (uint16_t frame = 1; frame < frames; frame += 8) {
+        for (uint8_t c = 0; c < channels; c++) {
+            for (uint8_t i = 0; i < 8; i += 2) {
+                uint16_t a = (frame + i) * channels + c;
+                uint16_t b = (frame + i + 1) * channels + c;
+                uint8_t low = encodeSample(&encoders[c], input[a],
+                                           &expected[a]);
+                uint8_t high = encodeSample(&encoders[c], input[b],
+                                            &expected[b]);
+                *data++ = low | (high << 4);
+            }
+        }
+    }
+}
+
+/**
+ * Fills the input with a tone, the channels differ in frequency
+ *
+ * @param frames amount of frames
+ * @param channels amount of channels
+ * @param offset frame offset of the block in the tone
+ */
+static void createTone(uint16_t frames, uint8_t channels, uint32_t offset) {
+    for (uint16_t i = 0; i < frames; i++) {
+        for (uint8_t c = 0; c < channels; c++) {
+            double t = (double)(offset + i) / SAMPLE_RATE;
+            double frequency = 440.0 * (c + 1);
+            input[i * channels + c] =
+                (int16_t)(20000 * sin(2 * M_PI * frequency * t));
+        }
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+/**
+ * Frames per block as written by scripts/encode_audio.py
+ */
+static void testBlockFrames() {
+    TEST_ASSERT_EQUAL_UINT16(505, adpcmBlockFrames(256, 1));
+    TEST_ASSERT_EQUAL_UINT16(505, adpcmBlockFrames(512, 2));
+    TEST_ASSERT_EQUAL_UINT16(ADPCM_MAX_BLOCK_FRAMES,
+                             adpcmBlockFrames(ADPCM_MAX_BLOCK_ALIGN, 2));
+    TEST_ASSERT_EQUAL_UINT16(249, adpcmBlockFrames(128, 1));
+}
+
+/**
+ * Only blocks of whole 8 sample groups that fit into the pcm buffer of
+ * the source (ADPCM_MAX_BLOCK_FRAMES) are accepted
+ */
+static void testBlockAlignValid() {
+    TEST_ASSERT_TRUE(adpcmBlockAlignValid(256, 1));
+    TEST_ASSERT_TRUE(adpcmBlockAlignValid(512, 2));
+    TEST_ASSERT_TRUE(adpcmBlockAlignValid(128, 1));
+    TEST_ASSERT_TRUE(adpcmBlockAlignValid(8, 1));
+    TEST_ASSERT_TRUE(adpcmBlockAlignValid(16, 2));
+
+    // 512 byte mono blocks (sox, ffmpeg) hold 1017 frames
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(512, 1));
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(260, 1));
+
+    // Partial groups of 8 samples
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(5, 1));
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(255, 1));
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(260, 2));
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(12, 2));
+
+    // No data, too large, unsupported channels
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(4, 1));
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(8, 2));
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(0, 1));
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(ADPCM_MAX_BLOCK_ALIGN + 8, 2));
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(256, 0));
+    TEST_ASSERT_FALSE(adpcmBlockAlignValid(256, 3));
+}
+
+/**
+ * Decodes consecutive blocks of a tone and compares them with the
+ * encoder's reconstruction
+ *
+ * @param blockAlign size of a block in bytes
+ * @param channels amount of channels
+ */
+static void checkTone(uint16_t blockAlign, uint8_t channels) {
+    ChannelEncoder encoders[2] = {{0, 0}, {0, 0}};
+    uint16_t frames = adpcmBlockFrames(blockAlign, channels);
+
+    for (uint8_t n = 0; n < 4; n++) {
+        createTone(frames, channels, n * frames);
+        encodeBlock(encoders, blockAlign, channels);
+
+        memset(output, 0, sizeof(output));
+        TEST_ASSERT_EQUAL_UINT16(
+            frames, adpcmDecodeBlock(block, blockAlign, channels, output));
+        TEST_ASSERT_EQUAL_INT16_ARRAY(expected, output, frames * channels);
+
+        // Once the step index settled, the tone is followed closely
+        if (n == 0) continue;
+        for (uint16_t i = 0; i < frames * channels; i++) {
+            TEST_ASSERT_INT_WITHIN(2048, input[i], output[i]);
+        }
+    }
+}
+
+static void testMono() { checkTone(256, 1); }
+
+static void testStereo() { checkTone(512, 2); }
+
+/**
+ * Full scale steps saturate instead of wrapping around
+ */
+static void testSaturation() {
+    ChannelEncoder encoder = {0, 88};
+    uint16_t frames = adpcmBlockFrames(256, 1);
+    for (uint16_t i = 0; i < frames; i++) {
+        input[i] = (i / 16) % 2 ? 32767 : -32768;
+    }
+    encodeBlock(&encoder, 256, 1);
+
+    adpcmDecodeBlock(block, 256, 1, output);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected, output, frames);
+    TEST_ASSERT_EQUAL_INT16(32767, output[16 + 15]);
+    TEST_ASSERT_EQUAL_INT16(-32768, output[32 + 15]);
+}
+
+/**
+ * Decodes BENCHMARK_SECONDS of stereo audio and reports the time per
+ * millisecond of audio (the decoder must stay far below real time)
+ */
+static void testBenchmark() {
+    ChannelEncoder encoders[2] = {{0, 0}, {0, 0}};
+    uint16_t frames = adpcmBlockFrames(512, 2);
+    createTone(frames, 2, 0);
+    encodeBlock(encoders, 512, 2);
+
+    uint32_t blocks = (uint32_t)BENCHMARK_SECONDS * SAMPLE_RATE / frames;
+    uint32_t checksum = 0;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < blocks; i++) {
+        adpcmDecodeBlock(block, 512, 2, output);
+        checksum += (uint16_t)output[i % (frames * 2)];
+    }
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    uint32_t audioMs = blocks * frames * 1000ULL / SAMPLE_RATE;
+    char message[128];
+    snprintf(message, sizeof(message),
+             "ADPCM: decoded %lu ms of stereo audio in %lu us (%lu ns/ms, "
+             "checksum %lx)",
+             (unsigned long)audioMs, (unsigned long)(ns / 1000),
+             (unsigned long)(ns / audioMs), (unsigned long)checksum);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(ns < audioMs * 100000ULL,
+                             "Decoding takes over 10% of real time");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testBlockFrames);
+    RUN_TEST(testBlockAlignValid);
+    RUN_TEST(testMono);
+    RUN_TEST(testStereo);
+    RUN_TEST(testSaturation);
+    RUN_TEST(testBenchmark);
+    return UNITY_END();
+}
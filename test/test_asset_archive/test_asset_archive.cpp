@@ -0,0 +1,227 @@
+/*
+Skirmish ESP32 Firmware
+
+Asset archive reader test
+
+Opens fixture/archive.bin, written by scripts/pack_assets.py from the
+files in fixture/ (test_pack_assets.py keeps it up to date), and damaged
+copies of it (see src/inc/asset_archive.cpp).
+
+    pio test -e native -f test_asset_archive
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <inc/asset_archive.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#define ARCHIVE_MAX_SIZE 256
+
+// Offset of the index table and of an entry's fields
+#define INDEX_START sizeof(AssetArchiveHeader)
+#define ENTRY_OFFSET(i) (INDEX_START + (i) * sizeof(AssetIndexEntry))
+#define ENTRY_LENGTH(i) (ENTRY_OFFSET(i) + 4)
+
+static char fixtureDir[256];
+
+// The packed archive and a copy to damage, 4 byte aligned like the
+// mapped partition
+static uint32_t packedWords[ARCHIVE_MAX_SIZE / 4];
+static uint32_t damagedWords[ARCHIVE_MAX_SIZE / 4];
+static uint8_t *packed = (uint8_t *)packedWords;
+static uint8_t *damaged = (uint8_t *)damagedWords;
+static uint32_t packedSize = 0;
+
+/**
+ * Reads a fixture file
+ *
+ * @param name name of the file in fixture/
+ * @param [out] data the contents
+ * @param size size of data
+ * @return size of the file, -1 if it can't be read
+ */
+static long readFixture(const char *name, uint8_t *data, long size) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", fixtureDir, name);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return -1;
+    long length = (long)fread(data, 1, size, file);
+    fclose(file);
+    return length;
+}
+
+static void putU32(uint8_t *data, uint32_t offset, uint32_t value) {
+    memcpy(data + offset, &value, 4);
+}
+
+static uint8_t openDamaged(uint32_t available, uint16_t *badAsset) {
+    AssetArchive archive;
+    return assetArchiveOpen(&archive, damaged, available, badAsset);
+}
+
+void setUp() { memcpy(damaged, packed, ARCHIVE_MAX_SIZE); }
+
+void tearDown() {}
+
+/**
+ * Every asset reads back as the file it was packed from
+ */
+static void testRead() {
+    static const char *names[] = {"three.bin", "hello.txt", "empty.bin",
+                                  "eight.bin"};
+
+    AssetArchive archive;
+    uint16_t badAsset = 0;
+    TEST_ASSERT_EQUAL_UINT8(
+        ASSET_ARCHIVE_OK,
+        assetArchiveOpen(&archive, packed, packedSize, &badAsset));
+    TEST_ASSERT_EQUAL_UINT16(4, archive.count);
+    TEST_ASSERT_EQUAL_UINT32(packedSize, archive.size);
+
+    for (uint16_t i = 0; i < 4; i++) {
+        uint8_t expected[64];
+        long expectedLength = readFixture(names[i], expected,
+                                          sizeof(expected));
+        TEST_ASSERT_GREATER_OR_EQUAL(0, expectedLength);
+
+        const uint8_t *data = NULL;
+        uint32_t length = 0;
+        TEST_ASSERT_TRUE(assetArchiveGet(&archive, i, &data, &length));
+        TEST_ASSERT_EQUAL_UINT32(expectedLength, length);
+        TEST_ASSERT_EQUAL_UINT32(0, (data - packed) % 4);
+        if (length > 0) TEST_ASSERT_EQUAL_MEMORY(expected, data, length);
+    }
+
+    const uint8_t *data = NULL;
+    uint32_t length = 0;
+    TEST_ASSERT_FALSE(assetArchiveGet(&archive, 4, &data, &length));
+}
+
+/**
+ * The archive may be smaller than the partition, but not larger
+ */
+static void testAvailable() {
+    uint16_t badAsset = 0;
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_OK,
+                            openDamaged(ARCHIVE_MAX_SIZE, &badAsset));
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_BAD_HEADER,
+                            openDamaged(packedSize - 1, &badAsset));
+    TEST_ASSERT_EQUAL_UINT8(
+        ASSET_ARCHIVE_BAD_HEADER,
+        openDamaged(sizeof(AssetArchiveHeader) - 1, &badAsset));
+}
+
+/**
+ * Erased flash, another magic or version and impossible sizes
+ */
+static void testBadHeader() {
+    uint16_t badAsset = 0;
+
+    memset(damaged, 0xff, ARCHIVE_MAX_SIZE);
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_BAD_HEADER,
+                            openDamaged(ARCHIVE_MAX_SIZE, &badAsset));
+
+    setUp();
+    damaged[0] = 'X';
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_BAD_HEADER,
+                            openDamaged(packedSize, &badAsset));
+
+    setUp();
+    damaged[4] = ASSET_ARCHIVE_VERSION + 1;
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_BAD_HEADER,
+                            openDamaged(packedSize, &badAsset));
+
+    setUp();
+    putU32(damaged, 8, sizeof(AssetArchiveHeader) - 1);
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_BAD_HEADER,
+                            openDamaged(packedSize, &badAsset));
+}
+
+/**
+ * The index table must fit into the size of the header
+ */
+static void testBadIndex() {
+    uint16_t badAsset = 0;
+
+    // One entry more than the size holds
+    uint16_t count = (packedSize - INDEX_START) / sizeof(AssetIndexEntry) + 1;
+    memcpy(damaged + 6, &count, 2);
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_BAD_INDEX,
+                            openDamaged(packedSize, &badAsset));
+
+    count = 0xffff;
+    memcpy(damaged + 6, &count, 2);
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_BAD_INDEX,
+                            openDamaged(packedSize, &badAsset));
+
+    // The size only covers the index of the first asset
+    setUp();
+    putU32(damaged, 8, ENTRY_OFFSET(1));
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_BAD_INDEX,
+                            openDamaged(packedSize, &badAsset));
+}
+
+/**
+ * Assets past the end, including offsets where offset + length wraps
+ * around in 32 bit
+ */
+static void testOutOfBounds() {
+    uint16_t badAsset = 0;
+
+    putU32(damaged, ENTRY_LENGTH(3), 9);
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_OUT_OF_BOUNDS,
+                            openDamaged(packedSize, &badAsset));
+    TEST_ASSERT_EQUAL_UINT16(3, badAsset);
+
+    setUp();
+    putU32(damaged, ENTRY_OFFSET(1), packedSize + 1);
+    putU32(damaged, ENTRY_LENGTH(1), 0);
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_OUT_OF_BOUNDS,
+                            openDamaged(packedSize, &badAsset));
+    TEST_ASSERT_EQUAL_UINT16(1, badAsset);
+
+    setUp();
+    putU32(damaged, ENTRY_OFFSET(0), 0xfffffff0);
+    putU32(damaged, ENTRY_LENGTH(0), 0x20);
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_OUT_OF_BOUNDS,
+                            openDamaged(packedSize, &badAsset));
+    TEST_ASSERT_EQUAL_UINT16(0, badAsset);
+
+    setUp();
+    putU32(damaged, ENTRY_OFFSET(2), 0x10);
+    putU32(damaged, ENTRY_LENGTH(2), 0xfffffff8);
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_OUT_OF_BOUNDS,
+                            openDamaged(packedSize, &badAsset));
+    TEST_ASSERT_EQUAL_UINT16(2, badAsset);
+
+    // An empty asset right at the end is fine
+    setUp();
+    putU32(damaged, ENTRY_OFFSET(2), packedSize);
+    TEST_ASSERT_EQUAL_UINT8(ASSET_ARCHIVE_OK,
+                            openDamaged(packedSize, &badAsset));
+}
+
+int main() {
+    // fixture/ is next to this file
+    snprintf(fixtureDir, sizeof(fixtureDir), "%s", __FILE__);
+    char *slash = strrchr(fixtureDir, '/');
+    if (slash != NULL) {
+        strcpy(slash, "/fixture");
+    } else {
+        strcpy(fixtureDir, "fixture");
+    }
+
+    // A missing fixture fails testRead()
+    long size = readFixture("archive.bin", packed, ARCHIVE_MAX_SIZE);
+    packedSize = size > 0 ? size : 0;
+
+    UNITY_BEGIN();
+    RUN_TEST(testRead);
+    RUN_TEST(testAvailable);
+    RUN_TEST(testBadHeader);
+    RUN_TEST(testBadIndex);
+    RUN_TEST(testOutOfBounds);
+    return UNITY_END();
+}
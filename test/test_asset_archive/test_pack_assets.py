@@ -0,0 +1,136 @@
+"""
+Skirmish ESP32 Firmware
+
+Asset packer test
+
+Checks the archive layout written by scripts/pack_assets.py and that
+fixture/archive.bin, which test_asset_archive.cpp reads, is what the
+packer writes for the fixture assets. After changing the packer the
+fixture is rewritten with:
+
+    python test/test_asset_archive/test_pack_assets.py --update
+
+Copyright (C) 2023 Ole Lange
+"""
+
+import os
+import struct
+import sys
+import tempfile
+import unittest
+
+TEST_DIR = os.path.dirname(os.path.abspath(__file__))
+FIXTURE_DIR = os.path.join(TEST_DIR, "fixture")
+sys.path.insert(0, os.path.join(TEST_DIR, "..", "..", "scripts"))
+
+import pack_assets  # noqa: E402
+
+# Same order as the checks in test_asset_archive.cpp
+FIXTURE_ASSETS = ["three.bin", "hello.txt", "empty.bin", "eight.bin"]
+
+
+def fixture_assets():
+    return [("ASSET_TEST_%d" % i, os.path.join(FIXTURE_DIR, name))
+            for i, name in enumerate(FIXTURE_ASSETS)]
+
+
+def read(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+class PackTest(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.archive_path = os.path.join(self.tmp.name, "assets.bin")
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def test_layout(self):
+        assets = fixture_assets()
+        archive = pack_assets.pack(assets, self.archive_path)
+        self.assertEqual(archive, read(self.archive_path))
+
+        magic, version, count, size, reserved = struct.unpack_from(
+            pack_assets.HEADER_FORMAT, archive, 0)
+        self.assertEqual(magic, b"SKAR")
+        self.assertEqual(version, 1)
+        self.assertEqual(count, len(assets))
+        self.assertEqual(size, len(archive))
+        self.assertEqual(reserved, 0)
+
+        index_start = struct.calcsize(pack_assets.HEADER_FORMAT)
+        end = index_start + count * struct.calcsize(pack_assets.INDEX_FORMAT)
+        for i, (_, path) in enumerate(assets):
+            offset, length = struct.unpack_from(
+                pack_assets.INDEX_FORMAT, archive,
+                index_start + i * struct.calcsize(pack_assets.INDEX_FORMAT))
+            content = read(path)
+
+            # Assets follow each other, aligned and zero padded
+            self.assertEqual(offset, pack_assets.align(end))
+            self.assertEqual(offset % pack_assets.ALIGN, 0)
+            self.assertEqual(archive[end:offset], b"\0" * (offset - end))
+            self.assertEqual(length, len(content))
+            self.assertEqual(archive[offset:offset + length], content)
+            end = offset + length
+
+        self.assertEqual(size, pack_assets.align(end))
+
+    def test_empty(self):
+        archive = pack_assets.pack([], self.archive_path)
+        self.assertEqual(archive, struct.pack(pack_assets.HEADER_FORMAT,
+                                              b"SKAR", 1, 0, 16, 0))
+        pack_assets.verify(archive, [])
+
+    def test_verify(self):
+        assets = fixture_assets()
+        archive = pack_assets.pack(assets, self.archive_path)
+        pack_assets.verify(archive, assets)
+
+        # Changed content of the last asset
+        changed = archive[:-1] + b"\0"
+        with self.assertRaises(AssertionError):
+            pack_assets.verify(changed, assets)
+
+        # Length of the first asset past the end of the archive
+        index_start = struct.calcsize(pack_assets.HEADER_FORMAT)
+        offset, _ = struct.unpack_from(pack_assets.INDEX_FORMAT, archive,
+                                       index_start)
+        bounds = bytearray(archive)
+        struct.pack_into(pack_assets.INDEX_FORMAT, bounds, index_start,
+                         offset, len(archive))
+        with self.assertRaises(AssertionError):
+            pack_assets.verify(bytes(bounds), assets)
+
+    def test_fixture_up_to_date(self):
+        archive = pack_assets.pack(fixture_assets(), self.archive_path)
+        self.assertEqual(
+            archive, read(os.path.join(FIXTURE_DIR, "archive.bin")),
+            "fixture/archive.bin is outdated, run this test with --update")
+
+    def test_write_ids(self):
+        header_path = os.path.join(self.tmp.name, "asset_ids.h")
+        assets = [("ASSET_SOUND_A", ""), ("ASSET_SOUND_B", "")]
+        pack_assets.write_ids(assets, header_path)
+
+        with open(header_path) as f:
+            content = f.read()
+        self.assertIn("#define ASSET_SOUND_A 0\n", content)
+        self.assertIn("#define ASSET_SOUND_B 1\n", content)
+        self.assertIn("#define ASSET_COUNT 2\n", content)
+
+        # Unchanged IDs don't touch the file (no rebuild)
+        os.utime(header_path, (0, 0))
+        pack_assets.write_ids(assets, header_path)
+        self.assertEqual(os.path.getmtime(header_path), 0)
+
+
+if __name__ == "__main__":
+    if "--update" in sys.argv:
+        pack_assets.pack(fixture_assets(),
+                         os.path.join(FIXTURE_DIR, "archive.bin"))
+        sys.exit(0)
+    unittest.main()
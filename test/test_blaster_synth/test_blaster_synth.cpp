@@ -0,0 +1,175 @@
+/*
+Skirmish ESP32 Firmware
+
+Blaster sound synthesizer test
+
+Renders every waveform with the default sweep, as steady tones and with
+extreme parameters, and compares the length, peak and RMS level of each
+sound with a reference (see src/inc/blaster_synth.cpp). The levels of
+the steady tones are the analytic ones of a linear fade: full scale / √3
+for the square wave and full scale / 3 for saw and triangle.
+
+    pio test -e native -f test_blaster_synth
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <inc/blaster_synth.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#define SAMPLE_RATE 24000
+#define BLOCK_FRAMES 64
+#define MAX_FRAMES (SAMPLE_RATE / 2)
+
+// Allowed difference to the reference levels
+#define PEAK_TOLERANCE 64
+#define RMS_TOLERANCE 150
+
+/**
+ * A sound and its reference levels
+ */
+typedef struct {
+    const char *name;
+    uint16_t startFreq;
+    uint16_t endFreq;
+    uint16_t duration;
+    uint8_t noise;
+    uint8_t waveform;
+    uint32_t frames;
+    int32_t peak;
+    int32_t rms;
+} Preset;
+
+static const Preset presets[] = {
+    // Default sweep (BlasterSynthParams) with every waveform
+    {"sweep_square", 1800, 200, 180, 40, BLASTER_WAVE_SQUARE, 4320, 32406,
+     16067},
+    {"sweep_saw", 1800, 200, 180, 40, BLASTER_WAVE_SAW, 4320, 31661, 9374},
+    {"sweep_triangle", 1800, 200, 180, 40, BLASTER_WAVE_TRIANGLE, 4320,
+     31206, 9385},
+    // Steady tones without noise
+    {"tone_square", 1000, 1000, 100, 0, BLASTER_WAVE_SQUARE, 2400, 32767,
+     18918},
+    {"tone_saw", 1000, 1000, 100, 0, BLASTER_WAVE_SAW, 2400, 32602, 10922},
+    {"tone_triangle", 1000, 1000, 100, 0, BLASTER_WAVE_TRIANGLE, 2400, 32766,
+     10922},
+    // Rising sweep of noise only
+    {"noise", 400, 3000, 250, 255, BLASTER_WAVE_SQUARE, 6000, 32066, 11000},
+    // Clamped to below nyquist
+    {"above_nyquist", 20000, 20000, 50, 0, BLASTER_WAVE_SAW, 1200, 32736,
+     13052},
+};
+
+#define PRESETS (sizeof(presets) / sizeof(presets[0]))
+
+static int16_t out[MAX_FRAMES * 2];
+
+// Preset run by testPreset()
+static uint8_t preset = 0;
+
+/**
+ * Renders a sound in blocks like the audio task does
+ *
+ * @param p the sound
+ * @param blockFrames frames per block
+ * @return amount of rendered frames
+ */
+static uint32_t render(const Preset *p, uint16_t blockFrames) {
+    BlasterSynthParams params;
+    params.startFreq = p->startFreq;
+    params.endFreq = p->endFreq;
+    params.duration = p->duration;
+    params.noise = p->noise;
+    params.waveform = p->waveform;
+
+    BlasterSynth synth;
+    blasterSynthStart(&synth, &params, SAMPLE_RATE);
+
+    uint32_t frames = 0;
+    uint16_t rendered;
+    do {
+        uint16_t n = blockFrames;
+        if (n > MAX_FRAMES - frames) n = MAX_FRAMES - frames;
+        rendered = blasterSynthRender(&synth, out + frames * 2, n);
+        frames += rendered;
+    } while (rendered == blockFrames && frames < MAX_FRAMES);
+
+    // Ended sounds stay silent
+    int16_t after[2];
+    TEST_ASSERT_EQUAL_UINT16(0, blasterSynthRender(&synth, after, 1));
+    return frames;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+/**
+ * Renders the next preset and compares it with its reference
+ */
+static void testPreset() {
+    const Preset *p = &presets[preset];
+    uint32_t frames = render(p, BLOCK_FRAMES);
+    TEST_ASSERT_EQUAL_UINT32(p->frames, frames);
+
+    int32_t peak = 0;
+    double sum = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        TEST_ASSERT_EQUAL_INT16(out[i * 2], out[i * 2 + 1]);
+        int32_t sample = out[i * 2];
+        if (abs(sample) > peak) peak = abs(sample);
+        sum += (double)sample * sample;
+    }
+    int32_t rms = (int32_t)sqrt(sum / frames);
+
+    char message[128];
+    snprintf(message, sizeof(message), "%s: peak %ld, rms %ld", p->name,
+             (long)peak, (long)rms);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_INT_WITHIN_MESSAGE(PEAK_TOLERANCE, p->peak, peak, message);
+    TEST_ASSERT_INT_WITHIN_MESSAGE(RMS_TOLERANCE, p->rms, rms, message);
+
+    // Faded out: the last tenth stays below a tenth of full scale
+    for (uint32_t i = frames - frames / 10; i < frames; i++) {
+        TEST_ASSERT_INT_WITHIN(3277, 0, out[i * 2]);
+    }
+}
+
+/**
+ * The block size doesn't change the sound
+ */
+static void testBlockSize() {
+    static int16_t reference[MAX_FRAMES * 2];
+    const Preset *p = &presets[0];
+    uint32_t frames = render(p, MAX_FRAMES);
+    memcpy(reference, out, frames * 4);
+
+    uint16_t sizes[] = {1, 7, BLOCK_FRAMES};
+    for (uint8_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_UINT32(frames, render(p, sizes[i]));
+        TEST_ASSERT_EQUAL_INT16_ARRAY(reference, out, frames * 2);
+    }
+}
+
+/**
+ * A zero duration still renders one frame
+ */
+static void testZeroDuration() {
+    Preset p = presets[0];
+    p.duration = 0;
+    TEST_ASSERT_EQUAL_UINT32(1, render(&p, BLOCK_FRAMES));
+}
+
+int main() {
+    UNITY_BEGIN();
+    for (preset = 0; preset < PRESETS; preset++) {
+        UnityDefaultTestRun(testPreset, presets[preset].name, __LINE__);
+    }
+    RUN_TEST(testBlockSize);
+    RUN_TEST(testZeroDuration);
+    return UNITY_END();
+}
@@ -0,0 +1,140 @@
+/*
+Skirmish ESP32 Firmware
+
+Golden image test
+
+Runs the UI through the states of the display emulator (see
+src/emulator/main.cpp) and compares the screenshot of every state with
+its golden image in golden/. The screenshots of the run are written to
+output/, a state whose golden image is missing is recorded from its
+screenshot and fails, so the new image gets reviewed and committed. CI
+uploads output/ and the recorded images of a failed run as an artifact.
+After intended changes of the UI the golden images are replaced with:
+
+    SKIRMISH_UPDATE_GOLDEN=1 pio test -e emulator
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <emulator/emulator.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unity.h>
+
+static char testDir[256];
+static char outputDir[256];
+static char goldenDir[256];
+static bool update = false;
+
+// State run by testState()
+static uint8_t state = 0;
+
+/**
+ * Reads a whole file
+ *
+ * @param path path of the file
+ * @param [out] size size of the file
+ * @return the contents (free() them) or NULL if it can't be read
+ */
+static uint8_t *readFile(const char *path, long *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = (uint8_t *)malloc(*size > 0 ? *size : 1);
+    if (data != NULL && fread(data, 1, *size, file) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+/**
+ * Writes a whole file
+ *
+ * @param path path of the file
+ * @param data the contents
+ * @param size size of the contents
+ * @return true if it was written
+ */
+static bool writeFile(const char *path, const uint8_t *data, long size) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return false;
+    bool written = fwrite(data, 1, size, file) == (size_t)size;
+    return fclose(file) == 0 && written;
+}
+
+/**
+ * Runs the next state and compares its screenshot with the golden image
+ */
+static void testState() {
+    const char *name = emulatorStateName(state);
+    emulatorRunState(state, outputDir);
+
+    char actualPath[512];
+    char goldenPath[512];
+    snprintf(actualPath, sizeof(actualPath), "%s/%s.png", outputDir, name);
+    snprintf(goldenPath, sizeof(goldenPath), "%s/%s.png", goldenDir, name);
+
+    long actualSize = 0;
+    uint8_t *actual = readFile(actualPath, &actualSize);
+    TEST_ASSERT_NOT_NULL_MESSAGE(actual, "The screenshot wasn't written");
+
+    long goldenSize = 0;
+    uint8_t *golden = readFile(goldenPath, &goldenSize);
+    if (golden == NULL || update) {
+        bool written = writeFile(goldenPath, actual, actualSize);
+        free(actual);
+        free(golden);
+        TEST_ASSERT_TRUE_MESSAGE(written, "Couldn't write the golden image");
+        if (!update) {
+            TEST_FAIL_MESSAGE("No golden image, it was recorded from this "
+                              "run: review and commit it");
+        }
+        return;
+    }
+
+    // The emulator writes uncompressed PNGs, equal pixels give equal files
+    bool equal = actualSize == goldenSize &&
+                 memcmp(actual, golden, actualSize) == 0;
+    free(actual);
+    free(golden);
+
+    char message[1100];
+    snprintf(message, sizeof(message), "%s differs from %s", actualPath,
+             goldenPath);
+    TEST_ASSERT_TRUE_MESSAGE(equal, message);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main() {
+    // golden/ and output/ are next to this file
+    snprintf(testDir, sizeof(testDir), "%s", __FILE__);
+    char *slash = strrchr(testDir, '/');
+    if (slash != NULL) {
+        *slash = 0;
+    } else {
+        strcpy(testDir, ".");
+    }
+    snprintf(outputDir, sizeof(outputDir), "%s/output", testDir);
+    snprintf(goldenDir, sizeof(goldenDir), "%s/golden", testDir);
+    mkdir(outputDir, 0755);
+    mkdir(goldenDir, 0755);
+    update = getenv("SKIRMISH_UPDATE_GOLDEN") != NULL;
+
+    emulatorInit();
+
+    UNITY_BEGIN();
+    for (state = 0; state < emulatorStateCount(); state++) {
+        UnityDefaultTestRun(testState, emulatorStateName(state), __LINE__);
+    }
+    return UNITY_END();
+}
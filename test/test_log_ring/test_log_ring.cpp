@@ -0,0 +1,192 @@
+/*
+Skirmish ESP32 Firmware
+
+Log ring buffer test
+
+Checks the encoding and formatting of log records and the reserve, commit
+and read logic of the ring (see src/inc/log_ring.cpp): wrap-around of the
+ring and of its indices, dropped records of a full ring, records
+committed out of order and the truncation of strings.
+
+    pio test -e native -f test_log_ring
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <inc/log_ring.h>
+#include <string.h>
+#include <unity.h>
+
+#define RING_SIZE 64
+
+static uint8_t ringData[RING_SIZE] __attribute__((aligned(4)));
+static LogRing ring;
+
+void setUp() { logRingInit(&ring, ringData, RING_SIZE); }
+
+void tearDown() {}
+
+/**
+ * Encodes a log call into a record
+ *
+ * @param [out] record LOG_RECORD_MAX bytes
+ * @param format format string
+ * @return length of the record
+ */
+static uint16_t encode(uint8_t *record, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    uint16_t length = logRingEncode(record, 1, 1234, format, args);
+    va_end(args);
+    return length;
+}
+
+/**
+ * Reads the next record and compares its text
+ *
+ * @param expected expected text
+ */
+static void assertNext(const char *expected) {
+    uint8_t record[LOG_RECORD_MAX] __attribute__((aligned(4)));
+    char line[256];
+    TEST_ASSERT_NOT_EQUAL(0, logRingRead(&ring, record));
+    logRingFormat(record, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING(expected, line);
+}
+
+/**
+ * The header holds the length, level and time, the arguments are packed
+ * and formatted like printf would
+ */
+static void testEncode() {
+    uint8_t record[LOG_RECORD_MAX] __attribute__((aligned(4)));
+    char line[256];
+    uint16_t length = encode(record, "%d%% %s %5.2f %llx %c", -42, "ok", 2.5,
+                             0x123456789abULL, 'x');
+
+    TEST_ASSERT_EQUAL_UINT16(0, length % 4);
+    TEST_ASSERT_EQUAL_UINT16(length, record[0] | (record[1] << 8));
+    TEST_ASSERT_EQUAL_UINT8(1, record[2]);
+    uint32_t time;
+    memcpy(&time, &record[4], 4);
+    TEST_ASSERT_EQUAL_UINT32(1234, time);
+
+    logRingFormat(record, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("-42% ok  2.50 123456789ab x", line);
+
+    // The output is cut to the buffer
+    logRingFormat(record, line, 8);
+    TEST_ASSERT_EQUAL_STRING("-42% ok", line);
+}
+
+/**
+ * Strings are stored with at most LOG_STRING_MAX characters
+ */
+static void testStringTruncation() {
+    uint8_t record[LOG_RECORD_MAX] __attribute__((aligned(4)));
+    char line[256];
+    const char *text = "0123456789abcdefghijklmnopqrstuvwxyzABCDEF";
+
+    encode(record, "[%s] [%s]", text, (const char *)NULL);
+    logRingFormat(record, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("[0123456789abcdefghijklmnopqrstuv] [(null)]",
+                             line);
+
+    // Strings that don't fit into the record are cut, the arguments after
+    // them are left out
+    encode(record, "%s%s%s%s%s%d", text, text, text, text, text, 7);
+    logRingFormat(record, line, sizeof(line));
+    TEST_ASSERT_EQUAL_UINT16(LOG_RECORD_MAX - LOG_HEADER_SIZE - 4,
+                             strlen(line) - 1);
+    TEST_ASSERT_EQUAL_INT('0', line[strlen(line) - 1]);
+}
+
+/**
+ * Records wrap around the end of the ring and the indices wrap around at
+ * 2^32
+ */
+static void testWrapAround() {
+    uint8_t record[LOG_RECORD_MAX] __attribute__((aligned(4)));
+    char expected[32];
+
+    ring.writeIndex = 0xffffff00;
+    ring.readIndex = 0xffffff00;
+    for (uint32_t i = 0; i < 100; i++) {
+        // Records of different lengths end at different offsets
+        if (i % 3 == 0) {
+            encode(record, "%u", i);
+            snprintf(expected, sizeof(expected), "%u", i);
+        } else {
+            encode(record, "%u %s", i, i % 3 == 1 ? "a" : "bcdefgh");
+            snprintf(expected, sizeof(expected), "%u %s", i,
+                     i % 3 == 1 ? "a" : "bcdefgh");
+        }
+        TEST_ASSERT_TRUE(logRingWrite(&ring, record));
+        assertNext(expected);
+    }
+    TEST_ASSERT_TRUE(ring.writeIndex < 0xffffff00);
+    TEST_ASSERT_EQUAL_UINT32(ring.writeIndex, ring.readIndex);
+    TEST_ASSERT_EQUAL_UINT16(0, logRingRead(&ring, record));
+}
+
+/**
+ * Records that don't fit are dropped and counted, the ring takes records
+ * again once it was read
+ */
+static void testFull() {
+    uint8_t record[LOG_RECORD_MAX] __attribute__((aligned(4)));
+    uint16_t length = encode(record, "%u", 1);
+    uint32_t fitting = RING_SIZE / length;
+
+    for (uint32_t i = 0; i < fitting; i++) {
+        TEST_ASSERT_TRUE(logRingWrite(&ring, record));
+    }
+    TEST_ASSERT_FALSE(logRingWrite(&ring, record));
+    TEST_ASSERT_FALSE(logRingWrite(&ring, record));
+    TEST_ASSERT_EQUAL_UINT32(2, logRingTakeDropped(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, logRingTakeDropped(&ring));
+
+    assertNext("1");
+    TEST_ASSERT_TRUE(logRingWrite(&ring, record));
+    for (uint32_t i = 0; i < fitting; i++) assertNext("1");
+    TEST_ASSERT_EQUAL_UINT16(0, logRingRead(&ring, record));
+}
+
+/**
+ * A record committed before the one reserved ahead of it is held back
+ * until that one is committed
+ */
+static void testOutOfOrderCommit() {
+    uint8_t first[LOG_RECORD_MAX] __attribute__((aligned(4)));
+    uint8_t second[LOG_RECORD_MAX] __attribute__((aligned(4)));
+    uint8_t record[LOG_RECORD_MAX] __attribute__((aligned(4)));
+
+    // The second record wraps around the end of the ring
+    ring.writeIndex = RING_SIZE - 24;
+    ring.readIndex = RING_SIZE - 24;
+
+    uint16_t firstLength = encode(first, "first %u", 1);
+    uint16_t secondLength = encode(second, "second %s", "two");
+    int64_t firstIndex = logRingReserve(&ring, firstLength);
+    int64_t secondIndex = logRingReserve(&ring, secondLength);
+    TEST_ASSERT_TRUE(firstIndex >= 0);
+    TEST_ASSERT_TRUE(secondIndex == firstIndex + firstLength);
+
+    logRingCommit(&ring, secondIndex, second);
+    TEST_ASSERT_EQUAL_UINT16(0, logRingRead(&ring, record));
+
+    logRingCommit(&ring, firstIndex, first);
+    assertNext("first 1");
+    assertNext("second two");
+    TEST_ASSERT_EQUAL_UINT16(0, logRingRead(&ring, record));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testEncode);
+    RUN_TEST(testStringTruncation);
+    RUN_TEST(testWrapAround);
+    RUN_TEST(testFull);
+    RUN_TEST(testOutOfOrderCommit);
+    return UNITY_END();
+}
@@ -0,0 +1,136 @@
+/*
+Skirmish ESP32 Firmware
+
+Audio mixer test
+
+Checks the Q1.15 gain conversion, the scaling and summing of the voices
+and the saturation of the mixed samples (see src/inc/mixer.cpp).
+
+    pio test -e native -f test_mixer
+
+Copyright (C) 2023 Ole Lange
+*/
+
+#include <inc/mixer.h>
+#include <unity.h>
+
+#define SAMPLES 6
+
+static const int16_t ramp[SAMPLES] = {0, 1000, -1000, 16384, -16384, 32767};
+static const int16_t full[SAMPLES] = {32767, 32767,  32767,
+                                      -32768, -32768, -32768};
+
+void setUp() {}
+
+void tearDown() {}
+
+/**
+ * Float gains are clamped to [0-1] and truncated to Q1.15
+ */
+static void testGain() {
+    TEST_ASSERT_EQUAL_UINT16(0, mixerGain(-0.5f));
+    TEST_ASSERT_EQUAL_UINT16(0, mixerGain(0));
+    TEST_ASSERT_EQUAL_UINT16(0x2000, mixerGain(0.25f));
+    TEST_ASSERT_EQUAL_UINT16(0x4000, mixerGain(0.5f));
+    TEST_ASSERT_EQUAL_UINT16(0x7fff, mixerGain(0.99999f));
+    TEST_ASSERT_EQUAL_UINT16(MIXER_GAIN_UNITY, mixerGain(1));
+    TEST_ASSERT_EQUAL_UINT16(MIXER_GAIN_UNITY, mixerGain(2.5f));
+}
+
+/**
+ * One voice at unity gain is copied as is, at gain 0 it's silent
+ */
+static void testUnityAndMute() {
+    const int16_t *voices[] = {ramp};
+    uint16_t gains[] = {MIXER_GAIN_UNITY};
+    int16_t out[SAMPLES];
+
+    mixerMixBlock(out, voices, gains, 1, SAMPLES);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(ramp, out, SAMPLES);
+
+    gains[0] = 0;
+    mixerMixBlock(out, voices, gains, 1, SAMPLES);
+    const int16_t silence[SAMPLES] = {0};
+    TEST_ASSERT_EQUAL_INT16_ARRAY(silence, out, SAMPLES);
+}
+
+/**
+ * Q1.15 gains scale with an arithmetic shift (rounding towards -inf)
+ */
+static void testQ15Gain() {
+    const int16_t *voices[] = {ramp};
+    uint16_t gains[] = {0x4000};  // 0.5
+    int16_t out[SAMPLES];
+
+    mixerMixBlock(out, voices, gains, 1, SAMPLES);
+    const int16_t half[SAMPLES] = {0, 500, -500, 8192, -8192, 16383};
+    TEST_ASSERT_EQUAL_INT16_ARRAY(half, out, SAMPLES);
+
+    gains[0] = 0x0001;  // Smallest gain, everything but -1 rounds away
+    mixerMixBlock(out, voices, gains, 1, SAMPLES);
+    const int16_t smallest[SAMPLES] = {0, 0, -1, 0, -1, 0};
+    TEST_ASSERT_EQUAL_INT16_ARRAY(smallest, out, SAMPLES);
+}
+
+/**
+ * The sum is saturated to 16 bit instead of wrapping around
+ */
+static void testSaturation() {
+    const int16_t *voices[] = {full, full};
+    uint16_t gains[] = {MIXER_GAIN_UNITY, MIXER_GAIN_UNITY};
+    int16_t out[SAMPLES];
+
+    mixerMixBlock(out, voices, gains, 2, SAMPLES);
+    const int16_t clipped[SAMPLES] = {32767,  32767,  32767,
+                                      -32768, -32768, -32768};
+    TEST_ASSERT_EQUAL_INT16_ARRAY(clipped, out, SAMPLES);
+
+    const int16_t *mixed[] = {ramp, full};
+    mixerMixBlock(out, mixed, gains, 2, SAMPLES);
+    const int16_t partly[SAMPLES] = {32767,  32767,  31767,
+                                     -16384, -32768, -1};
+    TEST_ASSERT_EQUAL_INT16_ARRAY(partly, out, SAMPLES);
+
+    // Only the sum is saturated, not the partial sums
+    const int16_t high[] = {32767};
+    const int16_t low[] = {-32768};
+    const int16_t *cancel[] = {high, high, low, low};
+    uint16_t four[] = {MIXER_GAIN_UNITY, MIXER_GAIN_UNITY, MIXER_GAIN_UNITY,
+                       MIXER_GAIN_UNITY};
+    mixerMixBlock(out, cancel, four, 4, 1);
+    TEST_ASSERT_EQUAL_INT16(-2, out[0]);
+}
+
+/**
+ * Only the first voiceCount voices are mixed
+ */
+static void testVoiceCount() {
+    const int16_t one[SAMPLES] = {100, 100, 100, 100, 100, 100};
+    const int16_t *voices[] = {one, one, one, one};
+    uint16_t gains[] = {MIXER_GAIN_UNITY, MIXER_GAIN_UNITY,
+                        MIXER_GAIN_UNITY, MIXER_GAIN_UNITY};
+    int16_t out[SAMPLES];
+
+    for (uint8_t count = 0; count <= 4; count++) {
+        mixerMixBlock(out, voices, gains, count, SAMPLES);
+        for (uint8_t i = 0; i < SAMPLES; i++) {
+            TEST_ASSERT_EQUAL_INT16(100 * count, out[i]);
+        }
+    }
+
+    // The samples argument limits the block as well
+    out[SAMPLES - 1] = 1234;
+    mixerMixBlock(out, voices, gains, 4, SAMPLES - 1);
+    TEST_ASSERT_EQUAL_INT16(400, out[SAMPLES - 2]);
+    TEST_ASSERT_EQUAL_INT16(1234, out[SAMPLES - 1]);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testGain);
+    RUN_TEST(testUnityAndMute);
+    RUN_TEST(testQ15Gain);
+    RUN_TEST(testSaturation);
+    RUN_TEST(testVoiceCount);
+    return UNITY_END();
+}